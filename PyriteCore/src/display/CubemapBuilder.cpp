@@ -1 +1,129 @@
 #include "CubemapBuilder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <format>
+
+#include "engine/Engine.h"
+#include "engine/directxlib.h"
+#include "display/GpuMemory.h"
+#include "display/UpdateScheduler.h"
+
+namespace pyr
+{
+
+	Cubemap CubemapBuilder::MakeCubemapFromTexturesLOD(std::span<const pyr::Texture> textures, size_t mips, bool bDepthOnly /* = false */)
+	{
+		// -- Ensure texture count 
+		UINT mipCount = static_cast<UINT>(mips);
+		assert(textures.size() == mipCount * 6); 
+		
+		// -- Ensure main texture is squared
+		assert(textures[0].getWidth() == textures[0].getHeight());
+		auto width = static_cast<UINT>(textures[0].getWidth());
+
+		// -- Describe the texture cubemap
+		D3D11_TEXTURE2D_DESC textureDesc{};
+		textureDesc.Width = width;
+		textureDesc.Height = width;
+		textureDesc.MipLevels = static_cast<UINT>(mipCount);
+		textureDesc.ArraySize = 6;
+		textureDesc.Format = bDepthOnly ? DXGI_FORMAT_R32_FLOAT : DXGI_FORMAT_R32G32B32A32_FLOAT;
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.Usage = D3D11_USAGE_DEFAULT;
+		textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		textureDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+		textureDesc.CPUAccessFlags = 0;
+		
+		// -- Create the result texture
+		ID3D11Texture2D* cubeTexture = nullptr;
+		DXTry(Engine::d3ddevice().CreateTexture2D(&textureDesc, nullptr, &cubeTexture), "Failed to create a texture 2D");
+		
+		// -- For each face
+		for (UINT faceID = 0; faceID  < 6; ++faceID) {
+			
+			// -- For each mip level
+			for (UINT mipLevel = 0; mipLevel < mipCount; mipLevel++)
+			{
+				UINT subresource = D3D11CalcSubresource(mipLevel, faceID, mipCount);
+				size_t texID = mipLevel * 6 + faceID;
+				ID3D11Resource* faceTexture = textures[texID].getRawResource();
+				// ERROR : Sometimes, this call will assert and break during IBL. You can continue, but note that the
+				//		   the produced map will be missing mips and stuff... i have not found anything that could be causing an issue yet.
+				//		    It's quite hard to debug...
+				Engine::d3dcontext().CopySubresourceRegion(cubeTexture, subresource, 0, 0, 0, faceTexture, 0, nullptr);
+			}
+		}
+
+		// -- Describe the SRV
+		D3D11_SHADER_RESOURCE_VIEW_DESC SMViewDesc = {};
+		SMViewDesc.Format = textureDesc.Format;
+		SMViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+		SMViewDesc.TextureCube.MipLevels = static_cast<UINT>(mipCount);
+		SMViewDesc.TextureCube.MostDetailedMip = 0;
+
+		ID3D11ShaderResourceView* shaderResourceView = nullptr;
+		DXTry(Engine::d3ddevice().CreateShaderResourceView(cubeTexture, &SMViewDesc, &shaderResourceView), "Could not create a srv");
+
+		GpuMemory::Track(cubeTexture, GpuMemory::Category::Cubemap, std::format("Built cubemap {}x{}", textureDesc.Width, textureDesc.Height));
+		return Cubemap(cubeTexture, shaderResourceView);
+	}
+
+	CubemapCapture::CubemapCapture(uint32_t resolution, uint32_t mipCount, face_renderer_t renderer, float priority)
+		: m_resolution(std::max(1U, resolution))
+		, m_mipCount(std::max(1U, mipCount))
+		, m_renderer(std::move(renderer))
+		, m_priority(priority)
+	{
+	}
+
+	void CubemapCapture::restart()
+	{
+		if (m_faces.empty())
+		{
+			m_faces.reserve(m_mipCount * 6);
+			for (uint32_t mipLevel = 0; mipLevel < m_mipCount; mipLevel++)
+			{
+				const uint32_t faceResolution = std::max(1U, m_resolution >> mipLevel);
+				for (uint32_t face = 0; face < 6; face++)
+					m_faces.emplace_back(faceResolution, faceResolution, FrameBuffer::COLOR_0);
+			}
+		}
+
+		m_capturedFaces.assign(m_faces.size(), false);
+		m_bRunning = true;
+	}
+
+	std::optional<Cubemap> CubemapCapture::tick()
+	{
+		if (!m_bRunning) return std::nullopt;
+
+		std::vector<UpdateScheduler::Update> updates;
+		for (uint32_t faceIndex = 0; faceIndex < m_faces.size(); faceIndex++)
+		{
+			if (m_capturedFaces[faceIndex]) continue;
+			updates.push_back(UpdateScheduler::Update{
+				.key = UpdateScheduler::MakeKey(this, faceIndex),
+				.priority = m_priority,
+				.run = [this, faceIndex] {
+					m_faces[faceIndex].bind();
+					m_renderer(faceIndex % 6, faceIndex / 6);
+					m_faces[faceIndex].unbind();
+					m_capturedFaces[faceIndex] = true;
+				},
+			});
+		}
+		UpdateScheduler::get().schedule(updates);
+
+		if (std::ranges::find(m_capturedFaces, false) != m_capturedFaces.end())
+			return std::nullopt;
+
+		m_bRunning = false;
+		std::vector<Texture> textures;
+		textures.reserve(m_faces.size());
+		for (const FrameBuffer& face : m_faces)
+			textures.push_back(face.getTargetAsTexture(FrameBuffer::COLOR_0));
+		return CubemapBuilder::MakeCubemapFromTexturesLOD(textures, m_mipCount);
+	}
+
+}
@@ -5,6 +5,8 @@
 #include "display/FrameBuffer.h"
 
 #include <filesystem>
+#include <functional>
+#include <optional>
 #include <vector>
 #include <array>
 
@@ -17,6 +19,9 @@ namespace pyr
 
 	public:
 
+		// textures holds the 6 faces of the first mip, then the 6 faces of the second...
+		static Cubemap MakeCubemapFromTexturesLOD(std::span<const pyr::Texture> textures, size_t mipCount, bool bDepthOnly = false);
+
 		template<size_t mipCount>
 		static Cubemap MakeCubemapFromTexturesLOD(std::span<const pyr::Texture> textures, bool bDepthOnly = false);
 
@@ -29,58 +34,37 @@ namespace pyr
 	template<size_t M>
 	inline Cubemap CubemapBuilder::MakeCubemapFromTexturesLOD(std::span<const pyr::Texture> textures, bool bDepthOnly /* = false */)
 	{
-		// -- Ensure texture count 
-		UINT mipCount = M;
-		assert(textures.size() == mipCount * 6); 
-		
-		// -- Ensure main texture is squared
-		assert(textures[0].getWidth() == textures[0].getHeight());
-		auto width = static_cast<UINT>(textures[0].getWidth());
-
-		// -- Describe the texture cubemap
-		D3D11_TEXTURE2D_DESC textureDesc{};
-		textureDesc.Width = width;
-		textureDesc.Height = width;
-		textureDesc.MipLevels = static_cast<UINT>(mipCount);
-		textureDesc.ArraySize = 6;
-		textureDesc.Format = bDepthOnly ? DXGI_FORMAT_R32_FLOAT : DXGI_FORMAT_R32G32B32A32_FLOAT;
-		textureDesc.SampleDesc.Count = 1;
-		textureDesc.Usage = D3D11_USAGE_DEFAULT;
-		textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-		textureDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
-		textureDesc.CPUAccessFlags = 0;
-		
-		// -- Create the result texture
-		ID3D11Texture2D* cubeTexture = nullptr;
-		DXTry(Engine::d3ddevice().CreateTexture2D(&textureDesc, nullptr, &cubeTexture), "Failed to create a texture 2D");
-		
-		// -- For each face
-		for (UINT faceID = 0; faceID  < 6; ++faceID) {
-			
-			// -- For each mip level
-			for (UINT mipLevel = 0; mipLevel < mipCount; mipLevel++)
-			{
-				UINT subresource = D3D11CalcSubresource(mipLevel, faceID, mipCount);
-				size_t texID = mipLevel * 6 + faceID;
-				ID3D11Resource* faceTexture = textures[texID].getRawResource();
-				// ERROR : Sometimes, this call will assert and break during IBL. You can continue, but note that the
-				//		   the produced map will be missing mips and stuff... i have not found anything that could be causing an issue yet.
-				//		    It's quite hard to debug...
-				Engine::d3dcontext().CopySubresourceRegion(cubeTexture, subresource, 0, 0, 0, faceTexture, 0, nullptr);
-			}
-		}
+		return CubemapBuilder::MakeCubemapFromTexturesLOD(textures, M, bDepthOnly);
+	}
 
-		// -- Describe the SRV
-		D3D11_SHADER_RESOURCE_VIEW_DESC SMViewDesc = {};
-		SMViewDesc.Format = textureDesc.Format;
-		SMViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
-		SMViewDesc.TextureCube.MipLevels = static_cast<UINT>(mipCount);
-		SMViewDesc.TextureCube.MostDetailedMip = 0;
+	// Captures the faces of a cubemap over several frames through the UpdateScheduler, every face of every mip is a separate update.
+	// The cubemap is assembled with CubemapBuilder once every face was rendered.
+	class CubemapCapture
+	{
+	public:
 
-		ID3D11ShaderResourceView* shaderResourceView = nullptr;
-		DXTry(Engine::d3ddevice().CreateShaderResourceView(cubeTexture, &SMViewDesc, &shaderResourceView), "Could not create a srv");
+		// Must fill the bound framebuffer with the given face (+x, -x, +y, -y, +z, -z) of the given mip
+		using face_renderer_t = std::function<void(uint32_t face, uint32_t mipLevel)>;
 
-		return Cubemap(cubeTexture, shaderResourceView);
-	}
+		CubemapCapture() = default;
+		CubemapCapture(uint32_t resolution, uint32_t mipCount, face_renderer_t renderer, float priority = .5F);
+
+		// Forgets the faces captured so far and starts over
+		void restart();
+		// Call once per frame while running, returns the cubemap on the frame its last face was captured
+		std::optional<Cubemap> tick();
+
+		bool isRunning() const { return m_bRunning; }
+
+	private:
+		uint32_t m_resolution = 0;
+		uint32_t m_mipCount = 1;
+		face_renderer_t m_renderer;
+		float m_priority = .5F;
+
+		std::vector<FrameBuffer> m_faces; // mip major, like MakeCubemapFromTexturesLOD expects
+		std::vector<bool> m_capturedFaces;
+		bool m_bRunning = false;
+	};
 
 }
\ No newline at end of file
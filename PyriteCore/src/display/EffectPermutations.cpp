@@ -0,0 +1,48 @@
+#include "EffectPermutations.h"
+
+#include <algorithm>
+
+namespace pyr
+{
+
+	EffectPermutations::EffectPermutations(GraphicalResourceRegistry& registry, std::wstring path, std::vector<std::string> axes)
+		: m_registry(&registry)
+		, m_path(std::move(path))
+		, m_axes(std::move(axes))
+	{
+		PYR_ASSERT(m_axes.size() <= MAX_AXES, "Too many effect permutation axes");
+		m_permutations.resize(size_t{ 1 } << m_axes.size(), nullptr);
+	}
+
+	Effect* EffectPermutations::add(mask_t mask, const InputLayout& layout)
+	{
+		PYR_ASSERT(mask < m_permutations.size(), "Effect permutation mask has bits past the last axis");
+		Effect*& permutation = m_permutations[mask];
+		if (!permutation)
+			permutation = m_registry->loadEffect(m_path, layout, getDefines(mask));
+		return permutation;
+	}
+
+	void EffectPermutations::addAll(const InputLayout& layout)
+	{
+		for (mask_t mask = 0; mask < m_permutations.size(); mask++)
+			add(mask, layout);
+	}
+
+	EffectPermutations::mask_t EffectPermutations::getMask(std::string_view axis) const
+	{
+		auto it = std::ranges::find(m_axes, axis);
+		PYR_ASSERT(it != m_axes.end(), "Unknown effect permutation axis");
+		return mask_t{ 1 } << std::distance(m_axes.begin(), it);
+	}
+
+	std::vector<Effect::define_t> EffectPermutations::getDefines(mask_t mask) const
+	{
+		std::vector<Effect::define_t> defines;
+		for (size_t i = 0; i < m_axes.size(); i++)
+			if (mask & (mask_t{ 1 } << i))
+				defines.push_back(Effect::define_t{ .name = m_axes[i], .value = "1" });
+		return defines;
+	}
+
+}
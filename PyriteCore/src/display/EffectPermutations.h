@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "display/GraphicalResource.h"
+#include "utils/Debug.h"
+
+namespace pyr
+{
+
+// The variants of an effect, selected at draw time with a bitmask of its axes:
+//
+//   EffectPermutations picker{ m_registry, L"editor/shaders/picker.fx", { "USE_MESH", "USE_BILLBOARDS" } };
+//   picker.add(picker.getMask("USE_MESH"), meshLayout);
+//   picker.get(picker.getMask("USE_MESH"))->bind();
+//
+// Each axis is a define, set to 1 in the permutations that have its bit and left undefined in the others.
+// Permutations are requested up front rather than on first use: their compilations are all posted to the WorkerPool at once
+// and run in parallel, warm starts read every one of them from the ShaderCache.
+//
+// Effects are owned by the registry, which must outlive the permutations.
+class EffectPermutations
+{
+public:
+
+    using mask_t = uint32_t;
+
+    static constexpr size_t MAX_AXES = 8; // each axis doubles the number of permutations
+
+    EffectPermutations(GraphicalResourceRegistry& registry, std::wstring path, std::vector<std::string> axes);
+
+    // Not every combination of axes has to make sense for the effect, only the ones added are compiled
+    Effect* add(mask_t mask, const InputLayout& layout);
+    void addAll(const InputLayout& layout);
+
+    Effect* get(mask_t mask) const
+    {
+        PYR_ASSERT(mask < m_permutations.size() && m_permutations[mask], "Effect permutation was not added");
+        return m_permutations[mask];
+    }
+
+    mask_t getMask(std::string_view axis) const;
+    std::vector<Effect::define_t> getDefines(mask_t mask) const;
+
+private:
+
+    GraphicalResourceRegistry* m_registry;
+    std::wstring m_path;
+    std::vector<std::string> m_axes;
+    std::vector<Effect*> m_permutations; // indexed by mask, nullptr until added
+};
+
+}
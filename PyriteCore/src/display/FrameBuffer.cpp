@@ -1,7 +1,9 @@
 ﻿#include "FrameBuffer.h"
 
 #include <algorithm>
+#include <format>
 
+#include "GpuMemory.h"
 #include "GraphicalResource.h"
 #include "RenderProfiles.h"
 #include "Shader.h"
@@ -41,6 +43,7 @@ FrameBuffer::FrameBuffer(unsigned int width, unsigned int height, target_t targe
 	renderTextureDesc.BindFlags = D3D10_BIND_RENDER_TARGET | D3D10_BIND_SHADER_RESOURCE;
 	DXTry(device.CreateTexture2D(&renderTextureDesc, NULL, &renderTexture), "Could not create a texture for a framebuffer");
 	m_textures.push_back(renderTexture);
+	GpuMemory::Track(renderTexture, GpuMemory::Category::FrameBuffer, std::format("Framebuffer color {}x{}", m_width, m_height));
 
 	D3D11_RENDER_TARGET_VIEW_DESC rtDesc;
 	rtDesc.Format = renderTextureDesc.Format;
@@ -75,6 +78,7 @@ FrameBuffer::FrameBuffer(unsigned int width, unsigned int height, target_t targe
 	ID3D11Texture2D *depthTexture;
 	DXTry(device.CreateTexture2D(&depthTextureDesc, NULL, &depthTexture), "Could not create a depth texture for a framebuffer");
 	m_textures.push_back(depthTexture);
+	GpuMemory::Track(depthTexture, GpuMemory::Category::FrameBuffer, std::format("Framebuffer depth {}x{}", m_width, m_height));
 
 	D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
 	ZeroMemory(&depthStencilViewDesc, sizeof(depthStencilViewDesc));
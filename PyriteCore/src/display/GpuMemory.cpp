@@ -0,0 +1,119 @@
+#include "GpuMemory.h"
+
+#include <algorithm>
+
+#include "engine/Directxlib.h"
+
+namespace pyr
+{
+
+	static size_t BitsPerPixel(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		case DXGI_FORMAT_R32G32B32A32_UINT:
+			return 128;
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+			return 96;
+		case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+		case DXGI_FORMAT_R32G32_FLOAT:
+			return 64;
+		case DXGI_FORMAT_R8G8_UNORM:
+		case DXGI_FORMAT_R16_FLOAT:
+		case DXGI_FORMAT_R16_UNORM:
+			return 16;
+		case DXGI_FORMAT_R8_UNORM:
+		case DXGI_FORMAT_A8_UNORM:
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC5_UNORM:
+		case DXGI_FORMAT_BC5_SNORM:
+		case DXGI_FORMAT_BC6H_UF16:
+		case DXGI_FORMAT_BC6H_SF16:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return 8;
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_UNORM:
+		case DXGI_FORMAT_BC4_SNORM:
+			return 4;
+		default:
+			return 32; // < r32 and every 8 bits per channel rgba format
+		}
+	}
+
+	size_t GpuMemory::EstimateByteSize(ID3D11Resource* resource)
+	{
+		ID3D11Texture2D* texture2D = nullptr;
+		if (!resource || FAILED(resource->QueryInterface<ID3D11Texture2D>(&texture2D)))
+			return 0;
+
+		D3D11_TEXTURE2D_DESC desc;
+		texture2D->GetDesc(&desc);
+		DXRelease(texture2D);
+
+		const size_t bitsPerPixel = BitsPerPixel(desc.Format);
+		size_t byteSize = 0;
+		for (UINT mip = 0; mip < desc.MipLevels; mip++)
+		{
+			const size_t width = std::max<size_t>(1, desc.Width >> mip);
+			const size_t height = std::max<size_t>(1, desc.Height >> mip);
+			byteSize += width * height * bitsPerPixel / 8;
+		}
+		return byteSize * desc.ArraySize * desc.SampleDesc.Count;
+	}
+
+	void GpuMemory::Track(ID3D11Resource* resource, Category category, std::string name)
+	{
+		if (!resource) return;
+		Untrack(resource);
+
+		const size_t byteSize = EstimateByteSize(resource);
+		s_allocations[resource] = Allocation{ .category = category, .name = std::move(name), .byteSize = byteSize };
+		s_categoryBytes[static_cast<size_t>(category)] += byteSize;
+		s_totalBytes += byteSize;
+	}
+
+	void GpuMemory::Untrack(ID3D11Resource* resource)
+	{
+		auto it = s_allocations.find(resource);
+		if (it == s_allocations.end()) return;
+
+		s_categoryBytes[static_cast<size_t>(it->second.category)] -= it->second.byteSize;
+		s_totalBytes -= it->second.byteSize;
+		s_allocations.erase(it);
+	}
+
+	std::vector<GpuMemory::Allocation> GpuMemory::GetTopConsumers(size_t count)
+	{
+		std::vector<Allocation> allocations;
+		allocations.reserve(s_allocations.size());
+		for (const auto& [_, allocation] : s_allocations)
+			allocations.push_back(allocation);
+
+		count = std::min(count, allocations.size());
+		std::ranges::partial_sort(allocations, allocations.begin() + count, std::ranges::greater{}, &Allocation::byteSize);
+		allocations.resize(count);
+		return allocations;
+	}
+
+	const char* GpuMemory::GetCategoryName(Category category)
+	{
+		switch (category)
+		{
+		case Category::Texture:      return "Texture";
+		case Category::Cubemap:      return "Cubemap";
+		case Category::TextureArray: return "Texture array";
+		case Category::FrameBuffer:  return "Framebuffer";
+		default:                     return "Unknown";
+		}
+	}
+
+}
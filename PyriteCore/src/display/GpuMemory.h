@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ID3D11Resource;
+
+namespace pyr
+{
+
+// Accounts for the GPU memory of the resources created by the engine, sizes are estimated from the resources descriptions.
+// Resources are tracked from their creation to their release, which is done by the resource types themselves
+// (Texture::releaseRawTexture, TextureArray, FrameBuffer...).
+class GpuMemory
+{
+public:
+
+    enum class Category : uint8_t
+    {
+        Texture,      // < loaded from files, see TextureCache
+        Cubemap,
+        TextureArray,
+        FrameBuffer,
+        __COUNT
+    };
+
+    struct Allocation
+    {
+        Category category;
+        std::string name;
+        size_t byteSize = 0;
+    };
+
+    static void Track(ID3D11Resource* resource, Category category, std::string name);
+    static void Untrack(ID3D11Resource* resource);
+
+    static size_t GetTotalBytes() { return s_totalBytes; }
+    static size_t GetTotalBytes(Category category) { return s_categoryBytes[static_cast<size_t>(category)]; }
+    // Biggest allocations first
+    static std::vector<Allocation> GetTopConsumers(size_t count);
+
+    static size_t EstimateByteSize(ID3D11Resource* resource);
+    static const char* GetCategoryName(Category category);
+
+private:
+
+    static inline std::unordered_map<ID3D11Resource*, Allocation> s_allocations;
+    static inline std::array<size_t, static_cast<size_t>(Category::__COUNT)> s_categoryBytes{};
+    static inline size_t s_totalBytes = 0;
+};
+
+}
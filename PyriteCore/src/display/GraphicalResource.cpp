@@ -4,33 +4,10 @@
 #include "utils/Logger.h"
 #include "utils/StringUtils.h"
 
-#include <utility>
 #include <algorithm>
-
-template<>
-struct std::hash<pyr::Effect::define_t>
-{
-    std::size_t operator()(const pyr::Effect::define_t& s) const noexcept
-    {
-        std::size_t h1 = std::hash<std::string>{}(s.name);
-        std::size_t h2 = std::hash<std::string>{}(s.value);
-        return h1 ^ (h2 << 1);
-    }
-};
-
-template<>
-struct std::hash<std::vector<pyr::Effect::define_t>>
-{
-    std::size_t operator()(const std::vector<pyr::Effect::define_t>& vec) const noexcept
-    {
-        std::size_t seed = vec.size();
-        for (const pyr::Effect::define_t& def : vec) {
-            seed ^= std::hash<pyr::Effect::define_t>{}(def)+0x9e3779b9 + (seed << 6) + (seed >> 2);
-        }
-        return seed;
-    }
-};
-
+#include <string>
+#include <tuple>
+#include <utility>
 
 namespace pyr
 {
@@ -61,27 +38,25 @@ void GraphicalResourceRegistry::swap(GraphicalResourceRegistry& other) noexcept
 
 GraphicalResourceRegistry::~GraphicalResourceRegistry()
 {
-  for (auto &[_, texture] : m_texturesCache) {
-    texture.m_resource->Release();
-    texture.m_texture->Release();
-  }
   for (auto& texture : m_ownedTextures) {
       //texture.m_resource->Release();
       //texture.m_texture->Release(); // < causes a memory leak, todo fix
   }
   for (auto &[_, cubemap] : m_cubemapsCache) {
-    cubemap.m_resource->Release();
-    cubemap.m_texture->Release();
+    cubemap.releaseRawCubemap();
   }
 
-  // meshes are released on deletion
+  // textures and meshes are released on deletion
 }
 
-Texture GraphicalResourceRegistry::loadTexture(const filepath &path, bool bGenerateMips /* = true */)
+Texture GraphicalResourceRegistry::loadTexture(const filepath &path, bool bGenerateMips /* = true */, const ImageDecoder::DecodedImage *decoded /* = nullptr */)
 {
   if (m_texturesCache.contains(path))
-    return m_texturesCache[path];
-  return m_texturesCache[path] = TextureManager::loadTexture(path, bGenerateMips);
+    return m_texturesCache[path]->texture;
+  // Raw copies of the texture are handed out, it can't be evicted nor downgraded by the cache anymore
+  TextureCache::Handle& handle = m_texturesCache[path] = TextureCache::get().acquire(path, bGenerateMips, decoded);
+  TextureCache::get().pin(handle);
+  return handle->texture;
 }
 
 void GraphicalResourceRegistry::keepHandleToTexture(Texture texture)
@@ -101,12 +76,26 @@ Cubemap GraphicalResourceRegistry::loadCubemap(const filepath &path)
   return m_cubemapsCache[path] = TextureManager::loadCubemap(path);
 }
 
+// The path followed by the defines sorted by name, the same permutation always gets the same key whatever the define order
+static std::string MakeEffectKey(const GraphicalResourceRegistry::filepath& path, const std::vector<Effect::define_t>& defines)
+{
+  std::vector<const Effect::define_t*> sortedDefines;
+  for (const Effect::define_t& define : defines)
+    sortedDefines.push_back(&define);
+  std::ranges::sort(sortedDefines, [](const Effect::define_t* a, const Effect::define_t* b) { return std::tie(a->name, a->value) < std::tie(b->name, b->value); });
+
+  std::string key = widestring2string(path);
+  for (const Effect::define_t* define : sortedDefines)
+    key += '\0' + define->name + '=' + define->value;
+  return key;
+}
+
 Effect* GraphicalResourceRegistry::loadEffect(const filepath& path, const InputLayout& layout, const std::vector<Effect::define_t>& defines /* = {} */)
 {
-  size_t effectHash = std::hash<filepath>{}(path) ^ std::hash<std::vector<pyr::Effect::define_t>>{}(defines);
-  if (m_effects.contains(effectHash))
-    return &*m_effects[effectHash].first;
-  return &*(m_effects[effectHash] = { ShaderManager::makeEffect(path, layout, defines), layout }).first;
+  const std::string key = MakeEffectKey(path, defines);
+  if (auto it = m_effects.find(key); it != m_effects.end())
+    return &*it->second.first;
+  return &*(m_effects[key] = { ShaderManager::makeEffect(path, layout, defines), layout }).first;
 }
 
 }
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "Texture.h"
+#include "TextureCache.h"
 #include "Shader.h"
 #include "InputLayout.h"
 
@@ -32,7 +33,7 @@ public:
   GraphicalResourceRegistry(GraphicalResourceRegistry &&) noexcept;
   GraphicalResourceRegistry &operator=(GraphicalResourceRegistry &&) noexcept;
 
-  Texture loadTexture(const filepath &path, bool bGenerateMips = true);
+  Texture loadTexture(const filepath &path, bool bGenerateMips = true, const ImageDecoder::DecodedImage *decoded = nullptr);
   void keepHandleToTexture(Texture texture);
   void keepHandleToCubemap(Cubemap cubemap);
   Cubemap loadCubemap(const filepath &path);
@@ -41,11 +42,11 @@ public:
   void swap(GraphicalResourceRegistry& other) noexcept;
 
 private:
-  map<filepath, Texture> m_texturesCache;
+  map<filepath, TextureCache::Handle> m_texturesCache; // textures are shared with the other registries through the TextureCache
   map<filepath, Cubemap> m_cubemapsCache;
   vector<Texture> m_ownedTextures;
   vector<Cubemap> m_ownedCubemaps;
-  map<size_t, std::pair<std::shared_ptr<Effect>, InputLayout>> m_effects;
+  map<std::string, std::pair<std::shared_ptr<Effect>, InputLayout>> m_effects; // see MakeEffectKey
 };
 
 }
\ No newline at end of file
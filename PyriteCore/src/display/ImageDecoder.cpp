@@ -0,0 +1,390 @@
+#include "ImageDecoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <execution>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+#include <emmintrin.h>
+#include <stbi/stb_image.h>
+
+#include "utils/Clock.h"
+#include "utils/StringUtils.h"
+
+namespace pyr
+{
+
+	struct HDRFile
+	{
+		std::unique_ptr<uint8_t[]> bytes;
+		size_t size = 0;
+		size_t width = 0, height = 0;
+		std::vector<size_t> scanlineOffsets;
+	};
+
+	static size_t GetBytesPerPixel(ImageDecoder::HDRFormat format)
+	{
+		switch (format)
+		{
+		case ImageDecoder::HDRFormat::RGBA32F: return 16;
+		case ImageDecoder::HDRFormat::RGBA16F: return 8;
+		default:                               return 4;
+		}
+	}
+
+	static DXGI_FORMAT ToDXGIFormat(ImageDecoder::HDRFormat format)
+	{
+		switch (format)
+		{
+		case ImageDecoder::HDRFormat::RGBA32F: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		case ImageDecoder::HDRFormat::RGBA16F: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+		default:                               return DXGI_FORMAT_R9G9B9E5_SHAREDEXP;
+		}
+	}
+
+	static bool ReadWholeFile(const std::filesystem::path& path, HDRFile& file)
+	{
+		std::error_code error;
+		file.size = static_cast<size_t>(std::filesystem::file_size(path, error));
+		if (error) return false;
+
+		std::ifstream stream{ path, std::ios::binary };
+		file.bytes = std::make_unique_for_overwrite<uint8_t[]>(file.size);
+		return static_cast<bool>(stream.read(reinterpret_cast<char*>(file.bytes.get()), file.size));
+	}
+
+	// Text header terminated by an empty line, followed by the resolution line. Returns the offset of the first scanline.
+	static bool ParseHeader(const HDRFile& file, size_t& offset, size_t& width, size_t& height)
+	{
+		const char* text = reinterpret_cast<const char*>(file.bytes.get());
+		auto readLine = [&](std::string& line)
+		{
+			const char* end = static_cast<const char*>(std::memchr(text + offset, '\n', file.size - offset));
+			if (!end) return false;
+			line.assign(text + offset, end);
+			offset = end - text + 1;
+			return true;
+		};
+
+		std::string line;
+		offset = 0;
+		if (!readLine(line) || !line.starts_with("#?")) return false;
+		while (true)
+		{
+			if (!readLine(line)) return false;
+			if (line.empty()) break;
+			if (line.starts_with("FORMAT=") && line != "FORMAT=32-bit_rle_rgbe") return false;
+		}
+
+		// Only the standard orientation is handled, stb_image does not support the others either
+		if (!readLine(line)) return false;
+		std::istringstream resolution{ line };
+		std::string yAxis, xAxis;
+		resolution >> yAxis >> height >> xAxis >> width;
+		return resolution && yAxis == "-Y" && xAxis == "+X" && width > 0 && height > 0;
+	}
+
+	// Scanlines don't store their size, so finding where each begins takes a pass over the run lengths.
+	// This also validates the whole file, decoding can't fail afterwards.
+	static bool LocateScanlines(HDRFile& file, size_t offset)
+	{
+		// The "new RLE" encoding is only used for widths in this range
+		if (file.width < 8 || file.width > 0x7FFF) return false;
+
+		const uint8_t* bytes = file.bytes.get();
+		file.scanlineOffsets.resize(file.height);
+		for (size_t y = 0; y < file.height; y++)
+		{
+			if (offset + 4 > file.size || bytes[offset] != 2 || bytes[offset + 1] != 2 || ((bytes[offset + 2] << 8) | bytes[offset + 3]) != file.width)
+				return false;
+			file.scanlineOffsets[y] = offset;
+			offset += 4;
+
+			for (int channel = 0; channel < 4; channel++)
+			{
+				for (size_t x = 0; x < file.width; )
+				{
+					if (offset >= file.size) return false;
+					const uint8_t count = bytes[offset++];
+					const bool bRun = count > 128;
+					const size_t length = bRun ? count - 128 : count;
+					if (length == 0 || x + length > file.width) return false;
+					offset += bRun ? 1 : length;
+					x += length;
+				}
+			}
+			if (offset > file.size) return false;
+		}
+		return true;
+	}
+
+	// Each channel of a scanline is run length encoded on its own, they are decoded to planes of planeStride bytes
+	static void DecodeScanline(const uint8_t* source, size_t width, size_t planeStride, uint8_t* planes)
+	{
+		source += 4;
+		for (int channel = 0; channel < 4; channel++)
+		{
+			uint8_t* plane = planes + channel * planeStride;
+			for (size_t x = 0; x < width; )
+			{
+				const uint8_t count = *source++;
+				if (count > 128)
+				{
+					std::memset(plane + x, *source++, count - 128);
+					x += count - 128;
+				}
+				else
+				{
+					std::memcpy(plane + x, source, count);
+					source += count;
+					x += count;
+				}
+			}
+		}
+	}
+
+	static __m128i Load4Bytes(const uint8_t* bytes)
+	{
+		int32_t packed;
+		std::memcpy(&packed, bytes, sizeof(packed));
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+	}
+
+	// Texels are mantissa * 2^(exponent - 136), a 0 exponent means black. Scales are built from the exponent bits directly.
+	static void RGBEToFloats(__m128i r, __m128i g, __m128i b, __m128i e, __m128& rf, __m128& gf, __m128& bf)
+	{
+		const __m128i bNormal = _mm_cmpgt_epi32(e, _mm_set1_epi32(9)); // smaller scales are float denormals, as good as black
+		const __m128 scale = _mm_castsi128_ps(_mm_and_si128(_mm_slli_epi32(_mm_sub_epi32(e, _mm_set1_epi32(9)), 23), bNormal));
+		rf = _mm_mul_ps(_mm_cvtepi32_ps(r), scale);
+		gf = _mm_mul_ps(_mm_cvtepi32_ps(g), scale);
+		bf = _mm_mul_ps(_mm_cvtepi32_ps(b), scale);
+	}
+
+	// Positive and normal values only (RGBEToFloats never produces denormals), one half per 32 bits lane.
+	// Float denormals are avoided on purpose, operations producing them are an order of magnitude slower.
+	static __m128i FloatsToHalves(__m128 values)
+	{
+		const __m128 clamped = _mm_min_ps(values, _mm_set1_ps(65504.F));
+		// Normal halves: rebias the exponent and round the mantissa from 23 to 10 bits
+		const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_castps_si128(clamped), _mm_set1_epi32(0x1000 - ((127 - 15) << 23))), 13);
+		// Denormal halves are multiples of 2^-24
+		const __m128i denormal = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(16777216.F)));
+		const __m128i bDenormal = _mm_castps_si128(_mm_cmplt_ps(clamped, _mm_set1_ps(1.F / 16384.F)));
+		return _mm_or_si128(_mm_and_si128(bDenormal, denormal), _mm_andnot_si128(bDenormal, normal));
+	}
+
+	static uint32_t FloatsToRGB9E5(float r, float g, float b)
+	{
+		constexpr float MAX_VALUE = 511.F / 512.F * 65536.F;
+		r = std::clamp(r, 0.F, MAX_VALUE);
+		g = std::clamp(g, 0.F, MAX_VALUE);
+		b = std::clamp(b, 0.F, MAX_VALUE);
+		const float largest = std::max({ r, g, b });
+		if (largest <= 0) return 0;
+
+		int exponent = std::max(-16, static_cast<int>(std::floor(std::log2(largest)))) + 1 + 15;
+		float denominator = std::ldexp(1.F, exponent - 15 - 9);
+		if (std::floor(largest / denominator + .5F) >= 512.F)
+		{
+			denominator *= 2.F;
+			exponent++;
+		}
+		const auto mantissa = [denominator](float value) { return static_cast<uint32_t>(std::floor(value / denominator + .5F)); };
+		return mantissa(r) | (mantissa(g) << 9) | (mantissa(b) << 18) | (static_cast<uint32_t>(exponent) << 27);
+	}
+
+	// Converts 4 texels read from the scanline planes, writes 4 * GetBytesPerPixel(format) bytes
+	static void ConvertTexels(const uint8_t* planes, size_t planeStride, size_t x, ImageDecoder::HDRFormat format, uint8_t* destination)
+	{
+		const __m128i r = Load4Bytes(planes + x);
+		const __m128i g = Load4Bytes(planes + planeStride + x);
+		const __m128i b = Load4Bytes(planes + planeStride * 2 + x);
+		const __m128i e = Load4Bytes(planes + planeStride * 3 + x);
+
+		switch (format)
+		{
+		case ImageDecoder::HDRFormat::RGB9E5:
+		{
+			// mantissa * 2^(e - 136) == (mantissa << 1) * 2^((e - 113) - 15 - 9), the mantissas are kept as is when the exponent
+			// fits in 5 bits. Smaller exponents are clamped to 0 and the mantissas scaled down instead, black texels included.
+			const __m128i exponent = _mm_sub_epi32(e, _mm_set1_epi32(113));
+			if (_mm_movemask_epi8(_mm_cmpgt_epi32(exponent, _mm_set1_epi32(31))) == 0)
+			{
+				const __m128i bNegative = _mm_cmplt_epi32(exponent, _mm_setzero_si128());
+				const __m128i bTooSmall = _mm_cmplt_epi32(exponent, _mm_set1_epi32(-30));
+				const __m128i underflow = _mm_or_si128(_mm_andnot_si128(bTooSmall, _mm_and_si128(bNegative, exponent)), _mm_and_si128(bTooSmall, _mm_set1_epi32(-30)));
+				const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(underflow, _mm_set1_epi32(127)), 23));
+				const auto mantissa = [scale](__m128i m) { return _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_slli_epi32(m, 1)), scale)); };
+
+				__m128i packed = _mm_or_si128(mantissa(r), _mm_slli_epi32(mantissa(g), 9));
+				packed = _mm_or_si128(packed, _mm_slli_epi32(mantissa(b), 18));
+				packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_andnot_si128(bNegative, exponent), 27));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination), packed);
+			}
+			else
+			{
+				// Brighter than RGB9E5 can hold, rare enough to go through the reference conversion
+				__m128 rf, gf, bf;
+				RGBEToFloats(r, g, b, e, rf, gf, bf);
+				alignas(16) float reds[4], greens[4], blues[4];
+				_mm_store_ps(reds, rf);
+				_mm_store_ps(greens, gf);
+				_mm_store_ps(blues, bf);
+				uint32_t packed[4];
+				for (int i = 0; i < 4; i++)
+					packed[i] = FloatsToRGB9E5(reds[i], greens[i], blues[i]);
+				std::memcpy(destination, packed, sizeof(packed));
+			}
+			break;
+		}
+		case ImageDecoder::HDRFormat::RGBA16F:
+		{
+			__m128 rf, gf, bf;
+			RGBEToFloats(r, g, b, e, rf, gf, bf);
+			const __m128i rg = _mm_or_si128(FloatsToHalves(rf), _mm_slli_epi32(FloatsToHalves(gf), 16));
+			const __m128i ba = _mm_or_si128(FloatsToHalves(bf), _mm_set1_epi32(0x3C00 << 16)); // alpha = 1
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_unpacklo_epi32(rg, ba));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 16), _mm_unpackhi_epi32(rg, ba));
+			break;
+		}
+		case ImageDecoder::HDRFormat::RGBA32F:
+		{
+			__m128 rf, gf, bf, af = _mm_set1_ps(1.F);
+			RGBEToFloats(r, g, b, e, rf, gf, bf);
+			_MM_TRANSPOSE4_PS(rf, gf, bf, af);
+			float* floats = reinterpret_cast<float*>(destination);
+			_mm_storeu_ps(floats, rf);
+			_mm_storeu_ps(floats + 4, gf);
+			_mm_storeu_ps(floats + 8, bf);
+			_mm_storeu_ps(floats + 12, af);
+			break;
+		}
+		}
+	}
+
+	std::optional<ImageDecoder::DecodedImage> ImageDecoder::DecodeHDR(const std::filesystem::path& path, HDRFormat format)
+	{
+		HDRFile file;
+		size_t offset;
+		if (!ReadWholeFile(path, file) || !ParseHeader(file, offset, file.width, file.height) || !LocateScanlines(file, offset))
+			return std::nullopt;
+
+		DecodedImage image;
+		image.width = file.width;
+		image.height = file.height;
+		image.format = ToDXGIFormat(format);
+		image.bytesPerPixel = GetBytesPerPixel(format);
+		image.pixels.reset(new uint8_t[image.getRowPitch() * image.height]);
+
+		// Planes are padded so that the last texels can be read 4 at a time
+		const size_t planeStride = (file.width + 3) & ~size_t(3);
+		std::vector<size_t> rows(file.height);
+		std::iota(rows.begin(), rows.end(), size_t(0));
+		std::for_each(std::execution::par, rows.begin(), rows.end(), [&](size_t y)
+		{
+			thread_local std::vector<uint8_t> planes;
+			planes.resize(planeStride * 4);
+			DecodeScanline(file.bytes.get() + file.scanlineOffsets[y], file.width, planeStride, planes.data());
+
+			uint8_t* row = image.pixels.get() + y * image.getRowPitch();
+			for (size_t x = 0; x < file.width; x += 4)
+			{
+				if (x + 4 <= file.width)
+				{
+					ConvertTexels(planes.data(), planeStride, x, format, row + x * image.bytesPerPixel);
+				}
+				else
+				{
+					alignas(16) uint8_t lastTexels[64];
+					ConvertTexels(planes.data(), planeStride, x, format, lastTexels);
+					std::memcpy(row + x * image.bytesPerPixel, lastTexels, (file.width - x) * image.bytesPerPixel);
+				}
+			}
+		});
+
+		return image;
+	}
+
+	void ImageDecoder::PixelsDeleter::operator()(uint8_t* pixels) const
+	{
+		if (bFromStbi) stbi_image_free(pixels);
+		else delete[] pixels;
+	}
+
+	std::optional<ImageDecoder::DecodedImage> ImageDecoder::DecodeFile(const std::filesystem::path& path)
+	{
+		if (path.extension() == ".dds") return std::nullopt;
+		if (path.extension() == ".hdr")
+		{
+			if (std::optional<DecodedImage> image = DecodeHDR(path, HDRFormat::RGB9E5))
+				return image;
+		}
+
+		const std::string file = widestring2string(path.wstring());
+		const bool bFloat = path.extension() == ".hdr";
+		int width = 0, height = 0, channels = 0;
+		void* data = bFloat ? static_cast<void*>(stbi_loadf(file.c_str(), &width, &height, &channels, 4)) : stbi_load(file.c_str(), &width, &height, &channels, 4);
+		if (!data) return std::nullopt;
+
+		DecodedImage image;
+		image.width = static_cast<size_t>(width);
+		image.height = static_cast<size_t>(height);
+		image.format = bFloat ? DXGI_FORMAT_R32G32B32A32_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+		image.bytesPerPixel = bFloat ? 16 : 4;
+		image.pixels = std::unique_ptr<uint8_t[], PixelsDeleter>(static_cast<uint8_t*>(data), PixelsDeleter{ .bFromStbi = true });
+		return image;
+	}
+
+	ImageDecoder::BenchmarkResult ImageDecoder::BenchmarkHDR(const std::filesystem::path& path, uint32_t iterations)
+	{
+		PerformanceClock clock;
+		BenchmarkResult result;
+		const std::string file = widestring2string(path.wstring());
+
+		auto timeBest = [&](auto&& decode)
+		{
+			double best = std::numeric_limits<double>::max();
+			for (uint32_t i = 0; i < std::max(1u, iterations); i++)
+			{
+				const int64_t start = clock.getTimeAsCount();
+				decode();
+				best = std::min(best, clock.getDeltaSeconds(start, clock.getTimeAsCount()));
+			}
+			return best;
+		};
+
+		result.stbiSeconds = timeBest([&]
+		{
+			int width, height, channels;
+			float* data = stbi_loadf(file.c_str(), &width, &height, &channels, 4);
+			result.width = static_cast<size_t>(width);
+			result.height = static_cast<size_t>(height);
+			stbi_image_free(data);
+		});
+
+		constexpr const char* FORMAT_NAMES[] = { "RGBA32F", "RGBA16F", "RGB9E5" };
+		const double stbiMs = result.stbiSeconds * 1000.;
+		PYR_LOGF(LogImageDecoder, INFO, "{} ({}x{}) stbi_loadf : {:.1f} ms", file, result.width, result.height, stbiMs);
+		for (size_t format = 0; format < std::size(FORMAT_NAMES); format++)
+		{
+			bool bDecoded = true;
+			result.decodeSeconds[format] = timeBest([&] { bDecoded &= DecodeHDR(path, static_cast<HDRFormat>(format)).has_value(); });
+			if (!bDecoded)
+			{
+				PYR_LOGF(LogImageDecoder, WARN, "{} can't be decoded by DecodeHDR", file);
+				break;
+			}
+			const double decodeMs = result.decodeSeconds[format] * 1000.;
+			const double speedup = result.stbiSeconds / result.decodeSeconds[format];
+			PYR_LOGF(LogImageDecoder, INFO, "  DecodeHDR {} : {:.1f} ms, x{:.1f}", FORMAT_NAMES[format], decodeMs, speedup);
+		}
+		return result;
+	}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+#include <dxgiformat.h>
+
+#include "utils/Debug.h"
+
+static inline PYR_DEFINELOG(LogImageDecoder, VERBOSE);
+
+namespace pyr
+{
+
+// Decodes Radiance .hdr files on every core, straight into the layout of the texture they are uploaded to.
+// The scanlines are located with a quick sequential pass over the file, then run length decoded and converted in parallel,
+// 4 texels at a time with SSE2. No float rgba copy of the whole image is made unless RGBA32F is asked for.
+//
+// Only the usual "new RLE" encoding is handled (every file written by a recent tool), callers fall back to stb_image otherwise.
+class ImageDecoder
+{
+public:
+
+    enum class HDRFormat : uint8_t
+    {
+        RGBA32F, // 16 bytes per texel, what stbi_loadf produces
+        RGBA16F, // 8 bytes per texel
+        RGB9E5,  // 4 bytes per texel, the rgbe encoding converts to it without any float math
+    };
+
+    // Pixels are either allocated by the decoder or handed over by stb_image without a copy
+    struct PixelsDeleter
+    {
+        bool bFromStbi = false;
+        void operator()(uint8_t* pixels) const;
+    };
+
+    struct DecodedImage
+    {
+        size_t width = 0, height = 0;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        size_t bytesPerPixel = 0;
+        std::unique_ptr<uint8_t[], PixelsDeleter> pixels; // tightly packed rows
+
+        size_t getRowPitch() const { return width * bytesPerPixel; }
+    };
+
+    struct BenchmarkResult
+    {
+        double stbiSeconds = 0;
+        double decodeSeconds[3] = {}; // indexed by HDRFormat
+        size_t width = 0, height = 0;
+    };
+
+    ImageDecoder() = delete;
+
+    // Returns nullopt if the file can't be read or is not encoded in a way this decoder handles
+    static std::optional<DecodedImage> DecodeHDR(const std::filesystem::path& path, HDRFormat format);
+    // Decodes any image TextureManager::loadTexture accepts, .hdr as RGB9E5 and others as RGBA8. Can be called from any thread.
+    // Returns nullopt for DDS files, these are already in their GPU layout and are better loaded directly.
+    static std::optional<DecodedImage> DecodeFile(const std::filesystem::path& path);
+
+    // Times stbi_loadf against DecodeHDR with every format, logs and returns the best run of each
+    static BenchmarkResult BenchmarkHDR(const std::filesystem::path& path, uint32_t iterations = 3);
+};
+
+}
@@ -6,6 +6,7 @@
 #include "world/Mesh/RawMeshData.h"
 #include "world/Mesh/StaticMesh.h"
 #include "world/Tools/CommonConstantBuffers.h"
+#include "world/Tools/DrawCommandCache.h"
 #include "display/FrameBuffer.h"
 
 namespace pyr
@@ -23,14 +24,22 @@ namespace pyr
             std::shared_ptr<ActorBuffer>        pActorBuffer = std::make_shared<ActorBuffer>();
             std::shared_ptr<pyr::CameraBuffer>  pcameraBuffer = std::make_shared<pyr::CameraBuffer>();
             
-            // goal output a depth texture 
-            FrameBuffer m_depthTarget;
+            // goal output a depth texture, owned by the graph
+            ResourceHandle<FrameBuffer> m_depthTarget;
             Effect* m_depthOnlyEffect = nullptr;
+            DrawCommandCache m_drawCommands{ DrawCommandCache::CommandType::DepthOnly };
 
         public:
 
             DepthPrePass(unsigned int width, unsigned int height)
-                : m_depthTarget{ width , height, FrameBuffer::DEPTH_STENCIL }
+                : DepthPrePass(TransientTextureDesc::Fixed(width, height, FrameBuffer::DEPTH_STENCIL))
+            {}
+
+            DepthPrePass()
+                : DepthPrePass(TransientTextureDesc::WindowSized(FrameBuffer::DEPTH_STENCIL))
+            {}
+
+            explicit DepthPrePass(TransientTextureDesc depthDesc)
             {
                 displayName = "Depth pre-pass";
                 m_depthOnlyEffect = m_registry.loadEffect(
@@ -38,13 +47,9 @@ namespace pyr
                     InputLayout::MakeLayoutFromVertex<pyr::RawMeshData::mesh_vertex_t>()
                 );
 
-                producesResource("depthBuffer", m_depthTarget.getTargetAsTexture(FrameBuffer::DEPTH_STENCIL));
+                m_depthTarget = producesTransient(BuiltinResources::DepthBuffer, depthDesc, FrameBuffer::DEPTH_STENCIL);
             }
 
-            DepthPrePass()
-                : DepthPrePass(pyr::Device::getWinWidth(), pyr::Device::getWinHeight())
-            {}
-
             virtual void apply() override
             {
                 if (!PYR_ENSURE(owner)) return;
@@ -52,35 +57,34 @@ namespace pyr
                 pcameraBuffer->setData(CameraBuffer::data_t{ .mvp = owner->GetContext().contextCamera->getViewProjectionMatrix(), .pos = owner->GetContext().contextCamera->getPosition() });
 
                 // Render all objects to a depth only texture
-                m_depthTarget.clearTargets();
-                m_depthTarget.bind();
+                FrameBuffer& depthTarget = getTransient(m_depthTarget);
+                depthTarget.clearTargets();
+                depthTarget.bind();
 
                 m_depthOnlyEffect->bindConstantBuffer("CameraBuffer", pcameraBuffer);
 
-                for (const StaticMesh* smesh : owner->GetContext().ActorsToRender.meshes)
+                // Contiguous submeshes are merged, most meshes are a single draw
+                const StaticMesh* boundMesh = nullptr;
+                for (const DrawCommand& command : m_drawCommands.update(owner->GetContext().ActorsToRender.meshes))
                 {
-
-                    smesh->bindModel();
-
-                    pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = smesh->GetTransform().getWorldMatrix() });
-                    m_depthOnlyEffect->bindConstantBuffer("ActorBuffer", pActorBuffer);
-                    m_depthOnlyEffect->bind();
-                    
-                    std::span<const SubMesh> submeshes = smesh->getModel()->getRawMeshData()->getSubmeshes();
-                    for (auto& submesh : submeshes)
+                    if (command.mesh != boundMesh)
                     {
-                        Engine::d3dcontext().DrawIndexed(static_cast<UINT>(submesh.getIndexCount()), submesh.startIndex, 0);
+                        boundMesh = command.mesh;
+                        boundMesh->bindModel();
+                        pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = boundMesh->GetWorldMatrix() });
+                        m_depthOnlyEffect->bindConstantBuffer("ActorBuffer", pActorBuffer);
+                        m_depthOnlyEffect->bind();
                     }
-
-                    m_depthOnlyEffect->unbindResources();
+                    Engine::d3dcontext().DrawIndexed(command.indexCount, command.startIndex, 0);
                 }
+                m_depthOnlyEffect->unbindResources();
 
-                m_depthTarget.unbind();
+                depthTarget.unbind();
 
             }
 
             const Effect* getDepthPassEffect() const noexcept { return m_depthOnlyEffect; }
-            Texture getOutputDepth() { return m_depthTarget.getTargetAsTexture(FrameBuffer::Target::DEPTH_STENCIL); }
+            Texture getOutputDepth() { return getTransient(m_depthTarget).getTargetAsTexture(FrameBuffer::Target::DEPTH_STENCIL); }
 
         };
     }
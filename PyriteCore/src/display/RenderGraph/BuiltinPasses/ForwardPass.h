@@ -9,8 +9,12 @@
 #include "display/RenderProfiles.h"
 #include "world/Mesh/StaticMesh.h"
 #include "world/Lights/Light.h"
+#include "world/Lights/LightPacker.h"
 #include "world/Shadows/Lightmap.h"
+#include "world/Shadows/ShadowRenderer.h"
 #include "world/Tools/SceneRenderTools.h"
+#include "world/Tools/DrawCommandCache.h"
+#include "world/Tools/TextureStreaming.h"
 #include "scene/SceneManager.h"
 
 #include <array>
@@ -30,7 +34,13 @@ private:
 
     std::shared_ptr<ActorBuffer>     pActorBuffer = std::make_shared<ActorBuffer>();
     std::shared_ptr<CameraBuffer>    pcameraBuffer = std::make_shared<CameraBuffer>();
-    std::shared_ptr<LightsBuffer>    pLightBuffer = std::make_shared<LightsBuffer>();
+
+    ResourceHandle<Texture> m_depthInput;
+    ResourceHandle<Texture> m_ssaoInput;
+
+    ShadowRenderer m_shadowRenderer;
+    DrawCommandCache m_drawCommands{ DrawCommandCache::CommandType::Shaded };
+    LightPacker m_lights;
     
 public:
 
@@ -39,6 +49,8 @@ public:
     ForwardPass()
     {
         displayName = "Forward pass";
+        m_depthInput = declareInput(BuiltinResources::DepthBuffer);
+        m_ssaoInput = declareInput(BuiltinResources::SSAOTextureBlurred);
         
         static constexpr wchar_t DEFAULT_SKYBOX_TEXTURE[] = L"res/textures/pbr/testhdr.dds"; // todo avoid this as the core engine does not have runtime textures
         loadSkybox(DEFAULT_SKYBOX_TEXTURE);
@@ -50,133 +62,55 @@ public:
         if (!PYR_ENSURE(owner->GetContext().contextCamera)) return;
         pcameraBuffer->setData(CameraBuffer::data_t{ .mvp = owner->GetContext().contextCamera->getViewProjectionMatrix(), .pos = owner->GetContext().contextCamera->getPosition() });
 
+        NamedInput* depthBuffer = getInput(m_depthInput);
+        if (!PYR_ENSURE(depthBuffer, "Forward pass requires a linked depth buffer")) return; // < make sure this input is linked in the scene rdg
+
         Engine::d3dcontext().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
         pyr::RenderProfiles::pushDepthProfile(pyr::DepthProfile::TESTONLY_DEPTH);
 
-        pyr::FrameBuffer::getActiveFrameBuffer().setDepthOverride(m_inputs.at("depthBuffer").res.toDepthStencilView()); // < make sure this input is linked in the scene rdg
+        pyr::FrameBuffer::getActiveFrameBuffer().setDepthOverride(depthBuffer->res.toDepthStencilView());
 
-        // -- Get all the lights in the context, and bind them
-        const pyr::LightsCollections& lights = owner->GetContext().ActorsToRender.lights;
-        auto castsShadows = [](pyr::BaseLight* light) -> bool { return light->isOn && light->shadowMode == pyr::DynamicShadow; };
-        int shadow_map_index = 0;
+        // -- Render the shadow maps of the lights in the context, this also tells the lights where their maps are
+        m_shadowRenderer.render(owner->GetContext().ActorsToRender, *owner->GetContext().contextCamera);
 
-        // don't use vectors here... don't duplicate code here.... why am i doing this
-        std::vector<Texture> lightmaps_2D{};
-        std::vector<Cubemap> lightmaps_3D{};
+        // -- Only the lights that changed are packed again, the buffer is only uploaded when one did
+        m_lights.update(owner->GetContext().ActorsToRender.lights);
 
-        static std::array<pyr::FrameBuffer, 16> lightmaps_2D_fbos{};
-        static std::array<pyr::CubemapFramebuffer, 16> lightmaps_3D_fbos{};
-        static auto constructLightmaps = [&]() {
-            std::ranges::generate(lightmaps_2D_fbos, []() { return FrameBuffer{ 512, 512, FrameBuffer::DEPTH_STENCIL }; });
-            std::ranges::generate(lightmaps_3D_fbos, []() { return CubemapFramebuffer{ 512, FrameBuffer::Target::DEPTH_STENCIL | FrameBuffer::COLOR_0 }; });
-            return 0;
-        }();
+        const NamedInput* ssaoTexture = getInput(m_ssaoInput);
 
-        static TextureArray lightmaps_2DArray{ 512,512, 8, TextureArray::Texture2D  , true  };
-        static TextureArray lightmaps_3DArray{ 512,512, 8, TextureArray::TextureCube, false };
-        static TextureArray empty_Array2D{ 1,1, 1, TextureArray::Texture2D, false };
-        static TextureArray empty_Array3D{ 1,1, 1, TextureArray::TextureCube, false };
+        // -- Tell the texture cache which mips are needed on screen, they are streamed in for the next frames
+        TextureStreaming::RequestVisibleMips(owner->GetContext().ActorsToRender.getMeshComponents(), *owner->GetContext().contextCamera, static_cast<float>(depthBuffer->res.getHeight()));
 
-        if (!owner->GetContext().ActorsToRender.lights.Spots.empty() || !owner->GetContext().ActorsToRender.lights.Directionals.empty())
+        // -- Render all objects 
+        // -- Commands are sorted by material, the model and its transform are only bound again when the mesh changes
+        const StaticMesh* boundMesh = nullptr;
+        for (const DrawCommand& command : m_drawCommands.update(owner->GetContext().ActorsToRender.meshes))
         {
-            for (int i = 0; i < 16; i++)
+            if (command.mesh != boundMesh)
             {
-                lightmaps_2D_fbos[i].clearTargets();
+                boundMesh = command.mesh;
+                boundMesh->bindModel();
+                pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = boundMesh->GetWorldMatrix() });
             }
-        }
 
-        std::ranges::for_each(owner->GetContext().ActorsToRender.lights.Points, [&](pyr::PointLight& light) {
-            if (castsShadows(&light))
-            {
-                pyr::Cubemap lightmap = pyr::SceneRenderTools::MakeSceneDepthCubemapFromPoint(owner->GetContext().ActorsToRender, light.GetTransform().position, lightmaps_3D_fbos[lightmaps_3D.size()]);
-                light.shadowMapIndex = 16 + static_cast<int>((lightmaps_3D.size()));
-                lightmaps_3D.push_back(lightmap);
-            }
-        });
+            const Material* submeshMaterial = command.material;
+            const Effect* effect = submeshMaterial->getEffect(); // not cached, materials can change effect
+            if (!effect) continue;
 
-        std::ranges::for_each(owner->GetContext().ActorsToRender.lights.Spots, [&](pyr::SpotLight& light) {
-            if (castsShadows(&light))
-            {
-                pyr::Camera camera{};
-                camera.setProjection(light.shadow_projection);
-                camera.setPosition(light.GetTransform().position);
-                vec3 fuck = { light.GetTransform().rotation.x, light.GetTransform().rotation.y, light.GetTransform().rotation.z };
-                camera.lookAt(light.GetTransform().position + fuck);
-                pyr::Texture lightmap = pyr::SceneRenderTools::MakeSceneDepth(owner->GetContext().ActorsToRender, camera, lightmaps_2D_fbos[shadow_map_index]);
-                light.shadowMapIndex = (shadow_map_index++);
-                lightmaps_2D.push_back(lightmap);
-            }
-            });
+            effect->bindConstantBuffer("CameraBuffer", pcameraBuffer);
+            effect->bindConstantBuffer("ActorBuffer", pActorBuffer);
+            effect->bindConstantBuffer("ActorMaterials", submeshMaterial->coefsToCbuffer());
+            effect->bindConstantBuffer("lightsBuffer", m_lights.getBuffer());
+            m_shadowRenderer.bindShadowMaps(*effect);
 
-        std::ranges::for_each(owner->GetContext().ActorsToRender.lights.Directionals, [&](pyr::DirectionalLight& light) {
-            if (castsShadows(&light))
-            {
-                pyr::Camera camera{};
-                camera.setProjection(light.shadow_projection);
-                camera.setPosition(light.GetTransform().position);
-                vec3 fuck = { light.GetTransform().rotation.x, light.GetTransform().rotation.y, light.GetTransform().rotation.z };
-                camera.lookAt(light.GetTransform().position + fuck);
-                camera.rotate(XM_PIDIV2, 0, 0);
-                pyr::Texture lightmap = pyr::SceneRenderTools::MakeSceneDepth(owner->GetContext().ActorsToRender, camera, lightmaps_2D_fbos[shadow_map_index]);
-                light.shadowMapIndex = (shadow_map_index++);
-                lightmaps_2D.push_back(lightmap);
-            }
-        });
-
-        if (!lightmaps_2D.empty())
-            TextureArray::CopyToTextureArray(lightmaps_2D, lightmaps_2DArray);
-        if (!lightmaps_3D.empty())
-            TextureArray::CopyToTextureArray(lightmaps_3D, lightmaps_3DArray);
-
-        LightsBuffer::data_t light_data{};
-        std::copy_n(owner->GetContext().ActorsToRender.lights.ConvertCollectionToHLSL().begin(), std::size(light_data.lights), std::begin(light_data.lights));
 
-        pLightBuffer->setData(light_data);
+            if (ssaoTexture) effect->bindTexture(ssaoTexture->res, "ssaoTexture");
+            else effect->bindTexture(pyr::Texture::getDefaultTextureSet().WhitePixel , "ssaoTexture");
+            submeshMaterial->bindTextures();
 
-        // -- Render all objects 
-        for (const StaticMesh* mesh : owner->GetContext().ActorsToRender.meshes)
-        {
-            mesh->bindModel();
-            pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = mesh->GetTransform().getWorldMatrix() });
-            std::span<const SubMesh> submeshes = mesh->getModel()->getRawMeshData()->getSubmeshes();
-            std::optional<NamedInput> ssaoTexture = getInputResource("ssaoTexture_blurred");
-            
-            for (auto& submesh : submeshes)
-            {
-                //const auto submeshMaterial = pyr::MaterialBank::GetMaterialReference(submesh.materialIndex);
-                const auto& submeshMaterial = mesh->getMaterial(submesh.materialIndex);
-                if (!submeshMaterial) break; // should not happen because of default mat ?
-
-                const Effect* effect = submeshMaterial->getEffect();
-                if (!effect) break;
-                
-                effect->bindConstantBuffer("CameraBuffer", pcameraBuffer);
-                effect->bindConstantBuffer("ActorBuffer", pActorBuffer);
-                effect->bindConstantBuffer("ActorMaterials", submeshMaterial->coefsToCbuffer());
-                effect->bindConstantBuffer("lightsBuffer", pLightBuffer);
-                if (!lightmaps_2D.empty())
-                    effect->bindTexture(lightmaps_2DArray, "lightmaps_2D");
-                if (!lightmaps_3D.empty())
-                    effect->bindTexture(lightmaps_3DArray, "lightmaps_3D");
-
-
-                if (ssaoTexture) effect->bindTexture(ssaoTexture.value().res, "ssaoTexture");
-                else effect->bindTexture(pyr::Texture::getDefaultTextureSet().WhitePixel , "ssaoTexture");
-                if (submeshMaterial)
-                {
-                    if (auto tex = submeshMaterial->getTexture(TextureType::ALBEDO); tex)    effect->bindTexture(*tex, "mat_albedo");
-                    if (auto tex = submeshMaterial->getTexture(TextureType::NORMAL); tex)    effect->bindTexture(*tex, "mat_normal");
-                    if (auto tex = submeshMaterial->getTexture(TextureType::BUMP); tex)      effect->bindTexture(*tex, "mat_normal");
-                    if (auto tex = submeshMaterial->getTexture(TextureType::AO); tex)        effect->bindTexture(*tex, "mat_ao");
-                    if (auto tex = submeshMaterial->getTexture(TextureType::ROUGHNESS); tex) effect->bindTexture(*tex, "mat_roughness");
-                    if (auto tex = submeshMaterial->getTexture(TextureType::METALNESS); tex) effect->bindTexture(*tex, "mat_metalness");
-                    if (auto tex = submeshMaterial->getTexture(TextureType::HEIGHT); tex)    effect->bindTexture(*tex,  "mat_height");
-                }
-                
-                effect->bind();
-                Engine::d3dcontext().DrawIndexed(static_cast<UINT>(submesh.getIndexCount()), submesh.startIndex, 0);
-                effect->unbindResources();
-            }
+            effect->bind();
+            Engine::d3dcontext().DrawIndexed(command.indexCount, command.startIndex, 0);
+            effect->unbindResources();
         }
 
         pyr::RenderProfiles::popDepthProfile();
@@ -192,6 +126,7 @@ public:
     }
 
     Effect* getSkyboxEffect() const { return m_skyboxEffect; }
+    const ShadowRenderer& getShadowRenderer() const { return m_shadowRenderer; }
 private:
 
     void renderSkybox()
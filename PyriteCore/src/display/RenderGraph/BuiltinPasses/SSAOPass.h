@@ -19,8 +19,9 @@ namespace pyr
 
             pyr::GraphicalResourceRegistry m_registry;
 
-            FrameBuffer m_ssaoTextureTarget{ Device::getWinWidth(), Device::getWinHeight(), FrameBuffer::COLOR_0 };
-            FrameBuffer m_blurredSSAOTarget{ Device::getWinWidth(), Device::getWinHeight(), FrameBuffer::COLOR_0 };
+            ResourceHandle<FrameBuffer> m_ssaoTextureTarget;
+            ResourceHandle<FrameBuffer> m_blurredSSAOTarget;
+            ResourceHandle<Texture> m_depthInput;
 
             Effect* m_ssaoEffect = nullptr;
             Effect* m_blurEffect = nullptr;
@@ -55,8 +56,9 @@ namespace pyr
                 m_randomTexture = m_registry.loadTexture(L"res/textures/randomNoise.dds");
                 m_kernel = generateKernel(64);
 
-                producesResource("ssaoTexture", m_ssaoTextureTarget.getTargetAsTexture(FrameBuffer::COLOR_0));
-                producesResource("ssaoTexture_blurred", m_blurredSSAOTarget.getTargetAsTexture(FrameBuffer::COLOR_0));
+                m_depthInput = declareInput(BuiltinResources::DepthBuffer);
+                m_ssaoTextureTarget = producesTransient(BuiltinResources::SSAOTexture, TransientTextureDesc::WindowSized(FrameBuffer::COLOR_0), FrameBuffer::COLOR_0);
+                m_blurredSSAOTarget = producesTransient(BuiltinResources::SSAOTextureBlurred, TransientTextureDesc::WindowSized(FrameBuffer::COLOR_0), FrameBuffer::COLOR_0);
             }
 
             virtual void apply() override
@@ -74,14 +76,20 @@ namespace pyr
                     .Proj = owner->GetContext().contextCamera->getProjectionMatrix()
                 });
 
+                NamedInput* depthBuffer = getInput(m_depthInput);
+                if (!PYR_ENSURE(depthBuffer, "SSAO requires a linked depth buffer")) return;
+
+                FrameBuffer& ssaoTextureTarget = getTransient(m_ssaoTextureTarget);
+                FrameBuffer& blurredSSAOTarget = getTransient(m_blurredSSAOTarget);
+
                 // Compute the SSAO Texture
-                m_ssaoTextureTarget.clearTargets();
-                m_ssaoTextureTarget.bind();
+                ssaoTextureTarget.clearTargets();
+                ssaoTextureTarget.bind();
 
                 m_ssaoEffect->bindConstantBuffer("InverseCameraBuffer", pinvCameBuffer);
                 m_ssaoEffect->bindConstantBuffer("CameraBuffer", pcameraBuffer);
 
-                m_ssaoEffect->bindTexture(m_inputs["depthBuffer"].res, "depthBuffer");
+                m_ssaoEffect->bindTexture(depthBuffer->res, "depthBuffer");
                 m_ssaoEffect->bindTexture(m_randomTexture, "blueNoise");
                 m_ssaoEffect->setUniform<std::vector<vec4>>("u_kernel", m_kernel);
                 m_ssaoEffect->bind();
@@ -89,26 +97,27 @@ namespace pyr
                 Engine::d3dcontext().DrawIndexed(3, 0, 0);
                 
                 m_ssaoEffect->unbindResources();
-                m_ssaoTextureTarget.unbind();
+                ssaoTextureTarget.unbind();
 
                 // Blur pass
-                m_blurredSSAOTarget.bind();
+                blurredSSAOTarget.bind();
 
-                m_blurEffect->bindTexture(m_ssaoTextureTarget.getTargetAsTexture(FrameBuffer::COLOR_0), "sourceTexture");
+                m_blurEffect->bindTexture(ssaoTextureTarget.getTargetAsTexture(FrameBuffer::COLOR_0), "sourceTexture");
                 m_blurEffect->bind();
                 Engine::d3dcontext().DrawIndexed(3, 0, 0);
                 m_blurEffect->unbindResources();
                 
-                m_blurredSSAOTarget.unbind();
+                blurredSSAOTarget.unbind();
             }
 
             virtual void OpenDebugWindow() override {
 
                 ImGui::Begin("SSAO Pass Debug");
 
-                ImGui::Image((void*)m_inputs["depthBuffer"].res.getRawTexture(), ImVec2{ 256,256 });
-                ImGui::Image((void*)m_ssaoTextureTarget.getTargetAsTexture(FrameBuffer::COLOR_0).getRawTexture(), ImVec2{ 256,256 });
-                ImGui::Image((void*)m_blurredSSAOTarget.getTargetAsTexture(FrameBuffer::COLOR_0).getRawTexture(), ImVec2{ 256,256 });
+                if (NamedInput* depthBuffer = getInput(m_depthInput))
+                    ImGui::Image((void*)depthBuffer->res.getRawTexture(), ImVec2{ 256,256 });
+                ImGui::Image((void*)getTransient(m_ssaoTextureTarget).getTargetAsTexture(FrameBuffer::COLOR_0).getRawTexture(), ImVec2{ 256,256 });
+                ImGui::Image((void*)getTransient(m_blurredSSAOTarget).getTargetAsTexture(FrameBuffer::COLOR_0).getRawTexture(), ImVec2{ 256,256 });
 
                 static float sampleRad = 0.1f;
                 static float u_bias = 0.0001f;
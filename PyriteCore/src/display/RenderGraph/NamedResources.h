@@ -1,26 +1,77 @@
 #pragma once
 
-#include <functional>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 #include "display/texture.h"
 
 namespace pyr
 {
     class RenderPass;
-   
-    struct NamedResource
+
+    // Identifies a resource of the graph by the hash of its name (FNV-1a), hashed once when the id is created.
+    // Lookups go through the hash, names are only compared when two hashes match, so that colliding names stay distinct.
+    struct ResourceID
+    {
+        uint32_t hash = 0;
+        std::string name;
+
+        ResourceID() = default;
+        ResourceID(const char* resName) : hash(HashName(resName)), name(resName) {}
+
+        static constexpr uint32_t HashName(std::string_view str) noexcept
+        {
+            uint32_t h = 2166136261u;
+            for (char c : str)
+            {
+                h ^= static_cast<uint8_t>(c);
+                h *= 16777619u;
+            }
+            return h;
+        }
+
+        bool operator==(const ResourceID& other) const noexcept { return hash == other.hash && name == other.name; }
+
+        struct Hasher { size_t operator()(const ResourceID& id) const noexcept { return id.hash; } };
+    };
+
+    // Same thing, but carrying the type of the resource so that a pass can't ask for a texture where something else is produced
+    template<class T>
+    struct TypedResourceID : ResourceID
     {
-        using label_t = std::string;
-        std::string label;
+        using resource_t = T;
+        using ResourceID::ResourceID;
+    };
+
+    using TextureResourceID = TypedResourceID<Texture>;
 
-        Texture res; // fuck this shit man
-        RenderPass* origin;
+    // Index of a resource in the arrays of a pass (inputs, transients), resolving it is an array access
+    template<class T>
+    struct ResourceHandle
+    {
+        static constexpr uint16_t INVALID = 0xFFFF;
+        uint16_t index = INVALID;
+
+        bool isValid() const noexcept { return index != INVALID; }
+    };
+
+    struct NamedResource
+    {
+        ResourceID id;
+        Texture res;
+        RenderPass* origin = nullptr;
     };
 
     using NamedOutput = NamedResource;
     using NamedInput = NamedResource;
 
-    using ResourceGetter = std::function<Texture()>;
+    // Resources produced by the builtin passes
+    namespace BuiltinResources
+    {
+        inline const TextureResourceID DepthBuffer          { "depthBuffer" };
+        inline const TextureResourceID SSAOTexture          { "ssaoTexture" };
+        inline const TextureResourceID SSAOTextureBlurred   { "ssaoTexture_blurred" };
+    }
 
 }
@@ -3,6 +3,7 @@
 #include "RenderGraph.h"
 #include "RenderPass.h"
 #include "utils/debug.h"
+#include <algorithm>
 #include <optional>
 
 #define ASSERT_IS_IN_GRAPH(pass) PYR_ASSERT(m_passResources.contains(pass));
@@ -18,34 +19,34 @@ namespace pyr
 	};
 
 
-	void RenderGraphResourceManager::linkResource(RenderPass* from, const char* resName, RenderPass* to)
+	void RenderGraphResourceManager::linkResource(RenderPass* from, ResourceID resId, RenderPass* to)
 	{
 		ASSERT_IS_IN_GRAPH(from);
 		if (!PYR_ENSURE(m_passResources.contains(to)))
 		{
-			PYR_LOGF(LogRenderGraph, WARN, "Trying to link resource  \"{}\" to pass {} that is not in graph !", resName, to->displayName);
+			PYR_LOGF(LogRenderGraph, WARN, "Trying to link resource  \"{}\" to pass {} that is not in graph !", resId.name, to->displayName);
 		}
 		
-		std::optional<NamedOutput> resource = from->getOutputResource(resName);
+		std::optional<NamedOutput> resource = from->getOutputResource(resId);
 		if (resource.has_value()) {
 			to->addNamedInput(resource.value());
-			m_passResources[to].incomingResources[resName] = resource.value();
+			m_passResources[to].incomingResources[resId] = resource.value();
 		}
 
 		else throw Errors::PassDoesNotProduceResource{} ;
 	}
 
-	void RenderGraphResourceManager::linkResource(const char* resName, RenderPass* to)
+	void RenderGraphResourceManager::linkResource(ResourceID resId, RenderPass* to)
 	{
 		ASSERT_IS_IN_GRAPH(to);
 
 		for (auto& [pass, passResources] : m_passResources)
 		{
-			if (passResources.producedResources.contains(resName))
+			if (passResources.producedResources.contains(resId))
 			{
-				NamedOutput& output = passResources.producedResources[resName];
+				NamedOutput& output = passResources.producedResources[resId];
 				to->addNamedInput(output);
-				m_passResources[to].incomingResources[resName] = output;
+				m_passResources[to].incomingResources[resId] = output;
 				return;
 			}
 		}
@@ -53,22 +54,24 @@ namespace pyr
 		PYR_ASSERT(false, "Trying to link a resource that no renderpass produces in the graph... very sad");
 	}
 
-	void RenderGraphResourceManager::addProduced(RenderPass* pass, const char* resName)
+	void RenderGraphResourceManager::addProduced(RenderPass* pass, ResourceID resId)
 	{
 		ASSERT_IS_IN_GRAPH(pass)
 
-		std::optional<NamedOutput> resource = pass->getOutputResource(resName);
-		if (resource.has_value()) m_passResources[pass].producedResources[resName] = resource.value();
+		std::optional<NamedOutput> resource = pass->getOutputResource(resId);
+		if (resource.has_value()) m_passResources[pass].producedResources[resId] = resource.value();
 
 		else throw Errors::PassDoesNotProduceResource{};
 
 	}
 
-	void RenderGraphResourceManager::addRequirement(RenderPass* pass, const char* resName)
+	void RenderGraphResourceManager::addRequirement(RenderPass* pass, ResourceID resId)
 	{
 		ASSERT_IS_IN_GRAPH(pass)
 
-		m_passResources[pass].requiredResources.insert(resName);
+		std::vector<ResourceID>& requirements = m_passResources[pass].requiredResources;
+		if (std::ranges::find(requirements, resId) == requirements.end())
+			requirements.push_back(resId);
 	}
 
 	// throws error
@@ -76,10 +79,10 @@ namespace pyr
 	{
 		for (auto& [pass, res] : m_passResources)
 		{
-			for (const std::string& resName : res.requiredResources)
+			for (const ResourceID& resId : res.requiredResources)
 			{
 				// If a requirement is not met (= not in the inputs list)
-				if (!res.incomingResources.contains(resName))
+				if (!res.incomingResources.contains(resId))
 				{
 #ifdef _DEBUG
 					throw Errors::ResourceGraphNotValid{};
@@ -91,6 +94,26 @@ namespace pyr
 		return true;
 	}
 
+	void RenderGraphResourceManager::refreshLinkedResources()
+	{
+		for (auto& [pass, passResources] : m_passResources)
+		{
+			for (auto& [resId, output] : passResources.producedResources)
+			{
+				std::optional<NamedOutput> current = pass->getOutputResource(resId);
+				if (current.has_value()) output.res = current->res;
+			}
+
+			for (auto& [resId, input] : passResources.incomingResources)
+			{
+				std::optional<NamedOutput> current = input.origin->getOutputResource(resId);
+				if (!current.has_value() || current->res == input.res) continue;
+				input.res = current->res;
+				pass->addNamedInput(input);
+			}
+		}
+	}
+
 
 
 
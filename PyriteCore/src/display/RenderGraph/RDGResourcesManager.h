@@ -1,6 +1,6 @@
 #pragma once
 
-#include <set>
+#include <vector>
 
 #include "NamedResources.h"
 #include <unordered_map>
@@ -15,10 +15,10 @@ namespace pyr
 	public:
 		struct PassResources
 		{
-			std::unordered_map<std::string, NamedInput> incomingResources;
-			std::unordered_map<std::string, NamedOutput> producedResources;
+			std::unordered_map<ResourceID, NamedInput, ResourceID::Hasher> incomingResources;
+			std::unordered_map<ResourceID, NamedOutput, ResourceID::Hasher> producedResources;
 
-			std::set<std::string> requiredResources; // if a res is present here and not in the inputs, will throw error
+			std::vector<ResourceID> requiredResources; // if a res is present here and not in the inputs, will throw error
 		};
 
 	private:
@@ -27,15 +27,14 @@ namespace pyr
 	public:
 
 		/// Add a named input to a render pass if the source renderpass produces said resource.
-		void linkResource(RenderPass* from, const char* resName, RenderPass* to);
+		void linkResource(RenderPass* from, ResourceID resId, RenderPass* to);
 
 		// Will try to fetch the resource somewhere, not sure if above version is required
 		// This is mainly used when you don't know what passes are in the render graph but need something (like depth buffer)
-		// I do believe we should have types and constant for resource naming instead of strings
-		void linkResource(const char* resName, RenderPass* to);
+		void linkResource(ResourceID resId, RenderPass* to);
 
-		void addProduced(RenderPass* pass, const char* resName);
-		void addRequirement(RenderPass* pass, const char* resName);
+		void addProduced(RenderPass* pass, ResourceID resId);
+		void addRequirement(RenderPass* pass, ResourceID resId);
 
 		bool checkResourcesValidity();
 
@@ -49,6 +48,9 @@ namespace pyr
 			m_passResources[pass] = PassResources{};
 		}
 
+		// Linked resources are copied when linking, fetch them again when the producers' textures changed (transients reallocation)
+		void refreshLinkedResources();
+
 	};
 
 
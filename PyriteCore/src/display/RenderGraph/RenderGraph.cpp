@@ -4,25 +4,83 @@
 #include "d3d11_1.h"
 #include "display/shader.h"
 
+#include <algorithm>
+
 using namespace pyr;
 
+RenderGraph::RenderGraph()
+{
+    Device::addWindowResizeEventHandler(m_windowResizeEventHandler = std::make_shared<ScreenResizeEventHandler>([this](int, int) {
+        m_bTransientsDirty = true;
+    }));
+}
+
 void RenderGraph::execute(const RenderContext& frameRenderContext /* = {}*/) {
     m_renderContext = frameRenderContext;
 
+    if (m_bTransientsDirty)
+        allocateTransients();
+
     ID3DUserDefinedAnnotation* pPerf;
     HRESULT hr = pyr::Engine::d3dcontext().QueryInterface(__uuidof(pPerf), reinterpret_cast<void**>(&pPerf));
     if (FAILED(hr)) return;
 
     pPerf->BeginEvent(string2widestring(frameRenderContext.debugName).c_str());
-    for (RenderPass* p : m_passes)
+    m_profiler.beginFrame(m_passes);
+    for (size_t passIndex = 0; passIndex < m_passes.size(); passIndex++)
     {
+        RenderPass* p = m_passes[passIndex];
         if (p->isEnabled())
         {
             pPerf->BeginEvent(string2widestring(p->displayName).c_str());
+            m_profiler.beginPass(passIndex, p->displayName);
             p->apply();
+            m_profiler.endPass(passIndex);
             pPerf->EndEvent();
         }
     }
+    m_profiler.endFrame();
     pPerf->EndEvent();
     DXRelease(pPerf);
+}
+
+void RenderGraph::allocateTransients()
+{
+    const auto& allResources = m_manager.GetAllResources();
+
+    std::vector<TransientResourcePool::Request> requests;
+    for (size_t passIndex = 0; passIndex < m_passes.size(); passIndex++)
+    {
+        RenderPass* producer = m_passes[passIndex];
+        for (RenderPass::TransientTarget& transient : producer->m_transients)
+        {
+            // The transient lives from its producer up to the last pass reading it.
+            // Exposed ones may be read after the last pass, their content is kept for the whole frame.
+            size_t firstUse = passIndex, lastUse = passIndex;
+            for (size_t readerIndex = 0; readerIndex < m_passes.size(); readerIndex++)
+            {
+                const auto& incoming = allResources.at(m_passes[readerIndex]).incomingResources;
+                auto it = incoming.find(transient.id);
+                if (it == incoming.end() || it->second.origin != producer) continue;
+
+                // Read before being written, this is last frame's content, don't let anyone else touch it
+                if (readerIndex < passIndex) { firstUse = 0; lastUse = m_passes.size(); break; }
+                lastUse = std::max(lastUse, readerIndex);
+            }
+            if (transient.bExposed) { firstUse = 0; lastUse = m_passes.size(); }
+            requests.push_back({ .desc = transient.desc, .firstUse = firstUse, .lastUse = lastUse, .outTarget = &transient.target });
+        }
+    }
+
+    m_transientPool.allocate(std::move(requests));
+    for (RenderPass* pass : m_passes)
+        pass->resolveTransientOutputs();
+    m_manager.refreshLinkedResources();
+    m_bTransientsDirty = false;
+
+    const TransientResourcePool::Stats& stats = m_transientPool.getStats();
+    float megabytesBefore = static_cast<float>(stats.bytesWithoutAliasing) / (1024.F * 1024.F);
+    float megabytesAfter = static_cast<float>(stats.bytesWithAliasing) / (1024.F * 1024.F);
+    PYR_LOGF(LogRenderGraph, INFO, "Allocated {} transients in {} framebuffers ({:.1f} MB without aliasing, {:.1f} MB with aliasing)",
+        stats.transientCount, stats.physicalCount, megabytesBefore, megabytesAfter);
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "RenderPass.h"
 #include "scene/RenderableActorCollection.h"
 #include "RDGResourcesManager.h"
+#include "TransientResourcePool.h"
+#include "RenderGraphProfiler.h"
 
 static inline PYR_DEFINELOG(LogRenderGraph, VERBOSE);
 
@@ -22,6 +24,13 @@ namespace pyr
         std::vector<RenderPass*> m_passes;
         RenderGraphResourceManager m_manager;
 
+        // -- Transient targets of the passes, (re)allocated on the first execute after the pass list or the window size changed
+        TransientResourcePool m_transientPool;
+        bool m_bTransientsDirty = true;
+        std::shared_ptr<ScreenResizeEventHandler> m_windowResizeEventHandler;
+
+        RenderGraphProfiler m_profiler;
+
         // -- Should be valid for a frame, contains what the camera is supposed to see (for now, since we dont have frustum culling, this context should be equal to the scene actors)
         RenderContext m_renderContext;
 
@@ -31,11 +40,21 @@ namespace pyr
         const RenderGraphResourceManager& getResourcesManager() const noexcept { return m_manager; }
         const RenderContext& GetContext() const { return m_renderContext; }
         RenderContext& GetContext() { return m_renderContext; }
+        const TransientResourcePool::Stats& GetTransientStats() const { return m_transientPool.getStats(); }
+        const RenderGraphProfiler& GetProfiler() const { return m_profiler; }
+        RenderGraphProfiler& GetProfiler() { return m_profiler; }
+        const std::vector<RenderPass*>& GetPasses() const { return m_passes; }
     public:
 
+        RenderGraph();
+
         void execute(const RenderContext& frameRenderContext = {});
-        void addPass(RenderPass* pass)  { m_passes.emplace_back(pass); m_manager.addNewPass(pass); pass->owner = this; }
+        void addPass(RenderPass* pass)  { m_passes.emplace_back(pass); m_manager.addNewPass(pass); pass->owner = this; m_bTransientsDirty = true; }
         void debugWindow() {}
 
+    private:
+
+        void allocateTransients();
+
     };
 }
@@ -0,0 +1,243 @@
+#include "RenderGraphProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "RenderGraph.h"
+#include "engine/Engine.h"
+
+namespace pyr
+{
+
+	RenderGraphProfiler::~RenderGraphProfiler()
+	{
+		releaseQueries();
+	}
+
+	void RenderGraphProfiler::beginFrame(const std::vector<RenderPass*>& passes)
+	{
+		m_frameIndex++;
+
+		if (!std::ranges::equal(passes, m_passes))
+			remapHistory(passes);
+		const size_t passCount = passes.size();
+
+		const size_t sample = getLatestSampleIndex();
+		for (PassHistory& pass : m_history)
+			pass.cpuMs[sample] = pass.gpuMs[sample] = 0.F;
+
+		if (!isGpuTimingAvailable()) return;
+
+		resolvePendingQueries();
+
+		FrameQueries& frame = m_queries[m_frameIndex % FRAMES_IN_FLIGHT];
+		frame.bPending = false; // still not resolved after FRAMES_IN_FLIGHT frames, drop it rather than waiting
+		if (!ensureQueries(frame, passCount)) return;
+
+		frame.frameIndex = m_frameIndex;
+		frame.passesGeneration = m_passesGeneration;
+		frame.passIssued.assign(passCount, false);
+		Engine::d3dcontext().Begin(frame.disjoint);
+		frame.bPending = true;
+	}
+
+	void RenderGraphProfiler::endFrame()
+	{
+		FrameQueries& frame = m_queries[m_frameIndex % FRAMES_IN_FLIGHT];
+		if (frame.bPending && frame.frameIndex == m_frameIndex)
+			Engine::d3dcontext().End(frame.disjoint);
+	}
+
+	void RenderGraphProfiler::beginPass(size_t passIndex, const std::string& name)
+	{
+		PassHistory& pass = m_history[passIndex];
+		if (pass.name != name) pass.name = name;
+
+		FrameQueries& frame = m_queries[m_frameIndex % FRAMES_IN_FLIGHT];
+		if (frame.bPending && frame.frameIndex == m_frameIndex)
+			Engine::d3dcontext().End(frame.passes[passIndex].first);
+
+		m_passStartCounts[passIndex] = m_clock.getTimeAsCount();
+	}
+
+	void RenderGraphProfiler::endPass(size_t passIndex)
+	{
+		const int64_t endCount = m_clock.getTimeAsCount();
+		m_history[passIndex].cpuMs[getLatestSampleIndex()] = static_cast<float>(m_clock.getDeltaSeconds(m_passStartCounts[passIndex], endCount) * 1000.0);
+
+		FrameQueries& frame = m_queries[m_frameIndex % FRAMES_IN_FLIGHT];
+		if (frame.bPending && frame.frameIndex == m_frameIndex)
+		{
+			Engine::d3dcontext().End(frame.passes[passIndex].second);
+			frame.passIssued[passIndex] = true;
+		}
+	}
+
+	void RenderGraphProfiler::remapHistory(const std::vector<RenderPass*>& passes)
+	{
+		// Passes that are still there keep their samples at their new index, new ones start empty
+		std::vector<PassHistory> history(passes.size());
+		for (size_t passIndex = 0; passIndex < passes.size(); passIndex++)
+		{
+			auto previous = std::ranges::find(m_passes, passes[passIndex]);
+			if (previous != m_passes.end())
+				history[passIndex] = std::move(m_history[std::distance(m_passes.begin(), previous)]);
+		}
+		m_history = std::move(history);
+		m_passes.assign(passes.begin(), passes.end());
+		m_passStartCounts.assign(passes.size(), 0);
+
+		// Queries in flight were issued with the previous indices, they are dropped when resolved
+		m_passesGeneration++;
+	}
+
+	bool RenderGraphProfiler::ensureQueries(FrameQueries& frame, size_t passCount)
+	{
+		auto& device = Engine::d3ddevice();
+		auto createQuery = [&](D3D11_QUERY type, ID3D11Query** outQuery) {
+			D3D11_QUERY_DESC desc{ .Query = type, .MiscFlags = 0 };
+			if (SUCCEEDED(device.CreateQuery(&desc, outQuery))) return true;
+			PYR_LOG(LogRenderGraph, WARN, "Could not create timestamp queries, GPU pass timings are disabled");
+			m_bGpuTimingSupported = false;
+			return false;
+		};
+
+		if (!frame.disjoint && !createQuery(D3D11_QUERY_TIMESTAMP_DISJOINT, &frame.disjoint))
+			return false;
+
+		while (frame.passes.size() < passCount)
+		{
+			std::pair<ID3D11Query*, ID3D11Query*> timestamps{};
+			if (!createQuery(D3D11_QUERY_TIMESTAMP, &timestamps.first) || !createQuery(D3D11_QUERY_TIMESTAMP, &timestamps.second))
+			{
+				DXRelease(timestamps.first);
+				return false;
+			}
+			frame.passes.push_back(timestamps);
+		}
+		return true;
+	}
+
+	void RenderGraphProfiler::resolvePendingQueries()
+	{
+		auto& context = Engine::d3dcontext();
+
+		for (FrameQueries& frame : m_queries)
+		{
+			if (!frame.bPending || frame.frameIndex == m_frameIndex) continue;
+
+			// DONOTFLUSH + S_FALSE means not ready yet, try again next frame
+			D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+			if (context.GetData(frame.disjoint, &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) continue;
+			frame.bPending = false;
+
+			if (disjoint.Disjoint || frame.passesGeneration != m_passesGeneration || m_frameIndex - frame.frameIndex >= HISTORY_SIZE) continue;
+
+			const size_t sample = frame.frameIndex % HISTORY_SIZE;
+			for (size_t passIndex = 0; passIndex < frame.passIssued.size(); passIndex++)
+			{
+				if (!frame.passIssued[passIndex]) continue;
+
+				UINT64 begin = 0, end = 0;
+				if (context.GetData(frame.passes[passIndex].first, &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) continue;
+				if (context.GetData(frame.passes[passIndex].second, &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) continue;
+
+				m_history[passIndex].gpuMs[sample] = static_cast<float>(static_cast<double>(end - begin) / static_cast<double>(disjoint.Frequency) * 1000.0);
+			}
+		}
+	}
+
+	void RenderGraphProfiler::releaseQueries()
+	{
+		for (FrameQueries& frame : m_queries)
+		{
+			DXRelease(frame.disjoint);
+			for (auto& [begin, end] : frame.passes)
+			{
+				DXRelease(begin);
+				DXRelease(end);
+			}
+			frame.passes.clear();
+			frame.bPending = false;
+		}
+	}
+
+	// Every field is quoted, quotes inside are doubled: pass names may hold commas, quotes or line breaks
+	static std::string QuoteCSVField(const std::string& field)
+	{
+		std::string quoted = "\"";
+		for (char c : field)
+		{
+			if (c == '"') quoted += '"';
+			quoted += c;
+		}
+		return quoted + '"';
+	}
+
+	void RenderGraphProfiler::dumpToCSV(const std::filesystem::path& path) const
+	{
+		std::ofstream file{ path };
+		if (!file)
+		{
+			std::string pathString = path.string();
+			PYR_LOGF(LogRenderGraph, WARN, "Could not open {} to dump the pass timings", pathString);
+			return;
+		}
+
+		file << "\"frame\",\"pass\",\"cpu_ms\",\"gpu_ms\"\n";
+		for (size_t i = 0; i < HISTORY_SIZE; i++)
+		{
+			// Skip the samples that were never recorded
+			const size_t framesAgo = HISTORY_SIZE - 1 - i;
+			if (framesAgo >= m_frameIndex) continue;
+
+			const size_t sample = (getHistoryOffset() + i) % HISTORY_SIZE;
+			for (const PassHistory& pass : m_history)
+				file << QuoteCSVField(std::to_string(m_frameIndex - framesAgo)) << "," << QuoteCSVField(pass.name) << ","
+					<< QuoteCSVField(std::to_string(pass.cpuMs[sample])) << "," << QuoteCSVField(std::to_string(pass.gpuMs[sample])) << "\n";
+		}
+	}
+
+	void RenderGraphProfiler::dumpToJSON(const std::filesystem::path& path) const
+	{
+		std::ofstream file{ path };
+		if (!file)
+		{
+			std::string pathString = path.string();
+			PYR_LOGF(LogRenderGraph, WARN, "Could not open {} to dump the pass timings", pathString);
+			return;
+		}
+
+		auto writeSamples = [&](const std::array<float, HISTORY_SIZE>& samples) {
+			file << "[";
+			bool bFirst = true;
+			for (size_t i = 0; i < HISTORY_SIZE; i++)
+			{
+				if (HISTORY_SIZE - 1 - i >= m_frameIndex) continue;
+				file << (bFirst ? "" : ",") << samples[(getHistoryOffset() + i) % HISTORY_SIZE];
+				bFirst = false;
+			}
+			file << "]";
+		};
+
+		file << "{\n  \"lastFrame\": " << m_frameIndex << ",\n  \"passes\": [\n";
+		for (size_t passIndex = 0; passIndex < m_history.size(); passIndex++)
+		{
+			const PassHistory& pass = m_history[passIndex];
+			std::string escapedName;
+			for (char c : pass.name)
+			{
+				if (c == '"' || c == '\\') escapedName += '\\';
+				escapedName += c;
+			}
+
+			file << "    { \"name\": \"" << escapedName << "\", \"cpu_ms\": ";
+			writeSamples(pass.cpuMs);
+			file << ", \"gpu_ms\": ";
+			writeSamples(pass.gpuMs);
+			file << " }" << (passIndex + 1 < m_history.size() ? "," : "") << "\n";
+		}
+		file << "  ]\n}\n";
+	}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "utils/clock.h"
+
+struct ID3D11Query;
+
+namespace pyr
+{
+    class RenderPass;
+
+    // Records CPU and GPU time of every pass of a render graph.
+    // GPU timings come from timestamp queries that are read back a few frames later, without ever waiting on the GPU.
+    // If the queries can't be created the GPU columns just stay at 0, CPU timings do not depend on them.
+    class RenderGraphProfiler
+    {
+    public:
+
+        static constexpr size_t HISTORY_SIZE = 300;
+        static constexpr size_t FRAMES_IN_FLIGHT = 4; // how many frames of queries we keep before reusing them
+
+        struct PassHistory
+        {
+            std::string name;
+            std::array<float, HISTORY_SIZE> cpuMs{};
+            std::array<float, HISTORY_SIZE> gpuMs{};
+        };
+
+        RenderGraphProfiler() = default;
+        ~RenderGraphProfiler();
+        RenderGraphProfiler(const RenderGraphProfiler&) = delete;
+        RenderGraphProfiler& operator=(const RenderGraphProfiler&) = delete;
+
+        // History rows follow their pass when the pass list changes, see remapHistory
+        void beginFrame(const std::vector<RenderPass*>& passes);
+        void endFrame();
+        void beginPass(size_t passIndex, const std::string& name);
+        void endPass(size_t passIndex);
+
+        void setGpuTimingEnabled(bool bEnabled) { m_bGpuTimingEnabled = bEnabled; }
+        bool isGpuTimingAvailable() const noexcept { return m_bGpuTimingEnabled && m_bGpuTimingSupported; }
+
+        const std::vector<PassHistory>& getHistory() const noexcept { return m_history; }
+        // Index of the oldest sample in the ring buffers, use it as the offset when plotting
+        size_t getHistoryOffset() const noexcept { return (m_frameIndex + 1) % HISTORY_SIZE; }
+        size_t getLatestSampleIndex() const noexcept { return m_frameIndex % HISTORY_SIZE; }
+
+        // Writes the history, oldest frame first. GPU times of the last few frames may not be resolved yet and are written as 0.
+        void dumpToCSV(const std::filesystem::path& path) const;
+        void dumpToJSON(const std::filesystem::path& path) const;
+
+    private:
+
+        struct FrameQueries
+        {
+            ID3D11Query* disjoint = nullptr;
+            std::vector<std::pair<ID3D11Query*, ID3D11Query*>> passes; // begin/end timestamps
+            std::vector<bool> passIssued;
+            size_t frameIndex = 0;
+            uint32_t passesGeneration = 0; // the pass indices of the queries are only valid for that generation
+            bool bPending = false;
+        };
+
+        void remapHistory(const std::vector<RenderPass*>& passes);
+        bool ensureQueries(FrameQueries& frame, size_t passCount);
+        void resolvePendingQueries();
+        void releaseQueries();
+
+        PerformanceClock m_clock;
+        std::vector<int64_t> m_passStartCounts;
+
+        std::vector<PassHistory> m_history;
+        std::vector<const RenderPass*> m_passes; // the pass of each history row
+        uint32_t m_passesGeneration = 0;
+        size_t m_frameIndex = 0;
+
+        std::array<FrameQueries, FRAMES_IN_FLIGHT> m_queries;
+        bool m_bGpuTimingEnabled = true;
+        bool m_bGpuTimingSupported = true;
+    };
+
+}
@@ -3,9 +3,11 @@
 // Defines an object that takes named entries and named output and draws in a target fbo
 
 #include "NamedResources.h"
+#include "TransientResourcePool.h"
 #include "utils/Debug.h"
-#include <set>
+#include <algorithm>
 #include <optional>
+#include <vector>
 
 static inline PYR_DEFINELOG(LogRenderPass, VERBOSE);
 
@@ -15,12 +17,29 @@ namespace pyr
     {
     protected:
 
+        // Render targets owned by the graph, the framebuffer is only valid once the graph has been compiled and may be shared with other passes
+        struct TransientTarget
+        {
+            ResourceID id;
+            TransientTextureDesc desc;
+            FrameBuffer* target = nullptr;
+            bool bExposed = false; // see producesTransient
+        };
+
+        struct ResourceOutput
+        {
+            ResourceID id;
+            Texture res;
+            ResourceHandle<FrameBuffer> transient; // when valid, res is fetched from the transient once allocated
+            FrameBuffer::Target exposedTarget = FrameBuffer::COLOR_0;
+        };
 
-        // this is temp. Maybe we should have a resource manager for the whole graph or somtuhing. idk
-        std::unordered_map<std::string, NamedInput> m_inputs; // this is what the pass has as inputs
-        std::unordered_map<std::string, ResourceGetter> m_outputs;
+        // Everything is resolved by index, ids are only looked up when wiring the graph
+        std::vector<NamedInput> m_inputs; // this is what the pass has as inputs
+        std::vector<ResourceOutput> m_outputs;
+        std::vector<TransientTarget> m_transients;
 
-        std::set<std::string> m_requirements;
+        friend class RenderGraph;
 
     public:
 
@@ -41,34 +60,94 @@ namespace pyr
         virtual void update(float dt) {}; // should be useless, idk yet
 
 
-        void producesResource(const char* resName, Texture textureHandle) {
-            m_outputs[resName] = [textureHandle]() -> Texture { return textureHandle; };
+        void producesResource(TextureResourceID id, Texture textureHandle) {
+            findOrAddOutput(id).res = textureHandle;
+        }
+
+        // Asks the graph for a render target that only needs to live during this pass (and the passes reading it, see producesTransient)
+        ResourceHandle<FrameBuffer> declareTransient(ResourceID id, TransientTextureDesc desc)
+        {
+            m_transients.push_back(TransientTarget{ .id = id, .desc = desc });
+            return ResourceHandle<FrameBuffer>{ static_cast<uint16_t>(m_transients.size() - 1) };
         }
 
-        void addNamedInput(const NamedInput& input) { m_inputs[input.label] = input; }
+        // Same as declareTransient, but also exposes one target of the framebuffer as a named output.
+        // Outputs are read outside of the graph (getters, debug views, the editor), exposed transients are never aliased.
+        ResourceHandle<FrameBuffer> producesTransient(TextureResourceID id, TransientTextureDesc desc, FrameBuffer::Target exposedTarget)
+        {
+            ResourceHandle<FrameBuffer> handle = declareTransient(id, desc);
+            m_transients[handle.index].bExposed = true;
+            ResourceOutput& output = findOrAddOutput(id);
+            output.transient = handle;
+            output.exposedTarget = exposedTarget;
+            return handle;
+        }
+
+        FrameBuffer& getTransient(ResourceHandle<FrameBuffer> handle)
+        {
+            TransientTarget& transient = m_transients[handle.index];
+            PYR_ASSERT(transient.target, "Transient target was not allocated, has the pass been added to a render graph ?");
+            return *transient.target;
+        }
+
+        // Reserves an input slot, call in the constructor and keep the handle to access the input when applying the pass
+        ResourceHandle<Texture> declareInput(TextureResourceID id) { return findOrAddInput(id); }
+
+        // Returns nullptr if nothing was linked to this input, or if its producer is disabled
+        NamedInput* getInput(ResourceHandle<Texture> handle) noexcept
+        {
+            NamedInput& input = m_inputs[handle.index];
+            if (!input.origin || !input.origin->m_bIsEnabled) return nullptr;
+            return &input;
+        }
 
-        // This is bad
-        std::optional<NamedOutput> getOutputResource(const char* resName) noexcept
+        void addNamedInput(const NamedInput& input)
         {
-            if (m_outputs.contains(resName)) return NamedOutput 
-            {   
-                .label = resName, 
-                .res = m_outputs[resName](),
-                .origin = this, 
+            m_inputs[findOrAddInput(input.id).index] = input;
+        }
+
+        std::optional<NamedOutput> getOutputResource(ResourceID id) noexcept
+        {
+            auto it = std::ranges::find(m_outputs, id, &ResourceOutput::id);
+            if (it != m_outputs.end()) return NamedOutput
+            {
+                .id = id,
+                .res = it->res,
+                .origin = this,
             };
 
             return std::nullopt;
         }
-        std::optional<NamedInput> getInputResource(std::string_view resName) const noexcept
+
+    private:
+
+        ResourceHandle<Texture> findOrAddInput(ResourceID id)
         {
-            if (m_inputs.contains(std::string(resName)))
+            auto it = std::ranges::find(m_inputs, id, &NamedInput::id);
+            if (it == m_inputs.end())
             {
-                const NamedInput& namedInput = m_inputs.at(std::string(resName));
-                if (!namedInput.origin->m_bIsEnabled) return std::nullopt;
-                return namedInput;
+                m_inputs.push_back(NamedInput{ .id = id });
+                it = std::prev(m_inputs.end());
             }
+            return ResourceHandle<Texture>{ static_cast<uint16_t>(std::distance(m_inputs.begin(), it)) };
+        }
 
-            return std::nullopt;
+        ResourceOutput& findOrAddOutput(ResourceID id)
+        {
+            auto it = std::ranges::find(m_outputs, id, &ResourceOutput::id);
+            if (it != m_outputs.end()) return *it;
+            return m_outputs.emplace_back(ResourceOutput{ .id = id });
+        }
+
+        // Called by the graph once the transients have been (re)allocated
+        void resolveTransientOutputs()
+        {
+            for (ResourceOutput& output : m_outputs)
+            {
+                if (!output.transient.isValid()) continue;
+                FrameBuffer* target = m_transients[output.transient.index].target;
+                output.res = target ? target->getTargetAsTexture(output.exposedTarget) : Texture{};
+            }
         }
 
     };
@@ -0,0 +1,84 @@
+#include "TransientResourcePool.h"
+
+#include <algorithm>
+
+#include "engine/Device.h"
+#include "display/GpuMemory.h"
+
+namespace pyr
+{
+
+	uint32_t TransientTextureDesc::getWidth() const
+	{
+		if (!bWindowRelative) return width;
+		return std::max<uint32_t>(1U, static_cast<uint32_t>(static_cast<float>(Device::getWinWidth()) * scale));
+	}
+
+	uint32_t TransientTextureDesc::getHeight() const
+	{
+		if (!bWindowRelative) return height;
+		return std::max<uint32_t>(1U, static_cast<uint32_t>(static_cast<float>(Device::getWinHeight()) * scale));
+	}
+
+	// Read from the textures the framebuffer created, whatever their format and sample count
+	static size_t GetByteSize(const FrameBuffer& framebuffer, FrameBuffer::target_t targets)
+	{
+		size_t byteSize = 0;
+		for (FrameBuffer::Target target : { FrameBuffer::COLOR_0, FrameBuffer::DEPTH_STENCIL })
+		{
+			if (targets & target)
+				byteSize += GpuMemory::EstimateByteSize(framebuffer.getTargetAsTexture(target).getRawResource());
+		}
+		return byteSize;
+	}
+
+	void TransientResourcePool::allocate(std::vector<Request> requests)
+	{
+		m_stats = {};
+		m_stats.transientCount = requests.size();
+
+		for (PhysicalTarget& physical : m_targets)
+			physical.bInUse = false;
+
+		// Greedy interval assignment, sorted by first use so that a freed target is always picked up by the next transient that fits
+		std::ranges::stable_sort(requests, {}, &Request::firstUse);
+
+		for (const Request& request : requests)
+		{
+			const uint32_t width = request.desc.getWidth();
+			const uint32_t height = request.desc.getHeight();
+
+			auto compatible = std::ranges::find_if(m_targets, [&](const PhysicalTarget& physical) {
+				return physical.width == width
+					&& physical.height == height
+					&& physical.targets == request.desc.targets
+					&& (!physical.bInUse || physical.busyUntil < request.firstUse);
+			});
+
+			if (compatible == m_targets.end())
+			{
+				m_targets.push_back(PhysicalTarget{
+					.width = width,
+					.height = height,
+					.targets = request.desc.targets,
+					.framebuffer = std::make_unique<FrameBuffer>(width, height, request.desc.targets),
+				});
+				compatible = std::prev(m_targets.end());
+				compatible->byteSize = GetByteSize(*compatible->framebuffer, compatible->targets);
+			}
+			m_stats.bytesWithoutAliasing += compatible->byteSize;
+
+			compatible->bInUse = true;
+			compatible->busyUntil = request.lastUse;
+			*request.outTarget = compatible->framebuffer.get();
+		}
+
+		// Whatever was not picked up is stale (old window size, removed pass...), no need to keep it around
+		std::erase_if(m_targets, [](const PhysicalTarget& physical) { return !physical.bInUse; });
+
+		m_stats.physicalCount = m_targets.size();
+		for (const PhysicalTarget& physical : m_targets)
+			m_stats.bytesWithAliasing += physical.byteSize;
+	}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "display/FrameBuffer.h"
+
+namespace pyr
+{
+    // Describes a render target a pass wants the graph to own for it, either a fixed size or a fraction of the window.
+    struct TransientTextureDesc
+    {
+        FrameBuffer::target_t targets = FrameBuffer::COLOR_0;
+        uint32_t width = 0, height = 0; // only used when not window relative
+        bool bWindowRelative = true;
+        float scale = 1.F;
+
+        static TransientTextureDesc WindowSized(FrameBuffer::target_t targets, float scale = 1.F)
+        {
+            return TransientTextureDesc{ .targets = targets, .bWindowRelative = true, .scale = scale };
+        }
+
+        static TransientTextureDesc Fixed(uint32_t width, uint32_t height, FrameBuffer::target_t targets)
+        {
+            return TransientTextureDesc{ .targets = targets, .width = width, .height = height, .bWindowRelative = false };
+        }
+
+        uint32_t getWidth() const;
+        uint32_t getHeight() const;
+    };
+
+    // Hands out framebuffers to the transients of a graph. Two transients with the same resolved size and targets
+    // share the same physical framebuffer as long as their lifetimes (first/last pass index using them) do not overlap.
+    // Physical framebuffers are kept between allocations, so recompiling the graph or resizing the window only creates what's missing.
+    class TransientResourcePool
+    {
+    public:
+
+        struct Request
+        {
+            TransientTextureDesc desc;
+            size_t firstUse, lastUse;   // pass indices, inclusive
+            FrameBuffer** outTarget;
+        };
+
+        struct Stats
+        {
+            size_t transientCount = 0;
+            size_t physicalCount = 0;
+            size_t bytesWithoutAliasing = 0; // what we would have if every transient owned its framebuffer
+            size_t bytesWithAliasing = 0;    // what is actually allocated
+        };
+
+        void allocate(std::vector<Request> requests);
+        void clear() { m_targets.clear(); m_stats = {}; }
+
+        const Stats& getStats() const noexcept { return m_stats; }
+
+    private:
+
+        struct PhysicalTarget
+        {
+            uint32_t width, height;
+            FrameBuffer::target_t targets;
+            std::unique_ptr<FrameBuffer> framebuffer;
+            size_t byteSize = 0;
+            size_t busyUntil = 0;
+            bool bInUse = false;
+        };
+
+        std::vector<PhysicalTarget> m_targets;
+        Stats m_stats;
+    };
+
+}
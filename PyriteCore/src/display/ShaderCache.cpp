@@ -0,0 +1,279 @@
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include <d3dcompiler.h>
+
+#include "engine/Directxlib.h"
+#include "utils/Clock.h"
+
+namespace pyr
+{
+
+	ShaderCache ShaderCache::s_singleton;
+
+	// FNV-1a, must give the same results from one run to the next
+	static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+
+	static std::string ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream in{ path, std::ios::binary };
+		return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	}
+
+	// Serves includes from the ShaderCache and records each file opened, nested includes included
+	struct RecordingIncludeHandler final : ID3DInclude
+	{
+		ShaderCache& cache;
+		std::vector<std::pair<std::string, uint64_t>> opened;
+		std::vector<std::shared_ptr<const std::string>> openedContents; // kept alive until the compilation ends
+
+		explicit RecordingIncludeHandler(ShaderCache& cache) : cache(cache) {}
+
+		STDMETHOD(Open)(D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes) override
+		{
+			uint64_t contentHash = 0;
+			std::shared_ptr<const std::string> contents = cache.getInclude(pFileName, &contentHash);
+			// Failing lets the compiler report the missing include, instead of compiling against an empty file
+			if (!contents) return E_FAIL;
+			opened.emplace_back(pFileName, contentHash);
+			*ppData = contents->data();
+			*pBytes = static_cast<UINT>(contents->size());
+			openedContents.push_back(std::move(contents));
+			return S_OK;
+		}
+		STDMETHOD(Close)(LPCVOID pData) override
+		{
+			return S_OK;
+		}
+	};
+
+	std::shared_ptr<const std::string> ShaderCache::getInclude(const std::string& name, uint64_t* outContentHash /* = nullptr */)
+	{
+		const std::filesystem::path path = std::filesystem::path(INCLUDE_DIRECTORY) / name;
+		std::error_code error;
+		const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+		if (error) return nullptr;
+
+		std::lock_guard lock(m_includesMutex);
+		CachedInclude& include = m_includes[name];
+		if (!include.contents || include.writeTime != writeTime)
+		{
+			const std::string contents = ReadFile(path);
+			include.contentHash = HashBytes(HASH_SEED, contents.data(), contents.size());
+			include.contents = std::make_shared<const std::string>(contents);
+			include.writeTime = writeTime;
+		}
+		if (outContentHash) *outContentHash = include.contentHash;
+		return include.contents;
+	}
+
+	uint32_t ShaderCache::GetCompileFlags()
+	{
+#ifdef PYR_ISDEBUG
+		return D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+		return D3DCOMPILE_OPTIMIZATION_LEVEL3;
+#endif
+	}
+
+	std::filesystem::path ShaderCache::GetCacheFilePath(const std::filesystem::path& path, const std::vector<Effect::define_t>& defines, uint32_t flags)
+	{
+		std::vector<const Effect::define_t*> sortedDefines;
+		for (const Effect::define_t& define : defines)
+			sortedDefines.push_back(&define);
+		std::ranges::sort(sortedDefines, [](const Effect::define_t* a, const Effect::define_t* b) { return a->name < b->name; });
+
+		// Strings are hashed with their terminating 0 so that {"AB",""} and {"A","B"} differ
+		const std::string pathString = std::filesystem::weakly_canonical(path).generic_string();
+		uint64_t key = HashBytes(HASH_SEED, pathString.c_str(), pathString.size() + 1);
+		for (const Effect::define_t* define : sortedDefines)
+		{
+			key = HashBytes(key, define->name.c_str(), define->name.size() + 1);
+			key = HashBytes(key, define->value.c_str(), define->value.size() + 1);
+		}
+		key = HashBytes(key, &flags, sizeof(flags));
+
+		return std::filesystem::path(CACHE_DIRECTORY) / std::format("{}.{:016x}.fxo", path.stem().string(), key);
+	}
+
+	bool ShaderCache::readCacheFile(const std::filesystem::path& cacheFile, uint64_t sourceHash, CompiledEffect& outEffect)
+	{
+		std::error_code error;
+		const uint64_t fileSize = std::filesystem::file_size(cacheFile, error);
+		if (error) return false;
+
+		std::ifstream file{ cacheFile, std::ios::binary };
+		if (!file) return false;
+
+		auto readValue = [&file]<class T>(T& value) { return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T))); };
+		// Sizes read from the file are checked against what it holds, a damaged file is a miss and not a huge allocation
+		auto fits = [&file, fileSize](uint64_t byteCount)
+		{
+			const std::streamoff position = file.tellg();
+			return position >= 0 && byteCount <= fileSize - static_cast<uint64_t>(position);
+		};
+
+		uint32_t magic = 0, version = 0, dependencyCount = 0;
+		uint64_t cachedSourceHash = 0;
+		if (!readValue(magic) || !readValue(version) || !readValue(cachedSourceHash) || !readValue(dependencyCount))
+			return false;
+		if (magic != CACHE_FILE_MAGIC || version != CACHE_VERSION || cachedSourceHash != sourceHash)
+			return false;
+
+		for (uint32_t i = 0; i < dependencyCount; i++)
+		{
+			uint32_t nameLength = 0;
+			uint64_t contentHash = 0;
+			if (!readValue(nameLength) || !fits(nameLength)) return false;
+			std::string name(nameLength, '\0');
+			if (!file.read(name.data(), nameLength) || !readValue(contentHash))
+				return false;
+			uint64_t currentHash = 0;
+			if (!getInclude(name, &currentHash) || currentHash != contentHash)
+				return false;
+			outEffect.includes.push_back(std::move(name));
+		}
+
+		uint64_t bytecodeSize = 0;
+		if (!readValue(bytecodeSize) || !fits(bytecodeSize)) return false;
+		outEffect.bytecode.resize(bytecodeSize);
+		return static_cast<bool>(file.read(outEffect.bytecode.data(), bytecodeSize));
+	}
+
+	void ShaderCache::WriteCacheFile(const std::filesystem::path& cacheFile, uint64_t sourceHash, const std::vector<Dependency>& dependencies, const std::vector<char>& bytecode)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(cacheFile.parent_path(), error);
+
+		// Written aside and renamed, a run interrupted halfway or another thread reading the file never sees it incomplete
+		std::filesystem::path temporaryFile = cacheFile;
+		temporaryFile += std::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+		{
+			std::ofstream file{ temporaryFile, std::ios::binary };
+			auto writeValue = [&file]<class T>(const T& value) { file.write(reinterpret_cast<const char*>(&value), sizeof(T)); };
+
+			writeValue(CACHE_FILE_MAGIC);
+			writeValue(CACHE_VERSION);
+			writeValue(sourceHash);
+			writeValue(static_cast<uint32_t>(dependencies.size()));
+			for (const Dependency& dependency : dependencies)
+			{
+				writeValue(static_cast<uint32_t>(dependency.name.size()));
+				file.write(dependency.name.data(), dependency.name.size());
+				writeValue(dependency.contentHash);
+			}
+			writeValue(static_cast<uint64_t>(bytecode.size()));
+			file.write(bytecode.data(), bytecode.size());
+			if (!file)
+				error = std::make_error_code(std::errc::io_error);
+		}
+		if (!error)
+			std::filesystem::rename(temporaryFile, cacheFile, error);
+		if (error)
+		{
+			const std::string cacheFileName = cacheFile.string();
+			PYR_LOGF(LogShaderCache, WARN, "Could not write the shader cache file {}", cacheFileName);
+			std::filesystem::remove(temporaryFile, error);
+		}
+	}
+
+	ShaderCache::CompiledEffect ShaderCache::getEffectBytecode(const std::filesystem::path& path, const std::vector<Effect::define_t>& defines)
+	{
+		CompiledEffect compiledEffect;
+		const std::string source = ReadFile(path);
+		if (source.empty())
+		{
+			compiledEffect.errors = "Could not read " + path.string();
+			return compiledEffect;
+		}
+
+		const uint32_t flags = GetCompileFlags();
+		const uint64_t sourceHash = HashBytes(HASH_SEED, source.data(), source.size());
+		const std::filesystem::path cacheFile = GetCacheFilePath(path, defines, flags);
+
+		if (readCacheFile(cacheFile, sourceHash, compiledEffect))
+		{
+			std::lock_guard lock(m_statsMutex);
+			m_stats.hits++;
+			return compiledEffect;
+		}
+		compiledEffect = {};
+
+		std::vector<D3D_SHADER_MACRO> macros;
+		for (const auto& [name, value] : defines)
+			macros.push_back(D3D_SHADER_MACRO{ name.c_str(), value.c_str() });
+		macros.push_back(D3D_SHADER_MACRO{ nullptr, nullptr });
+
+		PerformanceClock clock;
+		const int64_t start = clock.getTimeAsCount();
+
+		RecordingIncludeHandler includes{ *this };
+		ID3DBlob* compiled = nullptr;
+		ID3DBlob* errors = nullptr;
+		const std::string sourceName = path.string();
+		HRESULT hr = D3DCompile(source.data(), source.size(), sourceName.c_str(), macros.data(), &includes, "", "fx_5_0", flags, D3DCOMPILE_EFFECT_ALLOW_SLOW_OPS, &compiled, &errors);
+
+		const double compileSeconds = clock.getDeltaSeconds(start, clock.getTimeAsCount());
+		{
+			std::lock_guard lock(m_statsMutex);
+			m_stats.misses++;
+			m_stats.compileSeconds += compileSeconds;
+			if (FAILED(hr)) m_stats.failures++;
+		}
+
+		if (FAILED(hr))
+		{
+			compiledEffect.errors = errors ? static_cast<const char*>(errors->GetBufferPointer()) : "Could not compile an effect, no error message";
+			DXRelease(errors);
+			DXRelease(compiled);
+			return compiledEffect;
+		}
+
+		const char* bytes = static_cast<const char*>(compiled->GetBufferPointer());
+		compiledEffect.bytecode.assign(bytes, bytes + compiled->GetBufferSize());
+		DXRelease(compiled);
+		DXRelease(errors);
+
+		std::vector<Dependency> dependencies;
+		for (auto& [name, contentHash] : includes.opened)
+			if (std::ranges::none_of(dependencies, [&name](const Dependency& dependency) { return dependency.name == name; }))
+				dependencies.push_back(Dependency{ .name = std::move(name), .contentHash = contentHash });
+		WriteCacheFile(cacheFile, sourceHash, dependencies, compiledEffect.bytecode);
+		for (const Dependency& dependency : dependencies)
+			compiledEffect.includes.push_back(dependency.name);
+
+		const double compileMilliseconds = compileSeconds * 1000.;
+		PYR_LOGF(LogShaderCache, INFO, "Compiled {} in {:.0f} ms", sourceName, compileMilliseconds);
+		return compiledEffect;
+	}
+
+	ShaderCache::Stats ShaderCache::getStats() const
+	{
+		std::lock_guard lock(m_statsMutex);
+		return m_stats;
+	}
+
+	void ShaderCache::logStats() const
+	{
+		const Stats stats = getStats();
+		PYR_LOGF(LogShaderCache, INFO, "{} effects read from the cache, {} compiled ({} failed) in {:.2f} s",
+			stats.hits, stats.misses, stats.failures, stats.compileSeconds);
+	}
+
+}
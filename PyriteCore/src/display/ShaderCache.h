@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "display/shader.h"
+#include "utils/Debug.h"
+
+static inline PYR_DEFINELOG(LogShaderCache, VERBOSE);
+
+namespace pyr
+{
+
+// Compiles effects to fx_5_0 bytecode and keeps the result on disk, in CACHE_DIRECTORY, so that warm starts compile nothing.
+// There is one cache file per effect permutation, identified by the effect path, its define set (in any order) and the compile flags.
+// The file is reused as long as the effect source and every file it includes, transitively, have the same content hash as when it
+// was compiled. Includes are recorded by the include handler during the compilation.
+//
+// Include files are kept in memory and only read again when their write time changes, effects share most of their includes.
+//
+// Thread safe, several effects can be compiled at once.
+class ShaderCache
+{
+public:
+
+    struct Stats
+    {
+        uint32_t hits = 0;
+        uint32_t misses = 0;   // effects compiled, because their cache file was missing or outdated
+        uint32_t failures = 0; // compilation errors
+        double compileSeconds = 0;
+    };
+
+    // Includes are listed whether the effect was compiled or read from the cache
+    struct CompiledEffect
+    {
+        std::vector<char> bytecode; // empty if the effect does not compile
+        std::vector<std::string> includes; // relative to INCLUDE_DIRECTORY, transitive
+        std::string errors;
+    };
+
+    static constexpr const char* CACHE_DIRECTORY = "res/shaders/.cache";
+    static constexpr const char* INCLUDE_DIRECTORY = "res/shaders";
+
+    static ShaderCache& get() { return s_singleton; }
+
+    // Debug builds keep the shaders debuggable, release builds optimize them
+    static uint32_t GetCompileFlags();
+
+    CompiledEffect getEffectBytecode(const std::filesystem::path& path, const std::vector<Effect::define_t>& defines);
+
+    // Returns the content of a file of INCLUDE_DIRECTORY, null if it does not exist
+    std::shared_ptr<const std::string> getInclude(const std::string& name, uint64_t* outContentHash = nullptr);
+
+    Stats getStats() const;
+    void logStats() const;
+
+private:
+
+    static constexpr uint32_t CACHE_FILE_MAGIC = 0x53525950; // "PYRS"
+    static constexpr uint32_t CACHE_VERSION = 1;             // bump to invalidate every cache file
+
+    struct Dependency
+    {
+        std::string name; // as given to the include directive, relative to res/shaders
+        uint64_t contentHash = 0;
+    };
+
+    ShaderCache() = default;
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    static std::filesystem::path GetCacheFilePath(const std::filesystem::path& path, const std::vector<Effect::define_t>& defines, uint32_t flags);
+    bool readCacheFile(const std::filesystem::path& cacheFile, uint64_t sourceHash, CompiledEffect& outEffect);
+    static void WriteCacheFile(const std::filesystem::path& cacheFile, uint64_t sourceHash, const std::vector<Dependency>& dependencies, const std::vector<char>& bytecode);
+
+private:
+
+    struct CachedInclude
+    {
+        std::filesystem::file_time_type writeTime;
+        std::shared_ptr<const std::string> contents;
+        uint64_t contentHash = 0;
+    };
+
+    mutable std::mutex m_statsMutex;
+    Stats m_stats;
+
+    std::mutex m_includesMutex;
+    std::unordered_map<std::string, CachedInclude> m_includes;
+
+    static ShaderCache s_singleton;
+};
+
+}
@@ -0,0 +1,428 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cwctype>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "ddstextureloader/DDSTextureLoader11.h"
+#include "display/GpuMemory.h"
+#include "engine/Directxlib.h"
+#include "engine/Engine.h"
+#include "utils/StringUtils.h"
+
+namespace pyr
+{
+
+	TextureCache TextureCache::s_singleton;
+
+	std::wstring TextureCache::MakeKey(const std::filesystem::path& path, bool bGenerateMips)
+	{
+		std::error_code error;
+		std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+		if (error) canonical = std::filesystem::absolute(path, error);
+		std::wstring key = canonical.lexically_normal().make_preferred().wstring();
+#ifdef _WIN32
+		// Windows paths are case insensitive
+		std::ranges::transform(key, key.begin(), [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+#endif
+		// The same file loaded with and without mips gives two different textures
+		key += bGenerateMips ? L"|mips" : L"|nomips";
+		return key;
+	}
+
+	uint64_t TextureCache::HashFileContent(const std::filesystem::path& path)
+	{
+		std::ifstream file{ path, std::ios::binary };
+		if (!file) return 0;
+
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		std::vector<char> buffer(1 << 16);
+		while (file)
+		{
+			file.read(buffer.data(), buffer.size());
+			for (std::streamsize i = 0; i < file.gcount(); i++)
+			{
+				hash ^= static_cast<uint8_t>(buffer[i]);
+				hash *= 1099511628211ull;
+			}
+		}
+		return hash;
+	}
+
+	bool TextureCache::ReadDDSExtent(const std::filesystem::path& path, size_t& width, size_t& height, uint32_t& mipCount)
+	{
+		// Magic number followed by the DDS_HEADER, only the fields up to the mip count are needed
+		std::ifstream file{ path, std::ios::binary };
+		uint32_t header[8]{};
+		if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != 0x20534444 /* "DDS " */)
+			return false;
+		height = header[3];
+		width = header[4];
+		mipCount = std::max(1u, header[7]);
+		return width > 0 && height > 0;
+	}
+
+	Texture TextureCache::LoadDDSMips(const std::filesystem::path& path, size_t maxSize)
+	{
+		// Only the device is used, it is free threaded unlike the immediate context
+		ID3D11Resource* resource = nullptr;
+		ID3D11ShaderResourceView* srv = nullptr;
+		if (FAILED(DirectX::CreateDDSTextureFromFileEx(&Engine::d3ddevice(), path.c_str(), maxSize, D3D11_USAGE_DEFAULT,
+			D3D11_BIND_SHADER_RESOURCE, 0, 0, DirectX::DDS_LOADER_DEFAULT, &resource, &srv)))
+			throw std::runtime_error("Could not load texture " + widestring2string(path.wstring()));
+
+		ID3D11Texture2D* texture2D = nullptr;
+		D3D11_TEXTURE2D_DESC desc{};
+		if (SUCCEEDED(resource->QueryInterface<ID3D11Texture2D>(&texture2D)))
+			texture2D->GetDesc(&desc);
+		DXRelease(texture2D);
+		return Texture{ resource, srv, desc.Width, desc.Height };
+	}
+
+	uint32_t TextureCache::CountDroppedMips(const CachedTexture& texture, const Texture& resident)
+	{
+		uint32_t droppedMips = 0;
+		while (droppedMips + 1 < texture.mipCount && (texture.fullWidth >> droppedMips) > resident.getWidth())
+			droppedMips++;
+		return droppedMips;
+	}
+
+	TextureCache::Handle TextureCache::acquire(const std::filesystem::path& path, bool bGenerateMips /* = true */, const ImageDecoder::DecodedImage* decoded /* = nullptr */)
+	{
+		const std::wstring key = MakeKey(path, bGenerateMips);
+
+		if (auto it = m_byPath.find(key); it != m_byPath.end())
+		{
+			if (Handle cached = it->second.lock())
+			{
+				m_stats.avoidedLoads++;
+				m_stats.savedBytes += cached->byteSize;
+				return cached;
+			}
+		}
+
+		uint64_t contentKey = 0;
+		if (m_bContentHashing)
+		{
+			contentKey = HashFileContent(path) ^ static_cast<uint64_t>(bGenerateMips);
+			if (auto it = m_byContent.find(contentKey); it != m_byContent.end())
+			{
+				if (Handle cached = it->second.lock())
+				{
+					m_byPath[key] = cached;
+					m_stats.avoidedLoads++;
+					m_stats.contentDuplicates++;
+					m_stats.savedBytes += cached->byteSize;
+					return cached;
+				}
+			}
+		}
+
+		Handle loaded{ new CachedTexture{ .key = key, .path = path, .bGenerateMips = bGenerateMips, .lastUsedFrame = m_frame },
+			[this](CachedTexture* released) { onReleased(released); } };
+
+		CachedTexture& texture = *loaded;
+		if (m_bStreaming && path.extension() == ".dds" && ReadDDSExtent(path, texture.fullWidth, texture.fullHeight, texture.mipCount)
+			&& texture.mipCount > 1 && std::max(texture.fullWidth, texture.fullHeight) > STREAMING_INITIAL_SIZE)
+		{
+			// Start with the least detailed mips only, the others are streamed in once the texture is seen on screen
+			Texture resident = LoadDDSMips(path, STREAMING_INITIAL_SIZE);
+			texture.bStreamed = true;
+			texture.requestedMip = texture.mipCount - 1;
+			setResident(texture, resident, CountDroppedMips(texture, resident));
+			// Each mip is a quarter of the previous one
+			texture.fullByteSize = texture.byteSize << (2 * texture.droppedMips);
+		}
+		else
+		{
+			setResident(texture, decoded
+				? TextureManager::createTexture(*decoded, bGenerateMips, widestring2string(path.wstring()))
+				: TextureManager::loadTexture(path.wstring(), bGenerateMips), 0);
+			texture.fullByteSize = texture.byteSize;
+		}
+
+		m_byPath[key] = loaded;
+		if (m_bContentHashing) m_byContent[contentKey] = loaded;
+		m_stats.loads++;
+		return loaded;
+	}
+
+	const Texture& TextureCache::use(const Handle& handle)
+	{
+		CachedTexture& texture = *handle;
+		texture.lastUsedFrame = m_frame;
+
+		if (texture.bEvicted)
+		{
+			// Streamed textures come back with their least detailed mips, like when first acquired
+			reload(texture, texture.bStreamed ? STREAMING_INITIAL_SIZE : 0);
+		}
+		else if (texture.droppedMips > 0 && !texture.bStreamed)
+		{
+			const size_t missingBytes = texture.fullByteSize - texture.byteSize;
+			if (GpuMemory::GetTotalBytes() + missingBytes <= static_cast<size_t>(m_memoryBudget * RELOAD_BUDGET_RATIO))
+				reload(texture);
+		}
+		return texture.texture;
+	}
+
+	void TextureCache::pin(const Handle& handle)
+	{
+		finishStreaming(*handle, true);
+		if (handle->bEvicted || handle->droppedMips > 0)
+			reload(*handle);
+		handle->bPinned = true;
+	}
+
+	void TextureCache::requestResolution(const Handle& handle, float texels)
+	{
+		CachedTexture& texture = *handle;
+		if (!texture.bStreamed) return;
+
+		// The least detailed mip that still has the requested resolution
+		const size_t fullSize = std::max(texture.fullWidth, texture.fullHeight);
+		uint32_t mip = 0;
+		while (mip + 1 < texture.mipCount && static_cast<float>(fullSize >> (mip + 1)) >= texels)
+			mip++;
+
+		if (texture.requestFrame != m_frame)
+			texture.requestedMip = mip;
+		else
+			texture.requestedMip = std::min(texture.requestedMip, mip);
+		texture.requestFrame = m_frame;
+	}
+
+	void TextureCache::beginFrame()
+	{
+		m_frame++;
+
+		std::vector<Handle> textures = collectResidentTextures();
+		for (const Handle& texture : textures)
+			finishStreaming(*texture, false);
+
+		if (GpuMemory::GetTotalBytes() > m_memoryBudget)
+			enforceBudget(textures);
+		streamMips(std::move(textures));
+	}
+
+	void TextureCache::enforceBudget(std::vector<Handle> candidates)
+	{
+		std::erase_if(candidates, [](const Handle& texture) { return texture->bPinned || texture->pendingLoad.valid(); });
+
+		// Streamed textures with more detail than what is seen on screen go first, then the least recently used ones
+		auto isOverDetailed = [this](const Handle& texture) {
+			return texture->bStreamed && texture->requestFrame + STREAMING_REQUEST_FRAMES >= m_frame && texture->droppedMips < texture->requestedMip;
+		};
+		std::ranges::sort(candidates, [&](const Handle& lhs, const Handle& rhs) {
+			const bool lhsOverDetailed = isOverDetailed(lhs), rhsOverDetailed = isOverDetailed(rhs);
+			if (lhsOverDetailed != rhsOverDetailed) return lhsOverDetailed;
+			return lhs->lastUsedFrame < rhs->lastUsedFrame;
+		});
+
+		// Textures that were not used for a while are dropped entirely
+		for (const Handle& texture : candidates)
+		{
+			if (GpuMemory::GetTotalBytes() <= m_memoryBudget) return;
+			if (texture->lastUsedFrame + EVICTION_DELAY_FRAMES > m_frame) continue;
+			evict(*texture);
+		}
+
+		// Then the others lose their most detailed mip, a few per frame to avoid hitches
+		uint32_t downgrades = 0;
+		for (const Handle& texture : candidates)
+		{
+			if (GpuMemory::GetTotalBytes() <= m_memoryBudget || downgrades >= MAX_DOWNGRADES_PER_FRAME) break;
+			if (!texture->bEvicted && downgrade(*texture))
+				downgrades++;
+		}
+
+		if (GpuMemory::GetTotalBytes() > m_memoryBudget && downgrades == 0)
+		{
+			const size_t usedMB = GpuMemory::GetTotalBytes() >> 20;
+			PYR_LOGF(LogTextureCache, VERBOSE, "Over the GPU memory budget with nothing left to evict or downgrade ({} MB used)", usedMB);
+		}
+	}
+
+	void TextureCache::finishStreaming(CachedTexture& texture, bool bWait)
+	{
+		if (!texture.pendingLoad.valid()) return;
+		if (!bWait && texture.pendingLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+		m_stats.streamingLoadsInFlight--;
+		try
+		{
+			Texture streamed = texture.pendingLoad.get();
+			setResident(texture, streamed, CountDroppedMips(texture, streamed));
+			m_stats.streamedLoads++;
+		}
+		catch (const std::runtime_error& error)
+		{
+			// Keep the resident mips, the texture won't be streamed again
+			texture.bStreamed = false;
+			const std::string message = error.what();
+			PYR_LOGF(LogTextureCache, WARN, "Could not stream a texture in: {}", message);
+		}
+	}
+
+	void TextureCache::streamMips(std::vector<Handle> candidates)
+	{
+		std::erase_if(candidates, [this](const Handle& texture) {
+			return !texture->bStreamed || texture->bEvicted || texture->pendingLoad.valid()
+				|| texture->requestFrame + STREAMING_REQUEST_FRAMES < m_frame || texture->requestedMip >= texture->droppedMips;
+		});
+		// Biggest differences between what is resident and what is seen on screen first
+		std::ranges::sort(candidates, std::ranges::greater{}, [](const Handle& texture) { return texture->droppedMips - texture->requestedMip; });
+
+		size_t inFlightBytes = 0;
+		for (const Handle& handle : candidates)
+		{
+			if (m_stats.streamingLoadsInFlight >= MAX_STREAMING_LOADS) break;
+			CachedTexture& texture = *handle;
+
+			// Stream in as many mips as the budget allows
+			const size_t availableBytes = static_cast<size_t>(m_memoryBudget * RELOAD_BUDGET_RATIO);
+			uint32_t targetMip = texture.requestedMip;
+			auto streamedBytes = [&](uint32_t mip) { return texture.byteSize << (2 * (texture.droppedMips - mip)); };
+			while (targetMip < texture.droppedMips && GpuMemory::GetTotalBytes() + inFlightBytes + streamedBytes(targetMip) > availableBytes)
+				targetMip++;
+			if (targetMip >= texture.droppedMips) continue;
+
+			const size_t maxSize = std::max(texture.fullWidth, texture.fullHeight) >> targetMip;
+			texture.pendingMip = targetMip;
+			texture.pendingLoad = std::async(std::launch::async, [path = texture.path, maxSize] { return LoadDDSMips(path, maxSize); });
+			inFlightBytes += streamedBytes(targetMip);
+			m_stats.streamingLoadsInFlight++;
+		}
+	}
+
+	std::vector<TextureCache::Handle> TextureCache::collectResidentTextures() const
+	{
+		// A texture may be known under several paths
+		std::vector<Handle> textures;
+		for (const auto& [_, cached] : m_byPath)
+			if (Handle texture = cached.lock(); texture && !texture->bEvicted)
+				textures.push_back(std::move(texture));
+		std::ranges::sort(textures);
+		textures.erase(std::ranges::unique(textures).begin(), textures.end());
+		return textures;
+	}
+
+	void TextureCache::setResident(CachedTexture& texture, Texture resident, uint32_t droppedMips)
+	{
+		m_stats.residentBytes -= std::min(m_stats.residentBytes, texture.byteSize);
+		texture.texture.releaseRawTexture();
+		texture.texture = resident;
+		// Textures loaded by the TextureManager are already tracked, tracking again only renames them
+		GpuMemory::Track(resident.getRawResource(), GpuMemory::Category::Texture, widestring2string(texture.path.wstring()));
+		texture.byteSize = GpuMemory::EstimateByteSize(resident.getRawResource());
+		texture.droppedMips = droppedMips;
+		texture.bEvicted = false;
+		m_stats.residentBytes += texture.byteSize;
+	}
+
+	void TextureCache::reload(CachedTexture& texture, size_t maxSize /* = 0 */)
+	{
+		try
+		{
+			if (texture.bStreamed)
+			{
+				Texture reloaded = LoadDDSMips(texture.path, maxSize);
+				setResident(texture, reloaded, CountDroppedMips(texture, reloaded));
+			}
+			else
+			{
+				setResident(texture, TextureManager::loadTexture(texture.path.wstring(), texture.bGenerateMips), 0);
+				texture.fullByteSize = texture.byteSize;
+			}
+			m_stats.reloads++;
+		}
+		catch (const std::runtime_error& error)
+		{
+			// The file may have been moved since it was first loaded, keep whatever is resident
+			const std::string message = error.what();
+			PYR_LOGF(LogTextureCache, WARN, "Could not reload a texture: {}", message);
+		}
+	}
+
+	void TextureCache::evict(CachedTexture& texture)
+	{
+		m_stats.residentBytes -= std::min(m_stats.residentBytes, texture.byteSize);
+		texture.texture.releaseRawTexture();
+		texture.texture = Texture{};
+		texture.byteSize = 0;
+		texture.bEvicted = true;
+		m_stats.evictions++;
+	}
+
+	bool TextureCache::downgrade(CachedTexture& texture)
+	{
+		ID3D11Texture2D* source = nullptr;
+		if (!texture.texture.getRawResource() || FAILED(texture.texture.getRawResource()->QueryInterface<ID3D11Texture2D>(&source)))
+			return false;
+
+		D3D11_TEXTURE2D_DESC sourceDesc;
+		source->GetDesc(&sourceDesc);
+		DXRelease(source);
+
+		if (sourceDesc.MipLevels <= 1 || sourceDesc.ArraySize != 1 || std::min(sourceDesc.Width, sourceDesc.Height) / 2 < MIN_DOWNGRADED_SIZE)
+			return false;
+
+		// The lower mips are copied on the GPU, there is no need to go back to the file
+		D3D11_TEXTURE2D_DESC desc = sourceDesc;
+		desc.Width = std::max(1u, sourceDesc.Width >> 1);
+		desc.Height = std::max(1u, sourceDesc.Height >> 1);
+		desc.MipLevels = sourceDesc.MipLevels - 1;
+		desc.MiscFlags &= ~D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+		ID3D11Texture2D* resource = nullptr;
+		ID3D11ShaderResourceView* srv = nullptr;
+		if (FAILED(Engine::d3ddevice().CreateTexture2D(&desc, nullptr, &resource)))
+			return false;
+		for (UINT mip = 0; mip < desc.MipLevels; mip++)
+			Engine::d3dcontext().CopySubresourceRegion(resource, D3D11CalcSubresource(mip, 0, desc.MipLevels), 0, 0, 0,
+				texture.texture.getRawResource(), D3D11CalcSubresource(mip + 1, 0, sourceDesc.MipLevels), nullptr);
+		if (FAILED(Engine::d3ddevice().CreateShaderResourceView(resource, nullptr, &srv)))
+		{
+			DXRelease(resource);
+			return false;
+		}
+
+		setResident(texture, Texture{ resource, srv, desc.Width, desc.Height }, texture.droppedMips + 1);
+		m_stats.downgrades++;
+		return true;
+	}
+
+	void TextureCache::onReleased(CachedTexture* released)
+	{
+		if (released->pendingLoad.valid())
+		{
+			m_stats.streamingLoadsInFlight--;
+			try { released->pendingLoad.get().releaseRawTexture(); }
+			catch (const std::runtime_error&) {}
+		}
+
+		m_stats.residentBytes -= std::min(m_stats.residentBytes, released->byteSize);
+		released->texture.releaseRawTexture();
+		delete released;
+
+		// The released texture may be known under several paths
+		std::erase_if(m_byPath, [](const auto& entry) { return entry.second.expired(); });
+		std::erase_if(m_byContent, [](const auto& entry) { return entry.second.expired(); });
+	}
+
+	void TextureCache::logStats() const
+	{
+		const size_t residentMB = m_stats.residentBytes >> 20;
+		const size_t savedMB = m_stats.savedBytes >> 20;
+		const size_t budgetMB = m_memoryBudget >> 20;
+		PYR_LOGF(LogTextureCache, INFO, "{} textures loaded ({} MB), {} duplicate loads avoided ({} by content), {} MB saved",
+			m_stats.loads, residentMB, m_stats.avoidedLoads, m_stats.contentDuplicates, savedMB);
+		PYR_LOGF(LogTextureCache, INFO, "{} evictions, {} mips dropped, {} reloads and {} streamed loads to fit the {} MB budget",
+			m_stats.evictions, m_stats.downgrades, m_stats.reloads, m_stats.streamedLoads, budgetMB);
+	}
+
+}
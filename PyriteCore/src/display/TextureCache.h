@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "display/texture.h"
+#include "utils/Debug.h"
+
+static inline PYR_DEFINELOG(LogTextureCache, VERBOSE);
+
+namespace pyr
+{
+
+// Process-wide cache of the textures loaded from files, shared by every GraphicalResourceRegistry.
+// A file used by many materials is decoded and uploaded once, and released when the last handle to it is dropped.
+// Files are identified by their canonical path, and optionally by their content to also catch copies of the same file.
+//
+// The cache also keeps the GPU memory (as accounted by GpuMemory) under a budget. When the budget is exceeded at the
+// start of a frame, the least recently used textures are evicted if they were not used for a while, or downgraded by
+// dropping their most detailed mip. Evicted and downgraded textures are reloaded from their file by use().
+// Textures handed out as raw Texture copies can't be swapped behind their users' back, these are pinned and never touched.
+//
+// DDS files with mips are streamed: only their mips up to STREAMING_INITIAL_SIZE are loaded by acquire, and the renderer
+// requests the resolution it needs on screen (see TextureStreaming). More detailed mips are then loaded from the file on
+// worker threads and swapped in at the start of a frame, as long as they fit in the budget.
+class TextureCache
+{
+public:
+
+    struct CachedTexture
+    {
+        Texture texture;
+        std::wstring key;
+        std::filesystem::path path;
+        bool bGenerateMips = true;
+        size_t byteSize = 0;     // estimated GPU memory, mips included, 0 while evicted
+        size_t fullByteSize = 0; // byteSize of the texture as loaded from its file
+        uint32_t droppedMips = 0;
+        bool bPinned = false;
+        bool bEvicted = false;
+        uint64_t lastUsedFrame = 0;
+
+        // Streamed textures only
+        bool bStreamed = false;
+        size_t fullWidth = 0, fullHeight = 0;
+        uint32_t mipCount = 1;
+        uint32_t requestedMip = 0; // most detailed mip needed on screen
+        uint64_t requestFrame = 0;
+        uint32_t pendingMip = 0;
+        std::future<Texture> pendingLoad;
+    };
+
+    // Reference counted, the texture is released with the last handle
+    using Handle = std::shared_ptr<CachedTexture>;
+
+    struct Stats
+    {
+        uint32_t loads = 0;             // files actually decoded and uploaded
+        uint32_t avoidedLoads = 0;      // requests served with an already loaded texture
+        uint32_t contentDuplicates = 0; // files with different paths but the same content, counted in avoidedLoads too
+        uint32_t evictions = 0;
+        uint32_t downgrades = 0;        // mips dropped
+        uint32_t reloads = 0;           // evicted or downgraded textures loaded again
+        uint32_t streamedLoads = 0;     // more detailed mips loaded in the background
+        uint32_t streamingLoadsInFlight = 0;
+        size_t residentBytes = 0;
+        size_t savedBytes = 0;          // memory the avoided loads would have taken
+    };
+
+    static TextureCache& get() { return s_singleton; }
+
+    // Throws if the file can't be loaded, like TextureManager::loadTexture.
+    // The file is not read again if its pixels were decoded beforehand (see ImageDecoder::DecodeFile), unless it is evicted later on.
+    Handle acquire(const std::filesystem::path& path, bool bGenerateMips = true, const ImageDecoder::DecodedImage* decoded = nullptr);
+    // Returns the texture to bind this frame, reloading it if it was evicted or downgraded and the budget allows it.
+    // The returned reference is valid until the next call to beginFrame.
+    const Texture& use(const Handle& handle);
+    // The texture is restored to full resolution and won't be evicted nor downgraded anymore
+    void pin(const Handle& handle);
+    // Asks for the mips of a streamed texture to be loaded up to the given resolution, the most detailed request of the frame wins
+    void requestResolution(const Handle& handle, float texels);
+
+    // Enforces the memory budget, must be called once per frame before any texture is used
+    void beginFrame();
+
+    // Budget on the whole GPU memory tracked by GpuMemory, in bytes
+    void setMemoryBudget(size_t bytes) { m_memoryBudget = bytes; }
+    size_t getMemoryBudget() const { return m_memoryBudget; }
+
+    // Only affects the textures acquired afterwards
+    void setStreamingEnabled(bool bEnabled) { m_bStreaming = bEnabled; }
+    bool isStreamingEnabled() const { return m_bStreaming; }
+
+    // Hashing reads every new file once more before decoding it, off by default
+    void setContentHashing(bool bEnabled) { m_bContentHashing = bEnabled; }
+    bool isContentHashingEnabled() const { return m_bContentHashing; }
+
+    const Stats& getStats() const { return m_stats; }
+    void logStats() const;
+
+private:
+
+    static constexpr uint64_t EVICTION_DELAY_FRAMES = 120; // textures used more recently are only downgraded
+    static constexpr uint32_t MAX_DOWNGRADES_PER_FRAME = 8;
+    static constexpr size_t MIN_DOWNGRADED_SIZE = 64;
+    static constexpr float RELOAD_BUDGET_RATIO = .9F; // leaves room so that reloads don't trigger downgrades right away
+    static constexpr size_t STREAMING_INITIAL_SIZE = 256;
+    static constexpr uint64_t STREAMING_REQUEST_FRAMES = 30; // requests older than this are ignored
+    static constexpr uint32_t MAX_STREAMING_LOADS = 4;
+
+    TextureCache() = default;
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    static std::wstring MakeKey(const std::filesystem::path& path, bool bGenerateMips);
+    static uint64_t HashFileContent(const std::filesystem::path& path);
+    static bool ReadDDSExtent(const std::filesystem::path& path, size_t& width, size_t& height, uint32_t& mipCount);
+    // Loads the mips no larger than maxSize (all of them if 0), can be called from any thread
+    static Texture LoadDDSMips(const std::filesystem::path& path, size_t maxSize);
+    static uint32_t CountDroppedMips(const CachedTexture& texture, const Texture& resident);
+
+    std::vector<Handle> collectResidentTextures() const;
+    void enforceBudget(std::vector<Handle> candidates);
+    void finishStreaming(CachedTexture& texture, bool bWait);
+    void streamMips(std::vector<Handle> candidates);
+    void setResident(CachedTexture& texture, Texture resident, uint32_t droppedMips);
+    void reload(CachedTexture& texture, size_t maxSize = 0);
+    void evict(CachedTexture& texture);
+    bool downgrade(CachedTexture& texture);
+    void onReleased(CachedTexture* texture);
+
+    static TextureCache s_singleton;
+
+    std::unordered_map<std::wstring, std::weak_ptr<CachedTexture>> m_byPath;
+    std::unordered_map<uint64_t, std::weak_ptr<CachedTexture>> m_byContent;
+    bool m_bContentHashing = false;
+    bool m_bStreaming = true;
+    size_t m_memoryBudget = size_t(1) << 30;
+    uint64_t m_frame = 1;
+    Stats m_stats;
+};
+
+}
@@ -0,0 +1,713 @@
+#include "TextureCooker.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <execution>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <dxgiformat.h>
+#include <emmintrin.h>
+#include <stbi/stb_image.h>
+
+#include "display/ImageDecoder.h"
+#include "utils/StringUtils.h"
+
+namespace pyr
+{
+
+	// Linear space rgba image, mips are generated from it
+	struct CookerImage
+	{
+		size_t width = 0, height = 0;
+		std::vector<float> pixels;
+
+		CookerImage(size_t inWidth, size_t inHeight) : width(inWidth), height(inHeight), pixels(inWidth * inHeight * 4) {}
+		float* at(size_t x, size_t y) { return &pixels[(y * width + x) * 4]; }
+		const float* at(size_t x, size_t y) const { return &pixels[(y * width + x) * 4]; }
+	};
+
+	// The 16 texels of a 4x4 block, in the space they are encoded in
+	struct alignas(16) CookerBlock
+	{
+		float texels[16][4];
+	};
+
+	// Block bits are written from the least significant bit of the first byte
+	struct CookerBitWriter
+	{
+		uint64_t words[2] = {};
+		uint32_t position = 0;
+
+		void write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit = 0; bit < bitCount; bit++, position++)
+				if ((value >> bit) & 1) words[position / 64] |= uint64_t(1) << (position % 64);
+		}
+	};
+
+	// Interpolation weights of the 4 bits indices of BC6H and BC7
+	static constexpr std::array<uint32_t, 16> WEIGHTS_4BITS{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	static std::vector<size_t> MakeRange(size_t count)
+	{
+		std::vector<size_t> range(count);
+		std::iota(range.begin(), range.end(), size_t(0));
+		return range;
+	}
+
+	static float SRGBToLinear(float c) { return c <= .04045F ? c / 12.92F : std::pow((c + .055F) / 1.055F, 2.4F); }
+	static float LinearToSRGB(float c) { return c <= .0031308F ? c * 12.92F : 1.055F * std::pow(c, 1.F / 2.4F) - .055F; }
+
+	// Positive values only, BC6H is encoded unsigned
+	static uint16_t FloatToHalf(float value)
+	{
+		value = std::clamp(value, 0.F, 65504.F);
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+		uint32_t mantissa = bits & 0x7FFFFF;
+		if (exponent <= 0)
+		{
+			if (exponent < -10) return 0;
+			mantissa |= 0x800000;
+			return static_cast<uint16_t>(mantissa >> (14 - exponent));
+		}
+		uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+		if (mantissa & 0x1000) half++; // round to nearest, 65504 is exact so this can't overflow to infinity
+		return static_cast<uint16_t>(half);
+	}
+
+	static float Dot4(__m128 a, __m128 b)
+	{
+		const __m128 products = _mm_mul_ps(a, b);
+		const __m128 pairs = _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehl_ps(pairs, pairs)));
+	}
+
+	static float DistanceSquared(__m128 a, __m128 b)
+	{
+		const __m128 difference = _mm_sub_ps(a, b);
+		return Dot4(difference, difference);
+	}
+
+	template<size_t N>
+	static uint32_t FindNearest(__m128 texel, const std::array<__m128, N>& palette)
+	{
+		uint32_t nearest = 0;
+		float nearestDistance = DistanceSquared(texel, palette[0]);
+		for (uint32_t i = 1; i < N; i++)
+		{
+			const float distance = DistanceSquared(texel, palette[i]);
+			if (distance < nearestDistance) { nearest = i; nearestDistance = distance; }
+		}
+		return nearest;
+	}
+
+	// Segment that best fits the texels, along their principal axis. Channels that must be ignored have to be 0 in every texel.
+	static void FitEndpoints(const CookerBlock& block, __m128& start, __m128& end)
+	{
+		__m128 mean = _mm_setzero_ps();
+		__m128 low = _mm_load_ps(block.texels[0]), high = low;
+		for (const float* texel : block.texels)
+		{
+			const __m128 value = _mm_load_ps(texel);
+			mean = _mm_add_ps(mean, value);
+			low = _mm_min_ps(low, value);
+			high = _mm_max_ps(high, value);
+		}
+		mean = _mm_mul_ps(mean, _mm_set1_ps(1.F / 16.F));
+
+		float covariance[4][4] = {};
+		for (const float* texel : block.texels)
+		{
+			alignas(16) float centered[4];
+			_mm_store_ps(centered, _mm_sub_ps(_mm_load_ps(texel), mean));
+			for (int i = 0; i < 4; i++)
+				for (int j = 0; j < 4; j++)
+					covariance[i][j] += centered[i] * centered[j];
+		}
+
+		// Power iterations, starting from the bounding box diagonal
+		alignas(16) float axis[4];
+		_mm_store_ps(axis, _mm_sub_ps(high, low));
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			for (int i = 0; i < 4; i++)
+				for (int j = 0; j < 4; j++)
+					next[i] += covariance[i][j] * axis[j];
+			const float largest = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]), std::abs(next[3]) });
+			if (largest <= 0) break;
+			for (int i = 0; i < 4; i++) axis[i] = next[i] / largest;
+		}
+
+		const __m128 axisVector = _mm_load_ps(axis);
+		const float axisLengthSquared = Dot4(axisVector, axisVector);
+		if (axisLengthSquared <= 1e-12F)
+		{
+			start = end = mean;
+			return;
+		}
+
+		float minProjection = std::numeric_limits<float>::max(), maxProjection = std::numeric_limits<float>::lowest();
+		for (const float* texel : block.texels)
+		{
+			const float projection = Dot4(_mm_sub_ps(_mm_load_ps(texel), mean), axisVector);
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+		start = _mm_add_ps(mean, _mm_mul_ps(axisVector, _mm_set1_ps(minProjection / axisLengthSquared)));
+		end = _mm_add_ps(mean, _mm_mul_ps(axisVector, _mm_set1_ps(maxProjection / axisLengthSquared)));
+	}
+
+	//======================================================================================================================//
+
+	static uint16_t ToRGB565(__m128 color)
+	{
+		alignas(16) float c[4];
+		_mm_store_ps(c, _mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(1.F)));
+		const uint32_t r = static_cast<uint32_t>(std::lround(c[0] * 31.F));
+		const uint32_t g = static_cast<uint32_t>(std::lround(c[1] * 63.F));
+		const uint32_t b = static_cast<uint32_t>(std::lround(c[2] * 31.F));
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	static __m128 FromRGB565(uint16_t color)
+	{
+		const uint32_t r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+		return _mm_setr_ps(((r << 3) | (r >> 2)) / 255.F, ((g << 2) | (g >> 4)) / 255.F, ((b << 3) | (b >> 2)) / 255.F, 0.F);
+	}
+
+	static void EncodeBC1(const CookerBlock& block, uint8_t* out)
+	{
+		CookerBlock colors = block;
+		for (float* texel : colors.texels) texel[3] = 0.F;
+
+		__m128 start, end;
+		FitEndpoints(colors, start, end);
+		uint16_t color0 = ToRGB565(end), color1 = ToRGB565(start);
+		// color0 > color1 selects the 4 colors mode
+		if (color0 < color1) std::swap(color0, color1);
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			const __m128 endpoint0 = FromRGB565(color0), endpoint1 = FromRGB565(color1);
+			const std::array<__m128, 4> palette{
+				endpoint0,
+				endpoint1,
+				_mm_mul_ps(_mm_add_ps(_mm_add_ps(endpoint0, endpoint0), endpoint1), _mm_set1_ps(1.F / 3.F)),
+				_mm_mul_ps(_mm_add_ps(_mm_add_ps(endpoint1, endpoint1), endpoint0), _mm_set1_ps(1.F / 3.F)),
+			};
+			for (uint32_t i = 0; i < 16; i++)
+				indices |= FindNearest(_mm_load_ps(colors.texels[i]), palette) << (2 * i);
+		}
+
+		std::memcpy(out, &color0, 2);
+		std::memcpy(out + 2, &color1, 2);
+		std::memcpy(out + 4, &indices, 4);
+	}
+
+	static void EncodeBC4(const CookerBlock& block, int channel, uint8_t* out)
+	{
+		float values[16];
+		float low = 1.F, high = 0.F;
+		for (int i = 0; i < 16; i++)
+		{
+			values[i] = std::clamp(block.texels[i][channel], 0.F, 1.F) * 255.F;
+			low = std::min(low, values[i] / 255.F);
+			high = std::max(high, values[i] / 255.F);
+		}
+
+		// red0 > red1 selects the 8 values mode
+		const uint8_t red0 = static_cast<uint8_t>(std::lround(high * 255.F));
+		const uint8_t red1 = static_cast<uint8_t>(std::lround(low * 255.F));
+		uint64_t indices = 0;
+		if (red0 > red1)
+		{
+			float palette[8] = { static_cast<float>(red0), static_cast<float>(red1) };
+			for (int i = 2; i < 8; i++)
+				palette[i] = ((8 - i) * red0 + (i - 1) * red1) / 7.F;
+			for (int i = 0; i < 16; i++)
+			{
+				uint64_t nearest = 0;
+				for (uint64_t candidate = 1; candidate < 8; candidate++)
+					if (std::abs(values[i] - palette[candidate]) < std::abs(values[i] - palette[nearest]))
+						nearest = candidate;
+				indices |= nearest << (3 * i);
+			}
+		}
+
+		out[0] = red0;
+		out[1] = red1;
+		std::memcpy(out + 2, &indices, 6);
+	}
+
+	// Mode 6 only: a single subset with rgba 7 bits endpoints, a p-bit per endpoint and 4 bits indices
+	static void EncodeBC7(const CookerBlock& block, uint8_t* out)
+	{
+		__m128 start, end;
+		FitEndpoints(block, start, end);
+
+		auto quantize = [](__m128 endpoint, uint32_t quantized[4], uint32_t& pBit)
+		{
+			alignas(16) float values[4];
+			_mm_store_ps(values, _mm_mul_ps(_mm_min_ps(_mm_max_ps(endpoint, _mm_setzero_ps()), _mm_set1_ps(1.F)), _mm_set1_ps(255.F)));
+			float bestError = std::numeric_limits<float>::max();
+			for (uint32_t candidate = 0; candidate < 2; candidate++)
+			{
+				uint32_t candidateQuantized[4];
+				float error = 0.F;
+				for (int c = 0; c < 4; c++)
+				{
+					candidateQuantized[c] = static_cast<uint32_t>(std::clamp<long>(std::lround((values[c] - candidate) * .5F), 0, 127));
+					const float reconstructed = static_cast<float>((candidateQuantized[c] << 1) | candidate);
+					error += (reconstructed - values[c]) * (reconstructed - values[c]);
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					pBit = candidate;
+					std::copy_n(candidateQuantized, 4, quantized);
+				}
+			}
+		};
+
+		uint32_t quantized0[4], quantized1[4], pBit0 = 0, pBit1 = 0;
+		quantize(start, quantized0, pBit0);
+		quantize(end, quantized1, pBit1);
+
+		std::array<__m128, 16> palette;
+		for (size_t i = 0; i < 16; i++)
+		{
+			alignas(16) float color[4];
+			for (int c = 0; c < 4; c++)
+			{
+				const uint32_t endpoint0 = (quantized0[c] << 1) | pBit0, endpoint1 = (quantized1[c] << 1) | pBit1;
+				color[c] = static_cast<float>(((64 - WEIGHTS_4BITS[i]) * endpoint0 + WEIGHTS_4BITS[i] * endpoint1 + 32) >> 6);
+			}
+			palette[i] = _mm_load_ps(color);
+		}
+
+		uint32_t indices[16];
+		for (int i = 0; i < 16; i++)
+			indices[i] = FindNearest(_mm_mul_ps(_mm_load_ps(block.texels[i]), _mm_set1_ps(255.F)), palette);
+
+		// The most significant bit of the first index is implicit and must be 0, the palette is symmetric so swapping the endpoints is enough
+		if (indices[0] & 8)
+		{
+			std::swap(quantized0, quantized1);
+			std::swap(pBit0, pBit1);
+			for (uint32_t& index : indices) index = 15 - index;
+		}
+
+		CookerBitWriter bits;
+		bits.write(1 << 6, 7);
+		for (int c = 0; c < 4; c++)
+		{
+			bits.write(quantized0[c], 7);
+			bits.write(quantized1[c], 7);
+		}
+		bits.write(pBit0, 1);
+		bits.write(pBit1, 1);
+		bits.write(indices[0], 3);
+		for (int i = 1; i < 16; i++)
+			bits.write(indices[i], 4);
+		std::memcpy(out, bits.words, 16);
+	}
+
+	// Mode 11 only: a single region with unsigned 10 bits endpoints and 4 bits indices. Texels hold half float bits.
+	static void EncodeBC6H(const CookerBlock& block, uint8_t* out)
+	{
+		CookerBlock colors = block;
+		for (float* texel : colors.texels) texel[3] = 0.F;
+
+		__m128 start, end;
+		FitEndpoints(colors, start, end);
+
+		auto quantize = [](__m128 endpoint, uint32_t quantized[3])
+		{
+			alignas(16) float values[4];
+			_mm_store_ps(values, endpoint);
+			for (int c = 0; c < 3; c++)
+				quantized[c] = static_cast<uint32_t>(std::clamp<long>(std::lround(values[c] / 31.F - .5F), 0, 1023));
+		};
+		auto unquantize = [](uint32_t quantized) -> uint32_t
+		{
+			if (quantized == 0) return 0;
+			if (quantized == 1023) return 0xFFFF;
+			return ((quantized << 16) + 0x8000) >> 10;
+		};
+
+		uint32_t quantized0[3], quantized1[3];
+		quantize(start, quantized0);
+		quantize(end, quantized1);
+
+		std::array<__m128, 16> palette;
+		for (size_t i = 0; i < 16; i++)
+		{
+			alignas(16) float color[4] = {};
+			for (int c = 0; c < 3; c++)
+			{
+				const uint32_t interpolated = ((64 - WEIGHTS_4BITS[i]) * unquantize(quantized0[c]) + WEIGHTS_4BITS[i] * unquantize(quantized1[c]) + 32) >> 6;
+				color[c] = static_cast<float>((interpolated * 31) >> 6);
+			}
+			palette[i] = _mm_load_ps(color);
+		}
+
+		uint32_t indices[16];
+		for (int i = 0; i < 16; i++)
+			indices[i] = FindNearest(_mm_load_ps(colors.texels[i]), palette);
+
+		if (indices[0] & 8)
+		{
+			std::swap(quantized0, quantized1);
+			for (uint32_t& index : indices) index = 15 - index;
+		}
+
+		CookerBitWriter bits;
+		bits.write(0x03, 5);
+		for (uint32_t c : quantized0) bits.write(c, 10);
+		for (uint32_t c : quantized1) bits.write(c, 10);
+		bits.write(indices[0], 3);
+		for (int i = 1; i < 16; i++)
+			bits.write(indices[i], 4);
+		std::memcpy(out, bits.words, 16);
+	}
+
+	//======================================================================================================================//
+
+	static size_t GetBlockByteSize(TextureCooker::Format format)
+	{
+		return format == TextureCooker::Format::BC1 || format == TextureCooker::Format::BC4 ? 8 : 16;
+	}
+
+	static DXGI_FORMAT ToDXGIFormat(TextureCooker::Format format)
+	{
+		switch (format)
+		{
+		case TextureCooker::Format::BC1:  return DXGI_FORMAT_BC1_UNORM;
+		case TextureCooker::Format::BC3:  return DXGI_FORMAT_BC3_UNORM;
+		case TextureCooker::Format::BC4:  return DXGI_FORMAT_BC4_UNORM;
+		case TextureCooker::Format::BC5:  return DXGI_FORMAT_BC5_UNORM;
+		case TextureCooker::Format::BC6H: return DXGI_FORMAT_BC6H_UF16;
+		case TextureCooker::Format::BC7:  return DXGI_FORMAT_BC7_UNORM;
+		default:                          return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+
+	static std::optional<CookerImage> LoadSourceImage(const std::filesystem::path& source, const TextureCooker::CookOptions& options)
+	{
+		const std::string file = widestring2string(source.wstring());
+		int width = 0, height = 0, channels = 0;
+
+		if (options.usage == TextureCooker::Usage::HDR)
+		{
+			if (std::optional<ImageDecoder::DecodedImage> decoded = ImageDecoder::DecodeHDR(source, ImageDecoder::HDRFormat::RGBA32F))
+			{
+				CookerImage image{ decoded->width, decoded->height };
+				std::memcpy(image.pixels.data(), decoded->pixels.get(), image.pixels.size() * sizeof(float));
+				return image;
+			}
+
+			float* data = stbi_loadf(file.c_str(), &width, &height, &channels, 4);
+			if (!data) return std::nullopt;
+			CookerImage image{ static_cast<size_t>(width), static_cast<size_t>(height) };
+			std::copy_n(data, image.pixels.size(), image.pixels.begin());
+			stbi_image_free(data);
+			return image;
+		}
+
+		stbi_uc* data = stbi_load(file.c_str(), &width, &height, &channels, 4);
+		if (!data) return std::nullopt;
+
+		std::array<float, 256> srgbToLinear;
+		for (size_t i = 0; i < srgbToLinear.size(); i++)
+			srgbToLinear[i] = SRGBToLinear(i / 255.F);
+
+		CookerImage image{ static_cast<size_t>(width), static_cast<size_t>(height) };
+		for (size_t i = 0; i < image.width * image.height; i++)
+		{
+			const stbi_uc* source = data + i * 4;
+			float* pixel = &image.pixels[i * 4];
+			switch (options.usage)
+			{
+			case TextureCooker::Usage::Color:
+				for (int c = 0; c < 3; c++) pixel[c] = srgbToLinear[source[c]];
+				pixel[3] = source[3] / 255.F;
+				break;
+			case TextureCooker::Usage::Normal:
+				for (int c = 0; c < 3; c++) pixel[c] = source[c] / 255.F * 2.F - 1.F;
+				pixel[3] = 1.F;
+				break;
+			default:
+				pixel[0] = pixel[1] = pixel[2] = source[std::min<uint8_t>(options.maskChannel, 3)] / 255.F;
+				pixel[3] = 1.F;
+				break;
+			}
+		}
+		stbi_image_free(data);
+		return image;
+	}
+
+	// Block compressed textures must have their most detailed mip sized in multiples of 4
+	static CookerImage ResizeToBlockMultiple(CookerImage image)
+	{
+		const size_t width = (image.width + 3) & ~size_t(3), height = (image.height + 3) & ~size_t(3);
+		if (width == image.width && height == image.height) return image;
+
+		CookerImage resized{ width, height };
+		const std::vector<size_t> rows = MakeRange(height);
+		std::for_each(std::execution::par, rows.begin(), rows.end(), [&](size_t y)
+		{
+			const float sourceY = std::clamp((y + .5F) * image.height / height - .5F, 0.F, static_cast<float>(image.height - 1));
+			const size_t y0 = static_cast<size_t>(sourceY), y1 = std::min(y0 + 1, image.height - 1);
+			const __m128 weightY = _mm_set1_ps(sourceY - y0);
+			for (size_t x = 0; x < width; x++)
+			{
+				const float sourceX = std::clamp((x + .5F) * image.width / width - .5F, 0.F, static_cast<float>(image.width - 1));
+				const size_t x0 = static_cast<size_t>(sourceX), x1 = std::min(x0 + 1, image.width - 1);
+				const __m128 weightX = _mm_set1_ps(sourceX - x0);
+				const __m128 top = _mm_add_ps(_mm_loadu_ps(image.at(x0, y0)), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(image.at(x1, y0)), _mm_loadu_ps(image.at(x0, y0))), weightX));
+				const __m128 bottom = _mm_add_ps(_mm_loadu_ps(image.at(x0, y1)), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(image.at(x1, y1)), _mm_loadu_ps(image.at(x0, y1))), weightX));
+				_mm_storeu_ps(resized.at(x, y), _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), weightY)));
+			}
+		});
+		return resized;
+	}
+
+	// 2x2 box filter in linear space
+	static CookerImage Downsample(const CookerImage& image, TextureCooker::Usage usage)
+	{
+		CookerImage half{ std::max<size_t>(1, image.width / 2), std::max<size_t>(1, image.height / 2) };
+		const std::vector<size_t> rows = MakeRange(half.height);
+		std::for_each(std::execution::par, rows.begin(), rows.end(), [&](size_t y)
+		{
+			const size_t y0 = std::min(y * 2, image.height - 1), y1 = std::min(y * 2 + 1, image.height - 1);
+			for (size_t x = 0; x < half.width; x++)
+			{
+				const size_t x0 = std::min(x * 2, image.width - 1), x1 = std::min(x * 2 + 1, image.width - 1);
+				__m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(image.at(x0, y0)), _mm_loadu_ps(image.at(x1, y0))),
+				                        _mm_add_ps(_mm_loadu_ps(image.at(x0, y1)), _mm_loadu_ps(image.at(x1, y1))));
+				sum = _mm_mul_ps(sum, _mm_set1_ps(.25F));
+
+				if (usage == TextureCooker::Usage::Normal)
+				{
+					const __m128 direction = _mm_and_ps(sum, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+					const float lengthSquared = Dot4(direction, direction);
+					if (lengthSquared > 1e-12F)
+						sum = _mm_or_ps(_mm_mul_ps(direction, _mm_set1_ps(1.F / std::sqrt(lengthSquared))), _mm_set_ps(1.F, 0.F, 0.F, 0.F));
+				}
+				_mm_storeu_ps(half.at(x, y), sum);
+			}
+		});
+		return half;
+	}
+
+	static std::vector<uint8_t> EncodeImage(const CookerImage& image, TextureCooker::Usage usage, TextureCooker::Format format)
+	{
+		const size_t blocksX = std::max<size_t>(1, (image.width + 3) / 4), blocksY = std::max<size_t>(1, (image.height + 3) / 4);
+		const size_t blockByteSize = GetBlockByteSize(format);
+		std::vector<uint8_t> encoded(blocksX * blocksY * blockByteSize);
+
+		const std::vector<size_t> rows = MakeRange(blocksY);
+		std::for_each(std::execution::par, rows.begin(), rows.end(), [&](size_t blockY)
+		{
+			for (size_t blockX = 0; blockX < blocksX; blockX++)
+			{
+				// Texels past the border of the smallest mips are clamped
+				CookerBlock block;
+				for (size_t i = 0; i < 16; i++)
+				{
+					const float* pixel = image.at(std::min(blockX * 4 + i % 4, image.width - 1), std::min(blockY * 4 + i / 4, image.height - 1));
+					float* texel = block.texels[i];
+					switch (usage)
+					{
+					case TextureCooker::Usage::Color:
+						for (int c = 0; c < 3; c++) texel[c] = std::clamp(LinearToSRGB(std::max(pixel[c], 0.F)), 0.F, 1.F);
+						texel[3] = std::clamp(pixel[3], 0.F, 1.F);
+						break;
+					case TextureCooker::Usage::Normal:
+						for (int c = 0; c < 3; c++) texel[c] = std::clamp(pixel[c] * .5F + .5F, 0.F, 1.F);
+						texel[3] = 1.F;
+						break;
+					case TextureCooker::Usage::HDR:
+						for (int c = 0; c < 3; c++) texel[c] = static_cast<float>(FloatToHalf(pixel[c]));
+						texel[3] = 0.F;
+						break;
+					default:
+						for (int c = 0; c < 4; c++) texel[c] = std::clamp(pixel[c], 0.F, 1.F);
+						break;
+					}
+				}
+
+				uint8_t* out = &encoded[(blockY * blocksX + blockX) * blockByteSize];
+				switch (format)
+				{
+				case TextureCooker::Format::BC1:  EncodeBC1(block, out); break;
+				case TextureCooker::Format::BC3:  EncodeBC4(block, 3, out); EncodeBC1(block, out + 8); break;
+				case TextureCooker::Format::BC4:  EncodeBC4(block, 0, out); break;
+				case TextureCooker::Format::BC5:  EncodeBC4(block, 0, out); EncodeBC4(block, 1, out + 8); break;
+				case TextureCooker::Format::BC6H: EncodeBC6H(block, out); break;
+				case TextureCooker::Format::BC7:  EncodeBC7(block, out); break;
+				}
+			}
+		});
+		return encoded;
+	}
+
+	static bool WriteDDS(const std::filesystem::path& destination, size_t width, size_t height, DXGI_FORMAT format,
+		const std::vector<std::vector<uint8_t>>& mips, uint32_t cookedMagic, uint32_t cookerVersion)
+	{
+		// DDS_HEADER preceded by the magic number, followed by the DDS_HEADER_DXT10 extension
+		uint32_t header[32] = {};
+		header[0] = 0x20534444; // "DDS "
+		header[1] = 124;
+		header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // caps, height, width, pixel format, mip count, linear size
+		header[3] = static_cast<uint32_t>(height);
+		header[4] = static_cast<uint32_t>(width);
+		header[5] = static_cast<uint32_t>(mips[0].size());
+		header[7] = static_cast<uint32_t>(mips.size());
+		header[8] = cookedMagic;   // reserved fields, ignored by loaders
+		header[9] = cookerVersion;
+		header[19] = 32;         // pixel format size
+		header[20] = 0x4;        // fourCC
+		header[21] = 0x30315844; // "DX10"
+		header[27] = 0x1000 | 0x8 | 0x400000; // texture, complex, mipmap
+		const uint32_t extension[5] = { static_cast<uint32_t>(format), 3 /* texture 2D */, 0, 1, 0 };
+
+		// Written aside first so that an interrupted cook never leaves a truncated file behind.
+		// The temporary file is unique to the thread, two materials sharing a texture may cook it at the same time.
+		std::filesystem::path temporary = destination;
+		temporary += std::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+		std::error_code error;
+		{
+			std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+			if (!file) return false;
+			file.write(reinterpret_cast<const char*>(header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(extension), sizeof(extension));
+			for (const std::vector<uint8_t>& mip : mips)
+				file.write(reinterpret_cast<const char*>(mip.data()), mip.size());
+			if (!file)
+			{
+				file.close();
+				std::filesystem::remove(temporary, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(temporary, destination, error);
+		if (!error) return true;
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+
+	//======================================================================================================================//
+
+	TextureCooker::Format TextureCooker::GetDefaultFormat(Usage usage)
+	{
+		switch (usage)
+		{
+		case Usage::Normal: return Format::BC5;
+		case Usage::Mask:   return Format::BC4;
+		case Usage::HDR:    return Format::BC6H;
+		default:            return Format::BC7;
+		}
+	}
+
+	const char* TextureCooker::GetFormatName(Format format)
+	{
+		switch (format)
+		{
+		case Format::BC1:  return "bc1";
+		case Format::BC3:  return "bc3";
+		case Format::BC4:  return "bc4";
+		case Format::BC5:  return "bc5";
+		case Format::BC6H: return "bc6h";
+		case Format::BC7:  return "bc7";
+		default:           return "unknown";
+		}
+	}
+
+	std::filesystem::path TextureCooker::GetCookedPath(const std::filesystem::path& source, const CookOptions& options)
+	{
+		// albedo.png.bc7.dds, orm.png.bc4g.dds...
+		std::string suffix = std::string(".") + GetFormatName(options.format.value_or(GetDefaultFormat(options.usage)));
+		if (options.usage == Usage::Mask)
+			suffix += "rgba"[std::min<uint8_t>(options.maskChannel, 3)];
+		std::filesystem::path cooked = source;
+		cooked += suffix + ".dds";
+		return cooked;
+	}
+
+	bool TextureCooker::IsCookedFileUpToDate(const std::filesystem::path& source, const std::filesystem::path& cooked)
+	{
+		std::error_code error;
+		if (!std::filesystem::exists(cooked, error)) return false;
+		const auto sourceTime = std::filesystem::last_write_time(source, error);
+		if (error) return false;
+		const auto cookedTime = std::filesystem::last_write_time(cooked, error);
+		if (error || cookedTime < sourceTime) return false;
+
+		std::ifstream file{ cooked, std::ios::binary };
+		uint32_t header[10] = {};
+		return file.read(reinterpret_cast<char*>(header), sizeof(header))
+			&& header[0] == 0x20534444 && header[8] == COOKED_FILE_MAGIC && header[9] == COOKER_VERSION;
+	}
+
+	std::filesystem::path TextureCooker::GetCookedTexture(const std::filesystem::path& source, const CookOptions& options)
+	{
+		if (source.extension() == ".dds") return source;
+
+		const std::filesystem::path cooked = GetCookedPath(source, options);
+		if (IsCookedFileUpToDate(source, cooked) || Cook(source, cooked, options))
+			return cooked;
+		return source;
+	}
+
+	bool TextureCooker::Cook(const std::filesystem::path& source, const std::filesystem::path& destination, const CookOptions& options)
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		const std::string sourceName = widestring2string(source.wstring());
+		const Format format = options.format.value_or(GetDefaultFormat(options.usage));
+
+		std::optional<CookerImage> image = LoadSourceImage(source, options);
+		if (!image)
+		{
+			PYR_LOGF(LogTextureCooker, WARN, "Could not read {} to cook it", sourceName);
+			return false;
+		}
+
+		std::vector<std::vector<uint8_t>> mips;
+		CookerImage mip = ResizeToBlockMultiple(std::move(*image));
+		const size_t width = mip.width, height = mip.height;
+		while (true)
+		{
+			mips.push_back(EncodeImage(mip, options.usage, format));
+			if (mip.width == 1 && mip.height == 1) break;
+			mip = Downsample(mip, options.usage);
+		}
+
+		if (!WriteDDS(destination, width, height, ToDXGIFormat(format), mips, COOKED_FILE_MAGIC, COOKER_VERSION))
+		{
+			const std::string destinationName = widestring2string(destination.wstring());
+			PYR_LOGF(LogTextureCooker, WARN, "Could not write the cooked texture {}", destinationName);
+			return false;
+		}
+
+		const long long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+		const char* formatName = GetFormatName(format);
+		const size_t mipCount = mips.size();
+		PYR_LOGF(LogTextureCooker, INFO, "Cooked {} to {} with {} mips in {} ms", sourceName, formatName, mipCount, milliseconds);
+		return true;
+	}
+
+}
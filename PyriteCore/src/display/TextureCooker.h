@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#include "utils/Debug.h"
+
+static inline PYR_DEFINELOG(LogTextureCooker, VERBOSE);
+
+namespace pyr
+{
+
+// Converts source images (png, jpg, hdr...) to block compressed DDS files with a full mip chain, generated on the CPU.
+// Cooked files are written next to their source and reused as long as they are more recent than it.
+//
+// Mips are filtered in linear space: color maps are converted from sRGB first, normal maps are renormalized.
+// Sizes that are not multiples of 4 are resampled to the next multiple of 4, as required by block compressed formats.
+class TextureCooker
+{
+public:
+
+    enum class Usage : uint8_t
+    {
+        Color,  // sRGB encoded, alpha kept
+        Normal, // only x and y are stored, z must be reconstructed
+        Mask,   // a single channel of the source, stored in the red channel
+        HDR,
+    };
+
+    enum class Format : uint8_t
+    {
+        BC1,  // rgb, 4 bits per pixel
+        BC3,  // rgba, 8 bits per pixel
+        BC4,  // r, 4 bits per pixel
+        BC5,  // rg, 8 bits per pixel
+        BC6H, // rgb half floats, 8 bits per pixel
+        BC7,  // rgba, 8 bits per pixel
+    };
+
+    struct CookOptions
+    {
+        Usage usage = Usage::Color;
+        uint8_t maskChannel = 0;       // Mask only, channel of the source that is kept
+        std::optional<Format> format;  // defaults to GetDefaultFormat(usage)
+    };
+
+    TextureCooker() = delete;
+
+    static Format GetDefaultFormat(Usage usage);
+    static const char* GetFormatName(Format format);
+
+    // Returns the cooked file of a source image, cooking it if needed.
+    // Returns the source itself if it can't be cooked, files that are already DDS are never cooked.
+    static std::filesystem::path GetCookedTexture(const std::filesystem::path& source, const CookOptions& options);
+    static std::filesystem::path GetCookedPath(const std::filesystem::path& source, const CookOptions& options);
+
+    // Returns false and logs if the source could not be read or the destination written
+    static bool Cook(const std::filesystem::path& source, const std::filesystem::path& destination, const CookOptions& options);
+
+private:
+
+    static constexpr uint32_t COOKED_FILE_MAGIC = 0x43525950; // "PYRC", stored in the reserved fields of the DDS header
+    static constexpr uint32_t COOKER_VERSION = 1;             // bump to invalidate every cooked file
+
+    static bool IsCookedFileUpToDate(const std::filesystem::path& source, const std::filesystem::path& cooked);
+};
+
+}
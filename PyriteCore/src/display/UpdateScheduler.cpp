@@ -0,0 +1,69 @@
+#include "UpdateScheduler.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace pyr
+{
+
+	UpdateScheduler UpdateScheduler::s_singleton;
+
+	uint64_t UpdateScheduler::MakeKey(const void* owner, uint64_t id)
+	{
+		uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(owner));
+		key ^= id + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2);
+		return key;
+	}
+
+	void UpdateScheduler::beginFrame()
+	{
+		m_previousFrameStats = m_stats;
+		m_stats = {};
+		m_bRanOptionalUpdate = false;
+		m_frame++;
+
+		// Updates nobody asked for last frame are not needed anymore
+		std::erase_if(m_postponed, [this](const auto& entry) { return entry.second.lastRequestFrame + 1 < m_frame; });
+	}
+
+	void UpdateScheduler::schedule(std::span<Update> updates)
+	{
+		auto effectivePriority = [this](const Update& update) {
+			auto it = m_postponed.find(update.key);
+			return update.priority + (it == m_postponed.end() ? 0.F : static_cast<float>(it->second.framesWaited) * AGING_PER_FRAME);
+		};
+
+		std::vector<std::pair<float, Update*>> ordered;
+		ordered.reserve(updates.size());
+		for (Update& update : updates)
+			ordered.emplace_back(effectivePriority(update), &update);
+		std::ranges::stable_sort(ordered, [](const auto& a, const auto& b) {
+			if (a.second->bMandatory != b.second->bMandatory) return a.second->bMandatory;
+			return a.first > b.first;
+		});
+
+		for (auto& [priority, update] : ordered)
+		{
+			const bool bFitsInBudget = m_stats.drawCalls + update->cost <= m_budget.maxDrawCalls && m_stats.milliseconds < m_budget.maxMilliseconds;
+			if (!update->bMandatory && !bFitsInBudget && m_bRanOptionalUpdate)
+			{
+				PostponedUpdate& postponed = m_postponed[update->key];
+				postponed.framesWaited++;
+				postponed.lastRequestFrame = m_frame;
+				m_stats.postponed++;
+				continue;
+			}
+
+			const int64_t start = m_clock.getTimeAsCount();
+			update->run();
+			m_stats.milliseconds += static_cast<float>(m_clock.getDeltaSeconds(start, m_clock.getTimeAsCount()) * 1000.0);
+			m_stats.drawCalls += update->cost;
+			m_stats.executed++;
+			m_bRanOptionalUpdate |= !update->bMandatory;
+			m_postponed.erase(update->key);
+		}
+
+		m_stats.requested += static_cast<uint32_t>(updates.size());
+	}
+
+}
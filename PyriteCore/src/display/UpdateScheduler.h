@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <unordered_map>
+
+#include "utils/clock.h"
+
+namespace pyr
+{
+
+// Spreads expensive render updates (shadow maps, cubemap captures...) over several frames to avoid frame spikes.
+// Every frame, systems hand the updates they would like to do to the scheduler, which only runs the most important ones that fit in
+// what is left of the frame budget. Systems keep using their stale results until the postponed updates run, and postponed updates
+// gain priority every frame they wait so that none of them starves.
+class UpdateScheduler
+{
+public:
+
+    struct Budget
+    {
+        uint32_t maxDrawCalls = 256;
+        float maxMilliseconds = 2.F; // CPU time spent issuing the updates, the GPU cost is only estimated through maxDrawCalls
+    };
+
+    struct Update
+    {
+        uint64_t key = 0;        // must identify the same piece of work from one frame to the next, see MakeKey
+        float priority = 0.F;    // in [0,1], higher goes first
+        uint32_t cost = 1;       // estimated draw calls
+        bool bMandatory = false; // the stale result can't be used at all, runs whatever the budget
+        std::function<void()> run;
+    };
+
+    struct Stats
+    {
+        uint32_t requested = 0;
+        uint32_t executed = 0;
+        uint32_t postponed = 0;
+        uint32_t drawCalls = 0;
+        float milliseconds = 0.F;
+    };
+
+    static UpdateScheduler& get() { return s_singleton; }
+    static uint64_t MakeKey(const void* owner, uint64_t id);
+
+    // Called by the engine at the start of every frame
+    void beginFrame();
+
+    // Runs the updates that fit in what is left of the frame budget, mandatory ones first then by priority. Can be called any number of times per frame.
+    // At least one optional update runs every frame, so that things keep progressing even with a budget too low for anything.
+    void schedule(std::span<Update> updates);
+
+    Budget& getBudget() { return m_budget; }
+    // Stats of the last complete frame
+    const Stats& getStats() const { return m_previousFrameStats; }
+
+private:
+
+    static UpdateScheduler s_singleton;
+    static constexpr float AGING_PER_FRAME = .1F;
+
+    struct PostponedUpdate
+    {
+        uint32_t framesWaited = 0;
+        uint64_t lastRequestFrame = 0;
+    };
+
+    Budget m_budget;
+    Stats m_stats;
+    Stats m_previousFrameStats;
+    std::unordered_map<uint64_t, PostponedUpdate> m_postponed;
+    uint64_t m_frame = 0;
+    bool m_bRanOptionalUpdate = false;
+    PerformanceClock m_clock;
+};
+
+}
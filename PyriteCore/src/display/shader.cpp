@@ -4,44 +4,27 @@
 #include <stdexcept>
 #include <d3dcompiler.h>
 #include <fstream>
+#include <future>
 #include <ranges>
 
 #include "engine/Directxlib.h"
 #include "GraphicalResource.h"
 #include "engine/Engine.h"
 #include "InputLayout.h"
+#include "ShaderCache.h"
+#include "engine/AsyncTasks.h"
 
 
 
 namespace pyr
 {
 
-struct IncludeManager final : ID3DInclude
-{
-  STDMETHOD(Open)(D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes) override
-  {
-    using namespace std::string_literals;
-    std::ifstream in{ "res/shaders/"s + pFileName};
-    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-    auto buf = new char[contents.size()];
-    std::ranges::copy(contents, buf);
-    *ppData = buf;
-    *pBytes = static_cast<UINT>(contents.size());
-    return S_OK;
-  }
-  STDMETHOD(Close)(LPCVOID pData) override
-  {
-      delete[] static_cast<const char*>(pData);
-      return S_OK;
-  }
-};
-
 struct RawEffect {
   ID3DX11Effect* effect = nullptr;
   ID3DX11EffectTechnique* technique = nullptr;
   ID3DX11EffectPass* pass = nullptr;
   D3DX11_EFFECT_SHADER_DESC effectVSDesc2{};
-  std::vector<D3D_SHADER_MACRO> macros{};
+  std::vector<std::string> includes{};
 };
 
 RawEffect makeRawEffect(const std::wstring& path, bool mustSucceed, const std::vector<Effect::define_t>& defines = {})
@@ -49,26 +32,24 @@ RawEffect makeRawEffect(const std::wstring& path, bool mustSucceed, const std::v
   auto &device = Engine::d3ddevice();
 
   ID3DX11Effect *effect = nullptr;
-  ID3DBlob *errors = nullptr;
-  IncludeManager includes{};
 
-  std::vector<D3D_SHADER_MACRO> macros;
-  for (const auto& [name, value] : defines)
-  {
-      macros.push_back(D3D_SHADER_MACRO{ name.c_str(), value.c_str() });
-  }
-  macros.push_back(D3D_SHADER_MACRO{ nullptr, nullptr }); // stupid null terminated api
-
-  HRESULT compilationSuccess = D3DX11CompileEffectFromFile(path.c_str(), macros.data(), &includes, D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 2, &device, &effect, &errors);
+  // Compiled once and then read from the disk cache, as long as the sources don't change
+  ShaderCache::CompiledEffect compiled = ShaderCache::get().getEffectBytecode(path, defines);
+  HRESULT compilationSuccess = compiled.bytecode.empty()
+    ? E_FAIL
+    : D3DX11CreateEffectFromMemory(compiled.bytecode.data(), compiled.bytecode.size(), 0, &device, &effect);
 
+  // Runs on a worker: PYR_LOG and PYR_ASSERT share a stream with the main thread, only PYR_LOGF is safe here.
+  // The exception is rethrown on the main thread when the effect is first used, see Effect::waitForCompilation.
   if (compilationSuccess != S_OK) {
-    const char* errorMessage = errors
-      ? static_cast<const char *>(errors->GetBufferPointer())
-      : "Could not compile an effect, no error message";
+    const char* errorMessage = !compiled.errors.empty()
+      ? compiled.errors.c_str()
+      : "Could not create an effect from its bytecode";
     if (mustSucceed) {
-      PYR_ASSERT(false, errorMessage);
+      PYR_LOGF(LogShader, FATAL, "Could not compile an effect: {}", errorMessage);
+      throw std::runtime_error(std::string("Could not compile an effect: ") + errorMessage);
     } else {
-      PYR_LOG(LogShader, WARN, "Could not compile an effect: ", errorMessage);
+      PYR_LOGF(LogShader, WARN, "Could not compile an effect: {}", errorMessage);
       return {};
     }
   }
@@ -81,29 +62,63 @@ RawEffect makeRawEffect(const std::wstring& path, bool mustSucceed, const std::v
   D3DX11_EFFECT_SHADER_DESC effectVSDesc2;
   effectVSDesc.pShaderVariable->GetShaderDesc(effectVSDesc.ShaderIndex, &effectVSDesc2);
 
-  return { effect, technique, pass, effectVSDesc2, macros };
+  return { effect, technique, pass, effectVSDesc2, std::move(compiled.includes) };
 }
 
 std::shared_ptr<Effect> ShaderManager::makeEffect(const std::wstring& path, const InputLayout& layout, const std::vector<Effect::define_t>& defines /* = {} */)
 {
-  auto [effect, technique, pass, effectVSDesc2, d3dmacros] = makeRawEffect(path, true, defines);
-  ID3D11InputLayout *inputLayout = createVertexLayout(layout, effectVSDesc2.pBytecode, effectVSDesc2.BytecodeLength);
-
-  std::shared_ptr<Effect> e = std::make_shared<Effect>(effect, technique, pass, inputLayout, defines);
+  std::shared_ptr<Effect> e = std::make_shared<Effect>();
   e->m_effectFile = widestring2string(path);
+  e->m_defines = defines;
+
+  // Compiled and created on a worker, the device is free threaded. Effects requested together compile in parallel,
+  // the effect is waited for the first time it is used and its destructor waits for the worker to be done with it.
+  auto compilation = std::make_shared<std::packaged_task<void()>>([target = e.get(), path, layout, defines]
+  {
+    auto [effect, technique, pass, effectVSDesc2, includes] = makeRawEffect(path, true, defines);
+    target->m_inputLayout = createVertexLayout(layout, effectVSDesc2.pBytecode, effectVSDesc2.BytecodeLength);
+    target->m_effect = effect;
+    target->m_technique = technique;
+    target->m_pass = pass;
+    target->m_includes = std::move(includes);
+  });
+  e->m_compilation = compilation->get_future().share();
+  WorkerPool::get().post([compilation] { (*compilation)(); });
+
   creationHooks(e);
   return e;
 }
 
-void ShaderManager::reloadEffect(Effect &e)
+void ShaderManager::reloadEffect(const std::weak_ptr<Effect> &weakEffect)
 {
-  auto [effect, technique, pass, effectVSDesc2, d3dmacros] = makeRawEffect(string2widestring(e.getFilePath()), false, e.m_defines);
-  if (effect == nullptr) return; // Invalid shader code
-  DXRelease(e.m_effect);
-  e.clearBindingCache();
-  e.m_effect = effect;
-  e.m_technique = technique;
-  e.m_pass = pass;
+  std::shared_ptr<Effect> e = weakEffect.lock();
+  if (!e || !e->isCompiled()) return; // the pending compilation reads the sources after this change anyway
+
+  // The effect keeps being used with its previous code until the new one is swapped in, at the start of a frame
+  WorkerPool::get().post([weakEffect, path = string2widestring(e->getFilePath()), defines = e->m_defines]
+  {
+    RawEffect reloaded = makeRawEffect(path, false, defines);
+    if (reloaded.effect == nullptr) return; // Invalid shader code
+    MainThread::Post([weakEffect, reloaded]
+    {
+      std::shared_ptr<Effect> e = weakEffect.lock();
+      if (!e)
+      {
+        DXRelease(reloaded.effect);
+        return;
+      }
+      e->finishCompilation(); // an effect that failed to compile is reloaded like any other
+      DXRelease(e->m_effect);
+      e->clearBindingCache();
+      e->m_effect = reloaded.effect;
+      e->m_technique = reloaded.technique;
+      e->m_pass = reloaded.pass;
+      e->m_includes = reloaded.includes;
+      e->m_compilationError = nullptr;
+      e->m_generation++;
+      PYR_LOGF(LogShader, INFO, "Reloaded shader {}", e->m_effectFile);
+    });
+  });
 }
 
 ID3D11InputLayout *ShaderManager::createVertexLayout(const InputLayout& layout, const void *shaderBytecode, size_t bytecodeLength)
@@ -125,26 +140,27 @@ ID3D11InputLayout *ShaderManager::createVertexLayout(const InputLayout& layout,
 }
 
 Effect::Effect(Effect &&moved) noexcept
-  : m_effect(std::exchange(moved.m_effect, nullptr))
-  , m_technique(std::exchange(moved.m_technique, nullptr))
-  , m_pass(std::exchange(moved.m_pass, nullptr))
-  , m_inputLayout(std::exchange(moved.m_inputLayout, nullptr))
-  , m_variableBindingsCache(std::move(moved.m_variableBindingsCache))
-  , m_constantBufferBindingsCache(std::move(moved.m_constantBufferBindingsCache))
-#ifdef PYR_ISDEBUG
-  , m_effectFile(std::exchange(moved.m_effectFile, {}))
-#endif
 {
+  *this = std::move(moved);
 }
 
 Effect &Effect::operator=(Effect &&moved) noexcept
 {
+  // The worker compiling an effect writes into it, it must be done before the pointers change hands
+  if (m_compilation.valid()) m_compilation.wait();
+  if (moved.m_compilation.valid()) moved.m_compilation.wait();
+  m_compilation = std::exchange(moved.m_compilation, {});
+  m_compilationError = std::exchange(moved.m_compilationError, nullptr);
   m_effect = std::exchange(moved.m_effect, nullptr);
   m_technique = std::exchange(moved.m_technique, nullptr);
   m_pass = std::exchange(moved.m_pass, nullptr);
   m_inputLayout = std::exchange(moved.m_inputLayout, nullptr);
   m_variableBindingsCache = std::move(moved.m_variableBindingsCache);
   m_constantBufferBindingsCache = std::move(moved.m_constantBufferBindingsCache);
+  m_includes = std::move(moved.m_includes);
+  // Variables resolved against either effect are dangling
+  m_generation = std::max(m_generation, moved.m_generation) + 1;
+  moved.m_generation++;
 #ifdef PYR_ISDEBUG
   m_effectFile = std::exchange(moved.m_effectFile, {});
 #endif
@@ -153,12 +169,35 @@ Effect &Effect::operator=(Effect &&moved) noexcept
 
 Effect::~Effect()
 {
+  if (m_compilation.valid())
+    m_compilation.wait(); // the worker writes into this effect, errors are dropped
   DXRelease(m_effect);
   DXRelease(m_inputLayout);
 }
 
+void Effect::finishCompilation() const
+{
+  if (!m_compilation.valid()) return;
+  std::shared_future<void> compilation = std::exchange(m_compilation, {});
+  try { compilation.get(); }
+  catch (...) { m_compilationError = std::current_exception(); }
+}
+
+void Effect::waitForCompilation() const
+{
+  finishCompilation();
+  if (m_compilationError)
+    std::rethrow_exception(m_compilationError);
+}
+
+bool Effect::isCompiled() const
+{
+  return !m_compilation.valid() || m_compilation.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
 void Effect::bind() const
 {
+  waitForCompilation();
   auto &device = Engine::d3dcontext();
   device.IASetInputLayout(m_inputLayout);
   DXTry(m_pass->Apply(0, &device), "Could not bind an effect");
@@ -215,8 +254,15 @@ void Effect::bindSampler(const SamplerState &sampler, const std::string &name) c
   DXTry(getVariableBinding(name)->AsSampler()->SetSampler(0, sampler.getRawSampler()), "Could not bind a texture sampler to an effect");
 }
 
+ID3DX11EffectShaderResourceVariable *Effect::getShaderResourceVariable(const std::string &name) const
+{
+  ID3DX11EffectShaderResourceVariable *variable = getVariableBinding(name)->AsShaderResource();
+  return variable->IsValid() ? variable : nullptr;
+}
+
 ID3DX11EffectVariable *Effect::getVariableBinding(const std::string &name) const
 {
+  waitForCompilation();
   auto el = m_variableBindingsCache.find(name);
   return el != m_variableBindingsCache.end()
       ? el->second 
@@ -224,6 +270,7 @@ ID3DX11EffectVariable *Effect::getVariableBinding(const std::string &name) const
 }
 ID3DX11EffectConstantBuffer *Effect::getConstantBufferBinding(const std::string &name) const
 {
+  waitForCompilation();
   auto el = m_constantBufferBindingsCache.find(name);
   return el != m_constantBufferBindingsCache.end()
         ? el->second
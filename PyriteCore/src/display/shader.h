@@ -4,6 +4,8 @@
 #include <unordered_map>
 #include <vector>
 #include <algorithm>
+#include <exception>
+#include <future>
 #include <span>
 
 #include "ConstantBuffer.h"
@@ -63,7 +65,21 @@ public:
 
   void bindSampler(const SamplerState &sampler, const std::string &name) const;
 
+  // Null if the effect has no texture with that name. Variables are invalidated when the effect is reloaded, see getGeneration.
+  ID3DX11EffectShaderResourceVariable *getShaderResourceVariable(const std::string &name) const;
+  // Changes each time the effect is reloaded, to know when anything resolved against the previous effect must be resolved again
+  uint32_t getGeneration() const { return m_generation; }
+
   const std::string& getFilePath() const { return m_effectFile; }
+  // Files included by the effect when it was last compiled, relative to ShaderCache::INCLUDE_DIRECTORY. Only valid once isCompiled().
+  const std::vector<std::string>& getIncludes() const { return m_includes; }
+
+  // Effects are compiled on the WorkerPool (see ShaderManager::makeEffect), using one waits for its compilation to complete.
+  // Rethrows the compilation error, if any, and again on every later use: a failed effect has nothing to bind.
+  // Main thread only, like every other use of the effect.
+  void waitForCompilation() const;
+  // True once the compilation completed, whether it succeeded or not
+  bool isCompiled() const;
   
   ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////:
 
@@ -85,7 +101,7 @@ public:
 
   void bindConstantBuffer(const std::string& constantBufferName, std::shared_ptr<BaseConstantBuffer> data) const
   {
-	  ID3DX11EffectConstantBuffer* pCB = m_effect->GetConstantBufferByName(constantBufferName.c_str());
+	  ID3DX11EffectConstantBuffer* pCB = getRawEffect()->GetConstantBufferByName(constantBufferName.c_str());
 	  pCB->SetConstantBuffer(data->getRawBuffer());
   }
 
@@ -109,61 +125,68 @@ private:
 	template<>
 	void setUniformImpl<float>(const std::string& uniformName, const float& data) const
 	{
-		m_effect->GetVariableByName(uniformName.c_str())->AsScalar()->SetFloat(static_cast<float>(data));
+		getRawEffect()->GetVariableByName(uniformName.c_str())->AsScalar()->SetFloat(static_cast<float>(data));
 	}
 
 	template<>
 	void setUniformImpl<vec2>(const std::string& uniformName, const vec2& data) const
 	{
 		const float vals[2] = { data.x, data.y };
-		m_effect->GetVariableByName(uniformName.c_str())->AsVector()->SetFloatVector(vals);
+		getRawEffect()->GetVariableByName(uniformName.c_str())->AsVector()->SetFloatVector(vals);
 	}
 
 	template<>
 	void setUniformImpl<vec3>(const std::string& uniformName, const vec3& data) const
 	{
 		const float vals[3] = { data.x, data.y, data.z };
-		m_effect->GetVariableByName(uniformName.c_str())->AsVector()->SetFloatVector(vals);
+		getRawEffect()->GetVariableByName(uniformName.c_str())->AsVector()->SetFloatVector(vals);
 	}
 
 	template<>
 	void setUniformImpl<vec4>(const std::string& uniformName, const vec4& data) const
 	{
 		const float vals[4] = { data.x, data.y, data.z, data.w };
-		m_effect->GetVariableByName(uniformName.c_str())->AsVector()->SetFloatVector(vals);
+		getRawEffect()->GetVariableByName(uniformName.c_str())->AsVector()->SetFloatVector(vals);
 	}
 
 	template<>
 	void setUniformImpl<mat4>(const std::string& uniformName, const mat4& data) const
 	{
-		m_effect->GetVariableByName(uniformName.c_str())->AsMatrix()->SetMatrix(data.m[0]);
+		getRawEffect()->GetVariableByName(uniformName.c_str())->AsMatrix()->SetMatrix(data.m[0]);
 	}
 
 	template<>
 	void setUniformImpl<std::vector<vec4>>(const std::string& uniformName, const std::vector<vec4>& data) const
 	{
-		m_effect->GetVariableByName(uniformName.c_str())->AsVector()->SetFloatVectorArray(
+		getRawEffect()->GetVariableByName(uniformName.c_str())->AsVector()->SetFloatVectorArray(
 			reinterpret_cast<const float*>(data.data()),
 			0, static_cast<uint32_t>(data.size())
 		);
 	}
 
 private:
+  ID3DX11Effect *getRawEffect() const { waitForCompilation(); return m_effect; }
   ID3DX11EffectVariable *getVariableBinding(const std::string &name) const;
   ID3DX11EffectConstantBuffer *getConstantBufferBinding(const std::string &name) const;
   void clearBindingCache() { m_variableBindingsCache.clear(); m_constantBufferBindingsCache.clear(); }
+  // Waits for the worker and keeps its error, if any, without throwing it
+  void finishCompilation() const;
 
 private:
   std::string			 m_effectFile;
-  ID3DX11Effect          *m_effect;
-  ID3DX11EffectTechnique *m_technique;
-  ID3DX11EffectPass      *m_pass;
-  ID3D11InputLayout      *m_inputLayout;
+  ID3DX11Effect          *m_effect = nullptr;
+  ID3DX11EffectTechnique *m_technique = nullptr;
+  ID3DX11EffectPass      *m_pass = nullptr;
+  ID3D11InputLayout      *m_inputLayout = nullptr;
   mutable std::unordered_map<std::string, ID3DX11EffectVariable *> m_variableBindingsCache;
   mutable std::unordered_map<std::string, ID3DX11EffectConstantBuffer *> m_constantBufferBindingsCache;
 
   std::vector<ConstantBufferBinding> m_bindings; // todo say bind all cbuffers
   std::vector<define_t> m_defines;
+  std::vector<std::string> m_includes;
+  mutable std::shared_future<void> m_compilation; // reset once waited for
+  mutable std::exception_ptr m_compilationError;  // kept until a reload succeeds
+  uint32_t m_generation = 0;
 };
 
 class ShaderManager
@@ -173,7 +196,9 @@ public:
   using ShaderCreationHookHandle = HookSet<ShaderCreationHook>::HookHandle;
 
   static std::shared_ptr<Effect> makeEffect(const std::wstring& path, const InputLayout& layout, const std::vector<Effect::define_t>& defines = {});
-  static void reloadEffect(Effect& effect);
+  // Recompiles the effect on a worker and swaps it in at the start of the next frame, main thread only.
+  // Effects that fail to compile keep their previous code.
+  static void reloadEffect(const std::weak_ptr<Effect>& effect);
   static inline HookSet<ShaderCreationHook> creationHooks;
 
 private:
@@ -4,11 +4,14 @@
 
 #include "ddstextureloader/WICTextureLoader11.h"
 #include "ddstextureloader/DDSTextureLoader11.h"
+#include "display/GpuMemory.h"
 #include "display/GraphicalResource.h"
+#include "display/ImageDecoder.h"
 #include "engine/Directxlib.h"
 #include "engine/Engine.h"
 #include "utils/StringUtils.h"
 #include <filesystem>
+#include <format>
 #include <stbi/stb_image.h>
 
 namespace pyr
@@ -39,11 +42,18 @@ Texture TextureManager::loadTexture(const std::wstring &path, bool bGenerateMips
   }
   else if (extension == ".hdr")
   {
-	  int width, height, channels;
-	  float* data = stbi_loadf(widestring2string(path.c_str()).c_str(), &width, &height, &channels, 4);
-	  Texture outTexture{ data, (size_t)width, (size_t)height };
-	  stbi_image_free(data);
-	  return outTexture;
+	  // RGB9E5 holds rgbe texels without loss in a quarter of the memory of the float path
+	  std::optional<ImageDecoder::DecodedImage> image = ImageDecoder::DecodeHDR(fspath, ImageDecoder::HDRFormat::RGB9E5);
+	  if (!image)
+	  {
+		  int width, height, channels;
+		  float* data = stbi_loadf(widestring2string(path.c_str()).c_str(), &width, &height, &channels, 4);
+		  Texture outTexture{ data, (size_t)width, (size_t)height };
+		  stbi_image_free(data);
+		  GpuMemory::Track(outTexture.getRawResource(), GpuMemory::Category::Texture, widestring2string(path));
+		  return outTexture;
+	  }
+	  return createTexture(*image, false, widestring2string(path));
   }
   else
   {
@@ -62,9 +72,48 @@ Texture TextureManager::loadTexture(const std::wstring &path, bool bGenerateMips
   textureInterface->GetDesc(&desc);
   DXRelease(textureInterface);
 
+  GpuMemory::Track(resource, GpuMemory::Category::Texture, widestring2string(path));
   return Texture(resource, texture, desc.Width, desc.Height);
 }
 
+// The decoded pixels are the upload memory, the driver copies them to the texture directly
+Texture TextureManager::createTexture(const ImageDecoder::DecodedImage &image, bool bGenerateMips, const std::string &name)
+{
+  auto &device = Engine::d3ddevice();
+
+  // Shared exponent formats can't be rendered to, their mips can't be generated on the GPU
+  bGenerateMips &= image.format != DXGI_FORMAT_R9G9B9E5_SHAREDEXP;
+
+  D3D11_TEXTURE2D_DESC desc{};
+  desc.Width = static_cast<UINT>(image.width);
+  desc.Height = static_cast<UINT>(image.height);
+  desc.MipLevels = bGenerateMips ? 0 : 1;
+  desc.ArraySize = 1;
+  desc.Format = image.format;
+  desc.SampleDesc.Count = 1;
+  desc.Usage = D3D11_USAGE_DEFAULT;
+  desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | (bGenerateMips ? D3D11_BIND_RENDER_TARGET : 0);
+  desc.MiscFlags = bGenerateMips ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0;
+
+  D3D11_SUBRESOURCE_DATA initialData{};
+  initialData.pSysMem = image.pixels.get();
+  initialData.SysMemPitch = static_cast<UINT>(image.getRowPitch());
+
+  ID3D11Texture2D *resource;
+  ID3D11ShaderResourceView *texture;
+  // With a full mip chain every level would need initial data, the most detailed one is uploaded afterward instead
+  DXTry(device.CreateTexture2D(&desc, bGenerateMips ? nullptr : &initialData, &resource), "Could not create a texture 2D");
+  DXTry(device.CreateShaderResourceView(resource, nullptr, &texture), "Could not create a shader resource view");
+  if (bGenerateMips)
+  {
+	Engine::d3dcontext().UpdateSubresource(resource, 0, nullptr, image.pixels.get(), static_cast<UINT>(image.getRowPitch()), 0);
+	Engine::d3dcontext().GenerateMips(texture);
+  }
+
+  GpuMemory::Track(resource, GpuMemory::Category::Texture, name);
+  return Texture(resource, texture, image.width, image.height);
+}
+
 Cubemap TextureManager::loadCubemap(const std::wstring &path)
 {
   auto &device = Engine::d3ddevice();
@@ -90,6 +139,7 @@ Cubemap TextureManager::loadCubemap(const std::wstring &path)
 	) != S_OK)
 	throw std::runtime_error("Could not load texture " + pyr::widestring2string(path));
 
+  GpuMemory::Track(resource, GpuMemory::Category::Cubemap, widestring2string(path));
   return Cubemap(resource, texture);
 }
 
@@ -111,6 +161,7 @@ ID3D11DepthStencilView* Texture::toDepthStencilView()
 
 void Texture::releaseRawTexture()
 {
+  GpuMemory::Untrack(m_resource);
   DXRelease(m_resource);
   DXRelease(m_texture);
   m_width = m_height = 0;
@@ -177,6 +228,9 @@ Texture::Texture(float* data, size_t width, size_t height, bool bStagingTexture
 	auto hr = Engine::d3ddevice().CreateShaderResourceView(
 		m_resource ,
 		&srvDesc, &m_texture);
+
+	if (!bStagingTexture)
+		GpuMemory::Track(m_resource, GpuMemory::Category::Texture, std::format("Generated texture {}x{}", width, height));
 }
 
 TextureManager::~TextureManager()
@@ -214,34 +268,39 @@ const SamplerState &TextureManager::getSampler(SamplerState::SamplerType type)
 
 void Cubemap::releaseRawCubemap()
 {
+	GpuMemory::Untrack(m_resource);
 	DXRelease(m_resource);
 	DXRelease(m_texture);
 }
 
 
-TextureArray::TextureArray(size_t width, size_t height, size_t count, TextureType type, bool bIsDepthOnly /* = false */)
+TextureArray::TextureArray(size_t width, size_t height, size_t count, TextureType type, bool bIsDepthOnly /* = false */, bool bRenderTarget /* = false */)
 	: m_width(width)
 	, m_height(height)
 	, m_elementCount(count)
 	, m_heldType(type)
 {
 	if (isCubeArray()) m_elementCount *= 6;
+	// Depth stencil views can't be created on cube arrays, these are rendered to through a color target instead (see SceneRenderTools)
+	const bool bDepthTarget = bRenderTarget && bIsDepthOnly && !isCubeArray();
+
 	D3D11_TEXTURE2D_DESC texDesc = {};
 	texDesc.Width =  static_cast<UINT>(width);
 	texDesc.Height = static_cast<UINT>(height);
 	texDesc.MipLevels = 1;
 	texDesc.ArraySize = static_cast<UINT>(m_elementCount);
-	texDesc.Format = bIsDepthOnly ? DXGI_FORMAT_R32_FLOAT : DXGI_FORMAT_R32G32B32A32_FLOAT;
+	texDesc.Format = bDepthTarget ? DXGI_FORMAT_R32_TYPELESS : bIsDepthOnly ? DXGI_FORMAT_R32_FLOAT : DXGI_FORMAT_R32G32B32A32_FLOAT;
 	texDesc.SampleDesc.Count = 1;
 	texDesc.Usage = D3D11_USAGE_DEFAULT;
 	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	if (bRenderTarget) texDesc.BindFlags |= bDepthTarget ? D3D11_BIND_DEPTH_STENCIL : D3D11_BIND_RENDER_TARGET;
 	if (isCubeArray()) texDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
 
 	// Create the texture array resource
 	DXTry(pyr::Engine::d3ddevice().CreateTexture2D(&texDesc, nullptr, (ID3D11Texture2D**)(&m_resource)), "Could not create the texture associated with the array");
 
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Format = texDesc.Format;
+	srvDesc.Format = bDepthTarget ? DXGI_FORMAT_R32_FLOAT : texDesc.Format;
 
 	if (isCubeArray())
 	{
@@ -261,64 +320,44 @@ TextureArray::TextureArray(size_t width, size_t height, size_t count, TextureTyp
 	}
 
 	DXTry(pyr::Engine::d3ddevice().CreateShaderResourceView(m_resource, &srvDesc, &m_textureArray), "Could not create a TextureArray.");
-}
+	GpuMemory::Track(m_resource, GpuMemory::Category::TextureArray, std::format("{} {}x{}x{}", isCubeArray() ? "Cube array" : "Texture array", width, height, count));
 
-TextureArray::~TextureArray()
-{
-	DXRelease(m_textureArray);
-	DXRelease(m_resource);
-}
+	if (!bRenderTarget) return;
 
-void TextureArray::CopyToTextureArray(const std::vector<Texture>& textures, TextureArray& outArray)
-{
-	if (textures.empty()) return;
-
-	if (!PYR_ENSURE(!outArray.isCubeArray())) return;
-	if (!PYR_ENSURE(textures[0].getWidth() == outArray.getWidth())) return;
-	if (!PYR_ENSURE(textures[0].getHeight() == outArray.getHeight())) return;
-
-	ID3D11Texture2D* resource = static_cast<ID3D11Texture2D*>(outArray.getRawResource());
-
-	for (UINT i = 0; i < outArray.getTextureOrCubeCount() && i < textures.size(); ++i)
+	for (UINT slice = 0; slice < texDesc.ArraySize; slice++)
 	{
-		// Copy the texture to the corresponding slice in the array
-		pyr::Engine::d3dcontext().CopySubresourceRegion(
-			resource,
-			D3D11CalcSubresource(0, i, 1),		// MipSlice = 0, ArraySlice = i
-			0, 0, 0,                            // Destination X, Y, Z
-			textures[i].getRawResource(), 
-			0,                                  // Source subresource index
-			nullptr);                           // No source box, copy entire resource
+		if (bDepthTarget)
+		{
+			D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+			dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
+			dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+			dsvDesc.Texture2DArray.MipSlice = 0;
+			dsvDesc.Texture2DArray.FirstArraySlice = slice;
+			dsvDesc.Texture2DArray.ArraySize = 1;
+			DXTry(pyr::Engine::d3ddevice().CreateDepthStencilView(m_resource, &dsvDesc, &m_sliceDepthViews.emplace_back()), "Could not create the depth view of a TextureArray slice");
+		}
+		else
+		{
+			D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+			rtvDesc.Format = texDesc.Format;
+			rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+			rtvDesc.Texture2DArray.MipSlice = 0;
+			rtvDesc.Texture2DArray.FirstArraySlice = slice;
+			rtvDesc.Texture2DArray.ArraySize = 1;
+			DXTry(pyr::Engine::d3ddevice().CreateRenderTargetView(m_resource, &rtvDesc, &m_sliceRenderTargetViews.emplace_back()), "Could not create the render target view of a TextureArray slice");
+		}
 	}
 }
 
-void TextureArray::CopyToTextureArray(const std::vector<Cubemap>& cubemaps, TextureArray& outArray)
+TextureArray::~TextureArray()
 {
-	if (cubemaps.empty()) return;
-
-	if (!PYR_ENSURE(outArray.isCubeArray())) return;
-
-	ID3D11Texture2D* resource = static_cast<ID3D11Texture2D*>(outArray.getRawResource());
-
-	// Iterate through each cubemap
-	for (UINT i = 0; i < outArray.getTextureOrCubeCount() && i < cubemaps.size(); ++i)
-	{
-		// We are copying cubemap faces to the corresponding slice in the array
-		for (UINT face = 0; face < 6; ++face)
-		{
-			// Calculate the slice index for this cubemap face
-			UINT sliceIndex = i * 6 + face;
-
-			// Copy the individual face to the corresponding slice in the cubemap array
-			pyr::Engine::d3dcontext().CopySubresourceRegion(
-				resource,
-				D3D11CalcSubresource(0, sliceIndex, 1), // MipSlice = 0, ArraySlice = sliceIndex
-				0, 0, 0,                                // Destination X, Y, Z
-				cubemaps[i].getRawResource(),           // Source cubemap resource
-				face,                                   // Copy the specific face (0-5 for cubemap faces)
-				nullptr);                               // No source box, copy the entire resource
-		}
-	}
+	for (ID3D11DepthStencilView* view : m_sliceDepthViews)
+		DXRelease(view);
+	for (ID3D11RenderTargetView* view : m_sliceRenderTargetViews)
+		DXRelease(view);
+	DXRelease(m_textureArray);
+	GpuMemory::Untrack(m_resource);
+	DXRelease(m_resource);
 }
 
 
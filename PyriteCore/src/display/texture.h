@@ -4,9 +4,12 @@
 #include <array>
 #include <vector>
 
+#include "display/ImageDecoder.h"
+
 struct ID3D11Resource;
 struct ID3D11ShaderResourceView;
 struct ID3D11DepthStencilView;
+struct ID3D11RenderTargetView;
 struct ID3D11SamplerState;
 
 namespace pyr
@@ -48,6 +51,7 @@ private:
   friend class TextureManager;
   friend class GraphicalResourceRegistry;
   friend class FrameBuffer;
+  friend class TextureCache;
   Texture(ID3D11Resource *resource, ID3D11ShaderResourceView *raw, size_t width, size_t height)
     : m_resource(resource), m_texture(raw), m_width(width), m_height(height) { }
 
@@ -89,16 +93,19 @@ private:
     size_t m_width, m_height;
     ID3D11Resource* m_resource;
     ID3D11ShaderResourceView* m_textureArray;
-    std::vector<Texture> m_textures;
+    std::vector<ID3D11DepthStencilView*> m_sliceDepthViews;
+    std::vector<ID3D11RenderTargetView*> m_sliceRenderTargetViews;
     size_t m_elementCount;
     TextureType m_heldType;
 
 public:
                                                                                 // v v v todo : pyr_pixelFormat ?
-    TextureArray(size_t width, size_t height, size_t count, TextureType type, bool bIsDepthOnly = false);
+    // When bRenderTarget is set every slice (every face for cube arrays) gets its own view so that it can be rendered into directly.
+    // Depth only 2D arrays get depth stencil views, anything else gets render target views.
+    TextureArray(size_t width, size_t height, size_t count, TextureType type, bool bIsDepthOnly = false, bool bRenderTarget = false);
     ~TextureArray();
-    static void CopyToTextureArray(const std::vector<Texture>& textures, TextureArray& outArray);
-    static void CopyToTextureArray(const std::vector<Cubemap>& cubes, TextureArray& outArray);
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
     
     ID3D11ShaderResourceView* getRawTexture()   const { return m_textureArray; }
     ID3D11Resource* getRawResource()            const { return m_resource; }
@@ -107,6 +114,10 @@ public:
     size_t getTextureOrCubeCount()              const { return m_elementCount; }
     bool isCubeArray()                          const { return m_heldType == TextureCube; }
 
+    // For cube arrays, the slice of a face is cubeIndex * 6 + face
+    ID3D11DepthStencilView* getSliceDepthView(size_t slice)         const { return slice < m_sliceDepthViews.size() ? m_sliceDepthViews[slice] : nullptr; }
+    ID3D11RenderTargetView* getSliceRenderTargetView(size_t slice)  const { return slice < m_sliceRenderTargetViews.size() ? m_sliceRenderTargetViews[slice] : nullptr; }
+
 };
 //===============================================================================================================================//
 
@@ -136,6 +147,8 @@ public:
   ~TextureManager();
 
   static Texture loadTexture(const std::wstring &path, bool bGenerateMips = true);
+  // Uploads pixels decoded beforehand (possibly on another thread), name is only used for the memory accounting
+  static Texture createTexture(const ImageDecoder::DecodedImage &image, bool bGenerateMips, const std::string &name);
   static Cubemap loadCubemap(const std::wstring &path);
   static const SamplerState &getSampler(SamplerState::SamplerType type);
 
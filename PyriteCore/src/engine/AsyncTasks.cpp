@@ -0,0 +1,106 @@
+#include "AsyncTasks.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace pyr
+{
+
+	WorkerPool WorkerPool::s_singleton;
+
+	// Statics are initialized before main, on the thread that later runs the engine
+	const std::thread::id MainThread::s_mainThreadId = std::this_thread::get_id();
+	MPSCQueue<std::function<void()>> MainThread::s_tasks;
+
+	WorkerPool::~WorkerPool()
+	{
+		// Pending tasks are dropped, only reached at exit
+		for (std::jthread& worker : m_workers)
+			worker.request_stop();
+		m_wakeUp.notify_all();
+		m_workers.clear();
+	}
+
+	void WorkerPool::post(std::function<void()> task)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			if (m_workers.empty())
+			{
+				const size_t workerCount = GetDesiredWorkerCount();
+				for (size_t i = 0; i < workerCount; i++)
+					m_workers.emplace_back([this](std::stop_token stopToken) { workerLoop(stopToken); });
+			}
+			m_tasks.push_back(std::move(task));
+		}
+		m_wakeUp.notify_one();
+	}
+
+	size_t WorkerPool::GetDesiredWorkerCount()
+	{
+		// One core is left to the main thread, hardware_concurrency may be 0 if unknown
+		return std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	void WorkerPool::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t first, size_t last)>& body)
+	{
+		const size_t rangeCount = (count + grainSize - 1) / grainSize;
+		if (rangeCount <= 1)
+		{
+			if (count > 0) body(0, count);
+			return;
+		}
+
+		struct Progress
+		{
+			std::atomic<size_t> nextRange{ 0 };
+			std::atomic<size_t> doneRanges{ 0 };
+		};
+
+		// Workers that start after every range was taken return without touching body, only the progress outlives the call
+		std::shared_ptr<Progress> progress = std::make_shared<Progress>();
+		auto runRanges = [progress, &body, count, grainSize, rangeCount]
+		{
+			for (size_t range = progress->nextRange++; range < rangeCount; range = progress->nextRange++)
+			{
+				body(range * grainSize, std::min(count, (range + 1) * grainSize));
+				progress->doneRanges.fetch_add(1, std::memory_order_release);
+			}
+		};
+
+		const size_t helperCount = std::min(rangeCount - 1, GetDesiredWorkerCount());
+		for (size_t i = 0; i < helperCount; i++)
+			post(runRanges);
+		runRanges();
+
+		while (progress->doneRanges.load(std::memory_order_acquire) < rangeCount)
+			std::this_thread::yield();
+	}
+
+	void WorkerPool::workerLoop(std::stop_token stopToken)
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock lock(m_mutex);
+				if (!m_wakeUp.wait(lock, stopToken, [this] { return !m_tasks.empty(); }))
+					return;
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	void MainThread::PumpTasks()
+	{
+		// Tasks can post new tasks, they would run in the same call if the queue was drained until empty
+		std::vector<std::function<void()>> tasks;
+		while (std::optional<std::function<void()>> task = s_tasks.pop())
+			tasks.push_back(std::move(*task));
+		for (std::function<void()>& task : tasks)
+			task();
+	}
+
+}
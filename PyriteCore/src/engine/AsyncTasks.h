@@ -0,0 +1,251 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pyr
+{
+
+// Multiple producers, single consumer, unbounded. push never blocks nor spins, pop must only be called by the consumer.
+// A node is allocated per push, the queue is meant for a few hundred tasks per frame at most.
+template<class T>
+class MPSCQueue
+{
+private:
+
+    struct Node
+    {
+        std::atomic<Node*> next{ nullptr };
+        std::optional<T> value;
+    };
+
+    alignas(64) std::atomic<Node*> m_head; // last pushed node, producers side
+    alignas(64) Node* m_tail;              // already consumed node whose successor is the next to pop
+
+public:
+
+    MPSCQueue()
+    {
+        Node* stub = new Node;
+        m_head.store(stub, std::memory_order_relaxed);
+        m_tail = stub;
+    }
+
+    ~MPSCQueue()
+    {
+        while (pop());
+        delete m_tail;
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    void push(T value)
+    {
+        Node* node = new Node;
+        node->value.emplace(std::move(value));
+        Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // May miss an element whose push has not completed yet, it will be returned by a later call
+    std::optional<T> pop()
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return std::nullopt;
+
+        std::optional<T> value = std::move(next->value);
+        next->value.reset();
+        m_tail = next;
+        delete tail;
+        return value;
+    }
+};
+
+// Threads for CPU work that must not stall a frame (file reads, decoding, mesh imports...).
+// Tasks run in submission order on any worker and must not touch the immediate context nor the other main thread only systems.
+class WorkerPool
+{
+public:
+
+    static WorkerPool& get() { return s_singleton; }
+
+    ~WorkerPool();
+
+    void post(std::function<void()> task);
+    size_t getWorkerCount() const { return m_workers.size(); }
+
+    // Splits [0,count) in ranges of at most grainSize items, processed by the workers and the calling thread, returns once all are.
+    // The calling thread takes ranges too, workers busy with long tasks only make it slower.
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t first, size_t last)>& body);
+
+private:
+
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void workerLoop(std::stop_token stopToken);
+    static size_t GetDesiredWorkerCount();
+
+private:
+
+    std::mutex m_mutex;
+    std::condition_variable_any m_wakeUp;
+    std::deque<std::function<void()>> m_tasks;
+    std::vector<std::jthread> m_workers; // started on the first post
+
+    static WorkerPool s_singleton;
+};
+
+// Work posted from any thread to run on the main thread, at the start of the next frame.
+class MainThread
+{
+public:
+
+    MainThread() = delete;
+
+    static bool IsCurrent() { return std::this_thread::get_id() == s_mainThreadId; }
+    static void Post(std::function<void()> task) { s_tasks.push(std::move(task)); }
+
+    // Runs the tasks posted so far, called by the engine once per frame. Tasks posted meanwhile wait for the next frame.
+    static void PumpTasks();
+
+private:
+
+    static const std::thread::id s_mainThreadId;
+    static MPSCQueue<std::function<void()>> s_tasks;
+};
+
+template<class T = void>
+class Task;
+
+namespace detail
+{
+
+    struct TaskPromiseBase
+    {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+
+        // Resumes the awaiting coroutine without growing the stack, root tasks simply stay suspended until destroyed
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            template<class Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                std::coroutine_handle<> continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+    template<class T>
+    struct TaskPromise : TaskPromiseBase
+    {
+        std::optional<T> value;
+
+        Task<T> get_return_object() noexcept;
+        template<class U>
+        void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+    };
+
+    template<>
+    struct TaskPromise<void> : TaskPromiseBase
+    {
+        Task<void> get_return_object() noexcept;
+        void return_void() const noexcept {}
+    };
+
+}
+
+// Lazy coroutine, nothing runs until it is awaited or started. Owns its frame, destroying a suspended task cancels it.
+// Exceptions thrown by the coroutine are rethrown to the awaiting coroutine.
+template<class T>
+class Task
+{
+public:
+
+    using promise_type = detail::TaskPromise<T>;
+    using handle_t = std::coroutine_handle<promise_type>;
+
+private:
+
+    handle_t m_handle;
+
+public:
+
+    Task() = default;
+    explicit Task(handle_t handle) : m_handle(handle) {}
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if (m_handle) m_handle.destroy(); }
+
+    // For tasks that nothing awaits, see AssetLoader::run
+    void start() { m_handle.resume(); }
+    bool isDone() const { return !m_handle || m_handle.done(); }
+    std::exception_ptr getException() const { return m_handle ? m_handle.promise().exception : nullptr; }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    T await_resume()
+    {
+        if (m_handle.promise().exception)
+            std::rethrow_exception(m_handle.promise().exception);
+        if constexpr (!std::is_void_v<T>)
+            return std::move(*m_handle.promise().value);
+    }
+};
+
+template<class T>
+Task<T> detail::TaskPromise<T>::get_return_object() noexcept { return Task<T>{ Task<T>::handle_t::from_promise(*this) }; }
+inline Task<void> detail::TaskPromise<void>::get_return_object() noexcept { return Task<void>{ Task<void>::handle_t::from_promise(*this) }; }
+
+// co_await ResumeOnWorker{} continues the coroutine on a worker thread, co_await ResumeOnMainThread{} brings it back.
+// Nothing keeps the coroutine alive meanwhile, its owner must not destroy it while it is queued.
+struct ResumeOnWorker
+{
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const { WorkerPool::get().post([handle] { handle.resume(); }); }
+    void await_resume() const noexcept {}
+};
+
+struct ResumeOnMainThread
+{
+    bool await_ready() const noexcept { return MainThread::IsCurrent(); }
+    void await_suspend(std::coroutine_handle<> handle) const { MainThread::Post([handle] { handle.resume(); }); }
+    void await_resume() const noexcept {}
+};
+
+}
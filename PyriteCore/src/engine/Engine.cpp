@@ -1,10 +1,14 @@
 #include "Engine.h"
 
 #include <utility>
+#include "AsyncTasks.h"
 #include "Directxlib.h"
 #include "display/DebugDraw.h"
 #include "display/FrameBuffer.h"
 #include "display/RenderProfiles.h"
+#include "display/ShaderCache.h"
+#include "display/TextureCache.h"
+#include "display/UpdateScheduler.h"
 #include "utils/Clock.h"
 
 #include "imgui/imgui_impl_dx11.h"
@@ -13,8 +17,10 @@
 #include "imNodesFlow/imnodes.h"
 
 #include "inputs/UserInputs.h"
+#include "scene/SceneChangeJournal.h"
 #include "scene/SceneManager.h"
 #include "utils/StringUtils.h"
+#include "world/TransformHierarchy.h"
 #include "display/GraphicalResource.h"
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -109,6 +115,7 @@ Engine::Engine(HINSTANCE hInstance, EngineSettings settings)
 
 Engine::~Engine()
 {
+  ShaderCache::get().logStats();
   m_primaryFrameBuffer->unbind();
 
   ImGui_ImplDX11_Shutdown();
@@ -139,7 +146,7 @@ void Engine::run()
       runFrame(static_cast<float>(delta));
     }
     
-    // if scenes need to be created/deleted drop the frames instead of trying to catch back
+    // if scenes were created/deleted drop the frames instead of trying to catch back
     if (SceneManager::getInstance().doSceneTransition())
       m_previousTime = m_clock.getTimeAsCount();
     else
@@ -150,9 +157,14 @@ void Engine::run()
 void Engine::runFrame(float deltaTime)
 {
   // update
+  SceneChangeJournal::get().beginFrame();
   UserInputs::pollEvents();
+  MainThread::PumpTasks(); // asynchronous loads complete before the scene sees the frame
   SceneManager::getInstance().update(deltaTime);
+  TransformHierarchy::get().update();
   DebugDraws::get().tick(deltaTime);
+  UpdateScheduler::get().beginFrame();
+  TextureCache::get().beginFrame();
 
   // render
   FrameBuffer::getActiveFrameBuffer().clearTargets();
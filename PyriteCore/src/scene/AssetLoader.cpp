@@ -0,0 +1,145 @@
+#include "AssetLoader.h"
+
+#include <array>
+#include <cmath>
+
+#include "display/ImageDecoder.h"
+#include "world/Material.h"
+#include "world/Mesh/MeshImporter.h"
+#include "world/Mesh/Model.h"
+
+namespace pyr
+{
+
+	AssetLoader::AssetLoader(GraphicalResourceRegistry& registry)
+		: m_registry(registry)
+	{
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		// Workers still running keep their results to themselves and never resume the destroyed frames
+		m_state->bCancelled = true;
+		m_tasks.clear();
+
+		for (const std::shared_ptr<Material>& material : m_loadedMaterials)
+			MaterialBank::UnregisterMaterial(material->getBankHandle());
+	}
+
+	void AssetLoader::run(Task<void> task)
+	{
+		collectCompletedTasks();
+		m_tasks.push_back(std::move(task));
+		m_startedTaskCount++;
+		m_tasks.back().start();
+	}
+
+	size_t AssetLoader::getPendingCount()
+	{
+		collectCompletedTasks();
+		return m_tasks.size();
+	}
+
+	float AssetLoader::getProgress()
+	{
+		collectCompletedTasks();
+		return m_startedTaskCount ? 1.F - static_cast<float>(m_tasks.size()) / static_cast<float>(m_startedTaskCount) : 1.F;
+	}
+
+	void AssetLoader::collectCompletedTasks()
+	{
+		std::erase_if(m_tasks, [](const Task<void>& task)
+		{
+			if (!task.isDone()) return false;
+			if (std::exception_ptr exception = task.getException())
+			{
+				try { std::rethrow_exception(exception); }
+				catch (const std::exception& e) { const char* what = e.what(); PYR_LOGF(LogAssetLoader, WARN, "Asset load failed: {}", what); }
+				catch (...) { PYR_LOG(LogAssetLoader, WARN, "Asset load failed with an unknown exception"); }
+			}
+			return true;
+		});
+	}
+
+	Task<Texture> AssetLoader::loadTexture(std::filesystem::path path, bool bGenerateMips /* = true */)
+	{
+		std::optional<ImageDecoder::DecodedImage> decoded = co_await onWorker([path] { return ImageDecoder::DecodeFile(path); });
+		co_return m_registry.loadTexture(path.wstring(), bGenerateMips, decoded ? &*decoded : nullptr);
+	}
+
+	Task<std::vector<std::shared_ptr<Model>>> AssetLoader::loadModel(std::filesystem::path path, bool bFlipUVs /* = false */)
+	{
+		MeshImporter::ImportedMeshes imported = co_await onWorker([path, bFlipUVs]
+		{
+			MeshImporter::ImportedMeshes imported = MeshImporter::ReadMeshesFromFile(path, bFlipUVs);
+			for (const std::optional<MeshImporter::ImportedMaterial>& material : imported.materials)
+				if (material) Material::CookTextures(material->paths);
+			return imported;
+		});
+		std::vector<std::shared_ptr<Model>> models = MeshImporter::CreateModels(imported);
+		// The models of a file share its material table
+		if (!models.empty())
+			for (const std::shared_ptr<Material>& material : models.front()->getDefaultSubmeshesMaterials())
+				if (material) m_loadedMaterials.push_back(material);
+		co_return models;
+	}
+
+	Task<const Effect*> AssetLoader::loadEffect(std::filesystem::path path, InputLayout layout, std::vector<Effect::define_t> defines /* = {} */)
+	{
+		// Already compiled on a worker by the registry, the coroutine only waits for it to be done
+		const Effect* effect = m_registry.loadEffect(path.wstring(), layout, defines);
+		co_await CompilationAwaiter{ .state = m_state, .effect = effect };
+		effect->waitForCompilation(); // does not block anymore, rethrows the compilation error
+		co_return effect;
+	}
+
+	Texture AssetLoader::GetPlaceholderTexture()
+	{
+		return Texture::getDefaultTextureSet().WhitePixel;
+	}
+
+	std::shared_ptr<Model> AssetLoader::GetPlaceholderModel()
+	{
+		static std::shared_ptr<Model> placeholder = []
+		{
+			using vertex_t = RawMeshData::mesh_vertex_t;
+
+			// 4 vertices per face so that each face has its own normal
+			constexpr std::array<std::array<float, 3>, 6> normals{ {
+				{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+			} };
+			std::vector<vertex_t> vertices;
+			std::vector<RawMeshData::mesh_indice_t> indices;
+			for (const auto& [nx, ny, nz] : normals)
+			{
+				const vec3 normal{ nx, ny, nz };
+				const vec3 tangent = std::abs(ny) > 0 ? vec3{ 1, 0, 0 } : vec3{ 0, 1, 0 };
+				const vec3 bitangent = normal.Cross(tangent);
+				const auto base = static_cast<RawMeshData::mesh_indice_t>(vertices.size());
+				for (const auto& [u, v] : std::array<std::array<float, 2>, 4>{ { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } } })
+				{
+					const vec3 position = (normal + tangent * (u * 2 - 1) + bitangent * (v * 2 - 1)) * .5F;
+					vertex_t vertex{};
+					vertex.position = vec4{ position.x, position.y, position.z, 1.F };
+					vertex.normal = normal;
+					vertex.texCoords = vec2{ u, v };
+					vertices.push_back(vertex);
+				}
+				// Winding matches the meshes imported with aiProcess_FlipWindingOrder
+				for (RawMeshData::mesh_indice_t i : { 0, 2, 1, 0, 3, 2 })
+					indices.push_back(base + i);
+			}
+
+			const std::vector<SubMesh> submeshes{ SubMesh{
+				.startIndex = 0,
+				.endIndex = static_cast<IndexBuffer::size_type>(indices.size()),
+				.materialIndex = 0,
+				.matName = "AssetPlaceholder",
+			} };
+			std::shared_ptr<Material> material = Material::MakeRegisteredMaterial({}, {}, MaterialBank::GetDefaultGGXShader(), "AssetPlaceholder");
+			return std::make_shared<Model>(std::make_shared<RawMeshData>(vertices, indices, submeshes), Model::SubmeshesMaterialTable{ material });
+		}();
+		return placeholder;
+	}
+
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "engine/AsyncTasks.h"
+#include "display/GraphicalResource.h"
+#include "utils/Debug.h"
+
+static inline PYR_DEFINELOG(LogAssetLoader, VERBOSE);
+
+namespace pyr
+{
+
+class Material;
+class Model;
+
+// Loads assets without stalling frames, for scenes to build themselves progressively:
+//
+//   m_assets.run(m_assets.loadInto(m_model, m_assets.loadModel(L"res/meshes/model.obj")));
+//   // or, from a Task<void> coroutine
+//   std::vector<std::shared_ptr<Model>> models = co_await m_assets.loadModel(L"res/meshes/model.obj");
+//
+// Files are read and decoded on the WorkerPool, GPU objects are created once back on the main thread, between two frames.
+// Coroutines always resume on the main thread and may use any engine system.
+//
+// Destroying the loader cancels every task still running: the coroutines are destroyed while suspended, they never resume.
+// It must therefore be destroyed before whatever its coroutines reference, declare it after them in the owning scene.
+// Work given to onWorker may still be running at that point, it must not reference the loader nor its owner.
+// The materials of the models it loaded leave the MaterialBank with it, they live on as long as the models do.
+class AssetLoader
+{
+private:
+
+    // Shared with the worker closures, that may finish after the loader is gone
+    struct State
+    {
+        std::atomic<bool> bCancelled = false;
+    };
+
+    // Runs work on a worker and resumes the awaiting coroutine on the main thread, unless the loader was destroyed meanwhile.
+    // The worker never touches the coroutine frame, its result goes through a slot it shares with the awaiter.
+    template<class F>
+    struct WorkerAwaiter
+    {
+        using result_t = std::invoke_result_t<F&>;
+
+        struct ResultSlot
+        {
+            std::optional<result_t> result;
+            std::exception_ptr exception;
+        };
+
+        std::shared_ptr<State> state;
+        F work;
+        std::shared_ptr<ResultSlot> slot = std::make_shared<ResultSlot>();
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            WorkerPool::get().post([handle, state = state, slot = slot, work = std::move(work)]() mutable
+            {
+                // Results of a cancelled load are dropped, the frame waiting for them is already destroyed
+                if (state->bCancelled) return;
+                try { slot->result.emplace(work()); }
+                catch (...) { slot->exception = std::current_exception(); }
+                if (state->bCancelled) return;
+                // Checked again on the main thread, where the loader is destroyed
+                MainThread::Post([handle, state] { if (!state->bCancelled) handle.resume(); });
+            });
+        }
+        result_t await_resume()
+        {
+            if (slot->exception) std::rethrow_exception(slot->exception);
+            return std::move(*slot->result);
+        }
+    };
+
+    // Resumes the awaiting coroutine once the effect compiled, checked at the start of each frame so that no thread blocks on it
+    struct CompilationAwaiter
+    {
+        std::shared_ptr<State> state;
+        const Effect* effect;
+
+        bool await_ready() const { return effect->isCompiled(); }
+        void await_suspend(std::coroutine_handle<> handle) const { Poll(state, effect, handle); }
+        void await_resume() const noexcept {}
+
+        static void Poll(std::shared_ptr<State> state, const Effect* effect, std::coroutine_handle<> handle)
+        {
+            // Posted again from the task itself, it runs on the next frame
+            MainThread::Post([state, effect, handle]
+            {
+                if (state->bCancelled) return;
+                if (effect->isCompiled()) handle.resume();
+                else Poll(state, effect, handle);
+            });
+        }
+    };
+
+public:
+
+    explicit AssetLoader(GraphicalResourceRegistry& registry);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Starts a task that nothing awaits and keeps it alive until it completes, exceptions are logged
+    void run(Task<void> task);
+    size_t getPendingCount();
+    // Fraction of the tasks given to run that completed, 1 if there are none, see Scene::getLoadingProgress
+    float getProgress();
+
+    // Textures and effects are kept alive by the registry given at construction
+    Task<Texture> loadTexture(std::filesystem::path path, bool bGenerateMips = true);
+    // Materials are cooked on the workers, their DDS are loaded when the models are created
+    Task<std::vector<std::shared_ptr<Model>>> loadModel(std::filesystem::path path, bool bFlipUVs = false);
+    // Completes once the effect is compiled, loading it from the registry directly would only wait for it on its first use
+    Task<const Effect*> loadEffect(std::filesystem::path path, InputLayout layout, std::vector<Effect::define_t> defines = {});
+
+    // Assigns the result of a load to target once it completes, target keeps its placeholder until then
+    template<class T>
+    Task<void> loadInto(T& target, Task<T> task) { target = co_await std::move(task); }
+
+    template<class F>
+    WorkerAwaiter<F> onWorker(F work) { return WorkerAwaiter<F>{ .state = m_state, .work = std::move(work) }; }
+
+    // Stand-ins to use until the real resources are ready
+    static Texture GetPlaceholderTexture();
+    static std::shared_ptr<Model> GetPlaceholderModel(); // a unit cube, with the default material
+
+private:
+
+    void collectCompletedTasks();
+
+private:
+
+    GraphicalResourceRegistry& m_registry;
+    std::shared_ptr<State> m_state = std::make_shared<State>();
+    std::vector<Task<void>> m_tasks;
+    size_t m_startedTaskCount = 0;
+    std::vector<std::shared_ptr<Material>> m_loadedMaterials;
+};
+
+}
@@ -3,6 +3,8 @@
 #include <vector>
 
 #include "world/Lights/Light.h"
+#include "world/Mesh/MeshComponents.h"
+#include "world/Mesh/StaticMesh.h"
 
 /// RenderableActorCollection
 /// 
@@ -16,5 +18,35 @@ namespace pyr
 		std::vector<const class StaticMesh*> meshes;
 		std::vector<const struct Billboard*> billboards;
 		pyr::LightsCollections lights;
+
+		// Prefer these to editing the vectors, they tell the SceneChangeJournal
+		void addMesh(const StaticMesh* mesh)
+		{
+			meshes.push_back(mesh);
+			SceneChangeJournal::get().record(mesh->GetActorID(), SceneChangeJournal::ADDED);
+		}
+
+		void removeMesh(const StaticMesh* mesh)
+		{
+			if (std::erase(meshes, mesh) > 0)
+				SceneChangeJournal::get().record(mesh->GetActorID(), SceneChangeJournal::REMOVED);
+		}
+
+		void clearMeshes()
+		{
+			for (const StaticMesh* mesh : meshes)
+				SceneChangeJournal::get().record(mesh->GetActorID(), SceneChangeJournal::REMOVED);
+			meshes.clear();
+		}
+
+		// Bounds of the meshes in parallel arrays, for culling. Synchronized with the vector on access.
+		const MeshComponents& getMeshComponents() const
+		{
+			m_meshComponents.sync(meshes);
+			return m_meshComponents;
+		}
+
+	private:
+		mutable MeshComponents m_meshComponents;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "SceneChangeJournal.h"
+
+namespace pyr
+{
+
+	SceneChangeJournal SceneChangeJournal::s_singleton;
+
+	void SceneChangeJournal::record(actor_id_t actor, uint8_t flags)
+	{
+		// A system may have read the first addition already, a removal and a new addition in the same frame must reach it
+		constexpr uint8_t MEMBERSHIP_FLAGS = ADDED | REMOVED;
+
+		uint8_t& frameFlags = m_frameFlags[actor];
+		const uint8_t newFlags = (flags & ~frameFlags) | (flags & MEMBERSHIP_FLAGS);
+		if (newFlags == 0) return;
+
+		frameFlags |= newFlags;
+		m_allFrameFlags |= newFlags;
+		m_changes.push_back(Change{ .actor = actor, .flags = newFlags });
+	}
+
+	uint8_t SceneChangeJournal::getFrameFlags(actor_id_t actor) const
+	{
+		auto it = m_frameFlags.find(actor);
+		return it != m_frameFlags.end() ? it->second : 0;
+	}
+
+	void SceneChangeJournal::beginFrame()
+	{
+		m_changes.erase(m_changes.begin(), m_changes.begin() + m_frameStart);
+		m_firstSequence += m_frameStart;
+		m_frameStart = m_changes.size();
+		m_frameFlags.clear();
+		m_allFrameFlags = 0;
+	}
+
+}
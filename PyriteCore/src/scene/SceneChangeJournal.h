@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace pyr
+{
+
+// Records what changes in the scenes, for the systems that keep data from one frame to the next to only update what changed.
+// Changes are recorded by the accessors that make them:
+//   - Actor::GetTransform (the mutable one, any call counts as a change) and Actor::SetTransform
+//   - StaticMesh::overrideSubmeshMaterial
+//   - the add/remove methods of RegisteredRenderableActorCollection and LightsCollections
+//
+// Each system reads the changes with its own cursor, that starts at 0:
+//
+//   bool bComplete = SceneChangeJournal::get().consume(m_journalCursor, [&](const SceneChangeJournal::Change& change) { ... });
+//   if (!bComplete) ... // some changes were dropped before they were read, everything must be refreshed
+//
+// Changes are kept for the current and the previous frame, a system reading once per frame never misses any.
+// Main thread only.
+class SceneChangeJournal
+{
+public:
+
+    using actor_id_t = uint32_t; // Actor::id_t
+
+    enum ChangeFlags : uint8_t
+    {
+        ADDED     = 1 << 0, // to a RegisteredRenderableActorCollection
+        REMOVED   = 1 << 1,
+        TRANSFORM = 1 << 2,
+        MATERIAL  = 1 << 3,
+    };
+
+    struct Change
+    {
+        actor_id_t actor = 0;
+        uint8_t flags = 0;
+    };
+
+    static SceneChangeJournal& get() { return s_singleton; }
+
+    // Changes already recorded for the actor this frame are not recorded again, additions and removals always are
+    void record(actor_id_t actor, uint8_t flags);
+
+    // Dirty bits of the current frame
+    uint8_t getFrameFlags(actor_id_t actor) const;
+    uint8_t getFrameFlags() const { return m_allFrameFlags; }
+
+    // Calls onChange for each change recorded since the cursor, in order, and moves the cursor past them.
+    // Returns false if changes were dropped before the cursor got to them.
+    template<class F>
+    bool consume(uint64_t& cursor, F&& onChange) const
+    {
+        const uint64_t end = m_firstSequence + m_changes.size();
+        const bool bComplete = cursor >= m_firstSequence;
+        for (uint64_t sequence = bComplete ? cursor : m_firstSequence; sequence < end; sequence++)
+            onChange(m_changes[static_cast<size_t>(sequence - m_firstSequence)]);
+        cursor = end;
+        return bComplete;
+    }
+
+    // Drops the changes of the previous frame, called by the engine at the start of each frame
+    void beginFrame();
+
+private:
+
+    SceneChangeJournal() = default;
+    SceneChangeJournal(const SceneChangeJournal&) = delete;
+    SceneChangeJournal& operator=(const SceneChangeJournal&) = delete;
+
+    static SceneChangeJournal s_singleton;
+
+    std::vector<Change> m_changes;  // changes of the previous frame, then of the current one
+    size_t m_frameStart = 0;         // index of the first change of the current frame
+    uint64_t m_firstSequence = 0;    // sequence number of m_changes[0]
+    std::unordered_map<actor_id_t, uint8_t> m_frameFlags;
+    uint8_t m_allFrameFlags = 0;
+};
+
+}
@@ -12,10 +12,16 @@ namespace pyr
 void SceneManager::transitionToScene(SceneSupplier nextSceneSupplier)
 {
   if (m_activeScene == nullptr)
+  {
     m_activeScene = nextSceneSupplier();
+    m_activeSceneName.resize(0);
+    m_activeScene->onActivated();
+  }
   else
+  {
     m_nextScene = std::move(nextSceneSupplier);
-  m_activeSceneName.resize(0);
+  }
+  m_nextSceneName.resize(0);
 }
 
 bool SceneManager::transitionToScene(const std::string& sceneName)
@@ -23,8 +29,9 @@ bool SceneManager::transitionToScene(const std::string& sceneName)
   SceneSupplier initialSceneSupplier = getRegisteredScene(sceneName);
   if (initialSceneSupplier)
   {
+    const bool bImmediate = m_activeScene == nullptr;
     transitionToScene(std::move(initialSceneSupplier));
-    m_activeSceneName = sceneName;
+    (bImmediate ? m_activeSceneName : m_nextSceneName) = sceneName;
     return true;
   }
   return false;
@@ -32,19 +39,35 @@ bool SceneManager::transitionToScene(const std::string& sceneName)
 
 void SceneManager::dispose()
 {
+  m_loadingScene.reset();
   m_activeScene.reset();
 }
 
 bool SceneManager::doSceneTransition()
 {
+  bool bTransitioned = false;
+
+  // The scene is constructed while the active one is still alive, only its assets that are loaded synchronously stall this frame.
+  // A newer request replaces a scene that did not finish loading, destroying it cancels its pending loads.
   if (m_nextScene)
   {
-    m_activeScene.reset();
-    m_activeScene = m_nextScene();
+    m_loadingScene.reset();
+    m_loadingScene = m_nextScene();
     m_nextScene = {};
-    return true;
+    bTransitioned = true;
   }
-  return false;
+
+  if (m_loadingScene && m_loadingScene->getLoadingProgress() >= 1.f)
+  {
+    m_activeScene.reset();
+    m_activeScene = std::move(m_loadingScene);
+    m_activeSceneName = std::move(m_nextSceneName);
+    m_nextSceneName.resize(0);
+    m_activeScene->onActivated();
+    bTransitioned = true;
+  }
+
+  return bTransitioned;
 }
 
 void SceneManager::update(double delta)
@@ -66,6 +89,11 @@ void SceneManager::render()
         : ImGui::Button(name.c_str()))
         transitionToScene(name);
     }
+    if (m_loadingScene)
+    {
+      ImGui::Text("Loading %s...", m_nextSceneName.c_str());
+      ImGui::ProgressBar(m_loadingScene->getLoadingProgress());
+    }
     ImGui::End();
   }
 }
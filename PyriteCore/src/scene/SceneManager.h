@@ -19,6 +19,8 @@ public:
       return instance; 
   }
   static Scene* getActiveScene() { return getInstance().m_activeScene.get(); }
+  // The scene being loaded in the background, not updated nor rendered until it replaces the active one
+  static Scene* getLoadingScene() { return getInstance().m_loadingScene.get(); }
   static RegisteredRenderableActorCollection& GetCurrentSceneActors() { return getActiveScene()->SceneActors; }
 
 public:
@@ -39,6 +41,8 @@ public:
   bool transitionToScene(const std::string& sceneName);
   void dispose();
 
+  // Called between frames. Constructs the requested scene, and makes it active once it finished loading.
+  // Returns true if a scene was created or destroyed.
   bool doSceneTransition();
 
   void update(double delta);
@@ -61,7 +65,9 @@ private:
 
   std::map<std::string, SceneSupplier> m_knownScenes;
   std::string m_activeSceneName;
+  std::string m_nextSceneName;
   SceneSupplier m_nextScene;
+  std::unique_ptr<Scene> m_loadingScene;
   std::unique_ptr<Scene> m_activeScene;
 };
 
@@ -15,6 +15,14 @@ public:
   virtual void update(float delta) = 0;
   virtual void render() = 0;
 
+  // In [0,1]. A scene that loads its assets asynchronously (see AssetLoader) reports its progress here,
+  // the SceneManager keeps showing the previous scene until it reaches 1.
+  virtual float getLoadingProgress() { return 1.f; }
+
+  // Called when the scene replaces the active one, before its first update. A loading scene must not touch
+  // what the active scene is still using (the editor tools...), it takes them over here.
+  virtual void onActivated() {}
+
   RegisteredRenderableActorCollection SceneActors;
   class pyr::RenderGraph SceneRenderGraph;
 };
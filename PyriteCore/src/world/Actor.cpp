@@ -0,0 +1,56 @@
+#include "Actor.h"
+
+#include <utility>
+
+namespace pyr
+{
+
+	Actor::Actor(const Actor& other)
+		: m_actorId(other.m_actorId)
+		, m_actorTransform(other.m_actorTransform)
+		, m_mobility(other.m_mobility)
+	{
+	}
+
+	Actor::Actor(Actor&& other) noexcept
+		: Actor(static_cast<const Actor&>(other))
+	{
+		// Actors stored in a vector keep their links when the vector grows
+		std::swap(m_hierarchyNode, other.m_hierarchyNode);
+		if (m_hierarchyNode != TransformHierarchy::NO_NODE)
+			TransformHierarchy::get().relocateNode(m_hierarchyNode, *this);
+		m_transformRevision = other.m_transformRevision;
+	}
+
+	Actor& Actor::operator=(const Actor& other)
+	{
+		// Keeps its own place in the hierarchy
+		m_actorId = other.m_actorId;
+		m_mobility = other.m_mobility;
+		SetTransform(other.m_actorTransform);
+		return *this;
+	}
+
+	Actor& Actor::operator=(Actor&& other) noexcept
+	{
+		if (this == &other) return *this;
+
+		if (m_hierarchyNode != TransformHierarchy::NO_NODE)
+			TransformHierarchy::get().removeNode(m_hierarchyNode);
+		*this = static_cast<const Actor&>(other);
+		std::swap(m_hierarchyNode, other.m_hierarchyNode);
+		if (m_hierarchyNode != TransformHierarchy::NO_NODE)
+		{
+			TransformHierarchy::get().relocateNode(m_hierarchyNode, *this);
+			TransformHierarchy::get().markChanged(m_hierarchyNode);
+		}
+		return *this;
+	}
+
+	Actor::~Actor()
+	{
+		if (m_hierarchyNode != TransformHierarchy::NO_NODE)
+			TransformHierarchy::get().removeNode(m_hierarchyNode);
+	}
+
+}
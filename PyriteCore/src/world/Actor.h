@@ -1,27 +1,78 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <type_traits>
 #include "world/Transform.h"
+#include "world/TransformHierarchy.h"
+#include "scene/SceneChangeJournal.h"
 
 namespace pyr
 {
 
+	enum class ActorMobility : uint8_t
+	{
+		Static,  // < can still be moved, but systems caching things about the actor (shadows...) expect it to be rare
+		Movable, // < never cached, redrawn every frame
+	};
+
 	class Actor
 	{
 	public:
 		using id_t = uint32_t;
 		id_t GetActorID()				const	{ return m_actorId; }
 		const Transform& GetTransform()	const	{ return m_actorTransform; } 
-		Transform& GetTransform()				{ return m_actorTransform; }
+		// Recorded as a transform change in the SceneChangeJournal, use the const overload to only read.
+		// The world matrix is computed again on its next use, the reference must not be kept across frames.
+		Transform& GetTransform()
+		{
+			SceneChangeJournal::get().record(m_actorId, SceneChangeJournal::TRANSFORM);
+			m_bWorldMatrixDirty = true;
+			m_transformRevision++;
+			return m_actorTransform;
+		}
+		void SetTransform(const Transform& transform) { GetTransform() = transform; }
+
+		// Cached until the transform or a parent changes. With a parent (see TransformHierarchy), the parent is seen as of
+		// the last TransformHierarchy::update, which runs every frame before rendering.
+		const mat4& GetWorldMatrix()	const
+		{
+			if (m_bWorldMatrixDirty)
+			{
+				m_worldMatrix = m_actorTransform.getWorldMatrix();
+				if (m_hierarchyNode != TransformHierarchy::NO_NODE)
+					m_worldMatrix *= TransformHierarchy::get().getParentWorldMatrix(m_hierarchyNode);
+				m_bWorldMatrixDirty = false;
+			}
+			return m_worldMatrix;
+		}
+
+		ActorMobility GetMobility()		const	{ return m_mobility; }
+		void SetMobility(ActorMobility mobility){ m_mobility = mobility; }
 
 	public:
-		virtual ~Actor() = default;
+		Actor() = default;
+		Actor(const Actor& other);			// the copy has no parent
+		Actor(Actor&& other) noexcept;		// takes the place of other in the TransformHierarchy
+		Actor& operator=(const Actor& other);
+		Actor& operator=(Actor&& other) noexcept;
+		virtual ~Actor();
 
 	private:
-		static inline id_t NextID = 1;
-		id_t m_actorId = NextID++;
+		friend class TransformHierarchy;
+
+		static_assert(std::is_same_v<id_t, SceneChangeJournal::actor_id_t>);
+		// Actors may be created by asset loads running on the workers
+		static inline std::atomic<id_t> NextID = 1;
+		id_t m_actorId = NextID.fetch_add(1, std::memory_order_relaxed);
 
 		Transform m_actorTransform;
+		ActorMobility m_mobility = ActorMobility::Static;
+
+		mutable mat4 m_worldMatrix;
+		mutable bool m_bWorldMatrixDirty = true;
+		uint32_t m_transformRevision = 0;
+		TransformHierarchy::node_t m_hierarchyNode = TransformHierarchy::NO_NODE;
 	};
 
 
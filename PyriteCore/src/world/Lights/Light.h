@@ -34,10 +34,8 @@ enum ShadowMode : uint32_t
 
 enum ShadowMapSlot : int
 {
-	// 0 - 15 are texture 2D, 16-31 are textureCube
+	// Slice of the 2D shadow array for spots and directionals, cube of the cube array for points (see ShadowAtlas)
 	None = -1,
-	Max_Texture2D_Slot = 15, 
-	Max_TextureCube_Slot = 31, 
 };
 
 
@@ -50,6 +48,7 @@ struct hlsl_GenericLight
 	vec4	ambiant;
 	vec4	diffuse;
 	vec4	projection; // < for shadows
+	vec4	shadowMapRect = { 0,0,1,1 }; // < uv offset (xy) and scale (zw) of the shadow map in its slice
 
 	float specularFactor;
 	float fallOff;
@@ -58,8 +57,8 @@ struct hlsl_GenericLight
 
 	LightTypeID type;
 	ShadowMode shadowMode = NoShadow;
-	ShadowMapSlot shadowMapIndex = ShadowMapSlot::None; // -1 means no shadow, < 16 is 2d and < 32 is cube
-	float padding[1];
+	ShadowMapSlot shadowMapIndex = ShadowMapSlot::None; // -1 means no shadow, first cascade for directional lights
+	uint32_t shadowCascadeCount = 0; // directional lights only
 };
 
 /// =============================================================================================================================================================///
@@ -71,6 +70,7 @@ struct BaseLight : public Actor
 	vec4 diffuse = {1,1,1,1};
 	ShadowMode shadowMode = NoShadow;
 	int shadowMapIndex = -1;
+	vec4 shadowMapRect = { 0,0,1,1 }; // set by the forward pass each frame, depending on the region of the atlas the light got
 	BaseLight()
 	{
 		GetTransform().rotation = vec4{ 0,-1,0,0 }; // todo make this a directional arrow widget someday ? and make this cleaner
@@ -92,7 +92,13 @@ inline hlsl_GenericLight convertLightTo_HLSL(const L& light);
 struct DirectionalLight : public BaseLight {
 
 	float strength = 1.0F;
-	OrthographicProjection shadow_projection{};
+
+	// Shadows are cascaded over the view frustum of the camera, see CascadedShadowMaps
+	int cascadeCount = 4;
+	float cascadeSplitLambda = .8F; // 0 splits the frustum uniformly, 1 logarithmically
+	float shadowDistance = 150.F;   // nothing is shadowed past this distance from the camera
+	uint32_t shadowCascadeCount = 0; // set by the forward pass, 0 if the light did not get a shadow map this frame
+
 	virtual LightTypeID getType() const override final { return Directional; }
 };
 
@@ -105,7 +111,8 @@ inline hlsl_GenericLight convertLightTo_HLSL<DirectionalLight>(const Directional
 		.position = {},
 		.ambiant = light.ambiant,
 		.diffuse = light.diffuse,
-		.projection = light.shadow_projection.packValues(),
+		.projection = {},
+		.shadowMapRect = light.shadowMapRect,
 		.specularFactor = {},
 		.fallOff = {},
 		.strength = light.strength,
@@ -113,6 +120,7 @@ inline hlsl_GenericLight convertLightTo_HLSL<DirectionalLight>(const Directional
 		.type = LightTypeID::Directional,
 		.shadowMode = light.shadowMode,
 		.shadowMapIndex = static_cast<ShadowMapSlot>(light.shadowMapIndex),
+		.shadowCascadeCount = light.shadowCascadeCount,
 	};
 }
 
@@ -202,6 +210,7 @@ inline hlsl_GenericLight convertLightTo_HLSL<SpotLight>(const SpotLight& light)
 		.ambiant = light.ambiant,
 		.diffuse = light.diffuse,
 		.projection = light.shadow_projection.packValues(),
+		.shadowMapRect = light.shadowMapRect,
 		.specularFactor = light.specularFactor,
 		.fallOff = light.outsideAngle,
 		.strength = light.strength,
@@ -225,22 +234,13 @@ struct LightsCollections {
 	std::vector<PointLight> Points;
 	std::vector<DirectionalLight> Directionals;
 
-	template<size_t N = 16>
-	std::array<hlsl_GenericLight, N> ConvertCollectionToHLSL() const
+	// Calls visit with each light as its concrete type, the lights are packed for the GPU by LightPacker
+	template<class F>
+	void forEachLight(F&& visit) const
 	{
-		if (!PYR_ENSURE(Spots.size() + Points.size() + Directionals.size() <= N)) return {};
-
-		std::array<hlsl_GenericLight, N> res;
-
-		auto it = res.begin();
-		for (const SpotLight& spot : Spots)
-			*(it++) = convertLightTo_HLSL<SpotLight>(spot);
-		for (const PointLight& point : Points)
-			*(it++) = convertLightTo_HLSL<PointLight>(point);
-		for (const DirectionalLight& dir : Directionals)
-			*(it++) = convertLightTo_HLSL<DirectionalLight>(dir);
-
-		return res;
+		for (const SpotLight& spot : Spots)					visit(spot);
+		for (const PointLight& point : Points)				visit(point);
+		for (const DirectionalLight& dir : Directionals)	visit(dir);
 	}
 
 	// Will do the trick for now, as i don't want to return const ptr and i need this method to be const. Too bad !
@@ -254,8 +254,19 @@ struct LightsCollections {
 	}
 
 
+	// Returns the light stored in the collection, valid until another light of the same type is added or removed
+	template<class L> requires std::derived_from<L, BaseLight>
+	L& AddLight(L light)
+	{
+		SceneChangeJournal::get().record(light.GetActorID(), SceneChangeJournal::ADDED);
+		if constexpr (std::is_same_v<L, SpotLight>) return Spots.emplace_back(std::move(light));
+		else if constexpr (std::is_same_v<L, PointLight>) return Points.emplace_back(std::move(light));
+		else return Directionals.emplace_back(std::move(light));
+	}
+
 	void AddLight(const BaseLight* light)
 	{
+		SceneChangeJournal::get().record(light->GetActorID(), SceneChangeJournal::ADDED);
 		switch (light->getType())
 		{
 		case LightTypeID::Point: Points.push_back(*reinterpret_cast<const PointLight*>(light)); break;
@@ -266,11 +277,13 @@ struct LightsCollections {
 
 	void Clear()
 	{
+		forEachLight([](const BaseLight& light) { SceneChangeJournal::get().record(light.GetActorID(), SceneChangeJournal::REMOVED); });
 		Spots.clear(), Directionals.clear(); Points.clear();
 	}
 
 	void RemoveLight(BaseLight* light)
 	{
+		SceneChangeJournal::get().record(light->GetActorID(), SceneChangeJournal::REMOVED);
 		{
 			const auto [first,last] = std::ranges::remove_if(Spots, [light](SpotLight& l) { return &l == light; });
 			Spots.erase(first, last);
@@ -0,0 +1,66 @@
+#include "LightPacker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace pyr
+{
+
+	void LightPacker::update(const LightsCollections& lights)
+	{
+		// Lights keep their slot, the slots of the lights that left are freed before new lights get one.
+		// Copies of a light share its id, each one gets its own slot.
+		m_slotStates.fill(NOT_SEEN);
+		lights.forEachLight([this](const BaseLight& light)
+		{
+			for (size_t slot = 0; slot < MAX_LIGHTS; slot++)
+			{
+				if (m_actors[slot] != light.GetActorID() || m_slotStates[slot] != NOT_SEEN) continue;
+				m_slotStates[slot] = MATCHED;
+				break;
+			}
+		});
+		for (size_t slot = 0; slot < MAX_LIGHTS; slot++)
+		{
+			if (m_actors[slot] == FREE_SLOT || m_slotStates[slot] != NOT_SEEN) continue;
+			m_actors[slot] = FREE_SLOT;
+			m_records.lights[slot] = {}; // off
+			m_bRecordsChanged = true;
+		}
+
+		lights.forEachLight([this](const auto& light) { updateLight(light); });
+
+		if (m_bRecordsChanged)
+		{
+			m_buffer->setData(m_records);
+			m_bRecordsChanged = false;
+		}
+	}
+
+	template<class L>
+	void LightPacker::updateLight(const L& light)
+	{
+		const SceneChangeJournal::actor_id_t actor = light.GetActorID();
+		size_t slot = 0;
+		while (slot < MAX_LIGHTS && (m_actors[slot] != actor || m_slotStates[slot] != MATCHED))
+			slot++;
+		if (slot == MAX_LIGHTS)
+		{
+			slot = static_cast<size_t>(std::distance(m_actors.begin(), std::ranges::find(m_actors, FREE_SLOT)));
+			if (!PYR_ENSURE(slot < MAX_LIGHTS, "Too many lights, see LightsBuffer")) return;
+			m_actors[slot] = actor;
+		}
+		m_slotStates[slot] = UPDATED;
+
+		// hlsl_GenericLight only holds 4 bytes fields, it has no padding that could differ between two equal records
+		const hlsl_GenericLight packed = convertLightTo_HLSL<L>(light);
+		hlsl_GenericLight& record = m_records.lights[slot];
+		if (std::memcmp(&record, &packed, sizeof(hlsl_GenericLight)) != 0)
+		{
+			record = packed;
+			m_bRecordsChanged = true;
+		}
+	}
+
+}
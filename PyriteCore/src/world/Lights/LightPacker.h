@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "world/Lights/Light.h"
+#include "world/Tools/CommonConstantBuffers.h"
+
+namespace pyr
+{
+
+// The lights of a collection packed in the layout of LightsBuffer, kept along with the buffer from one frame to the next.
+// A light keeps its record until it leaves the collection. Light fields are written directly by scenes, the editor and the
+// shadow renderer, so every light is packed each frame and compared with its record: with 16 lights at most this costs nothing.
+// The buffer is uploaded when a record changed, as a whole: constant buffers can't be partially updated with the 11.0 context.
+class LightPacker
+{
+public:
+
+    static constexpr size_t MAX_LIGHTS = std::extent_v<decltype(LightsBuffer::data_t::lights)>;
+
+    void update(const LightsCollections& lights);
+
+    const std::shared_ptr<LightsBuffer>& getBuffer() const { return m_buffer; }
+
+private:
+
+    template<class L>
+    void updateLight(const L& light);
+
+private:
+
+    static constexpr SceneChangeJournal::actor_id_t FREE_SLOT = 0; // actor ids start at 1
+    enum SlotState : uint8_t { NOT_SEEN, MATCHED, UPDATED };
+
+    // Per slot
+    std::array<SceneChangeJournal::actor_id_t, MAX_LIGHTS> m_actors{};
+    std::array<SlotState, MAX_LIGHTS> m_slotStates{}; // during update, the slots of the lights that left are not seen
+    LightsBuffer::data_t m_records{};
+
+    bool m_bRecordsChanged = true;
+    std::shared_ptr<LightsBuffer> m_buffer = std::make_shared<LightsBuffer>();
+};
+
+}
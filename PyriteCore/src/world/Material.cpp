@@ -2,8 +2,13 @@
 
 #include <filesystem>
 #include "Mesh/RawMeshData.h"
+#include "display/TextureCooker.h"
+#include "engine/Directxlib.h"
 
+#include <algorithm>
+#include <execution>
 #include <memory>
+#include <vector>
 
 using namespace pyr;
 
@@ -43,24 +48,122 @@ pyr::Material::Material(const MaterialTexturePathsCollection& pathsCollection, c
 
 // -- Version with an effect* already loaded somewhere
 
+// Masks are cooked to single channel textures, the shader samples them from their red channel.
+// Sources that are not cooked (dds files, failed cooks) are loaded as they are, with the mask still in maskChannel.
+static TextureCooker::CookOptions GetCookOptions(TextureType type, const std::filesystem::path& path)
+{
+    if (path.extension() == ".hdr")
+        return { .usage = TextureCooker::Usage::HDR };
+
+    switch (type)
+    {
+    case TextureType::ALBEDO:    return { .usage = TextureCooker::Usage::Color };
+    case TextureType::NORMAL:    return { .usage = TextureCooker::Usage::Normal };
+    case TextureType::ROUGHNESS: return { .usage = TextureCooker::Usage::Mask, .maskChannel = 1 };
+    case TextureType::METALNESS: return { .usage = TextureCooker::Usage::Mask, .maskChannel = 2 };
+    default:                     return { .usage = TextureCooker::Usage::Mask, .maskChannel = 0 };
+    }
+}
+
+void pyr::Material::CookTextures(const MaterialTexturePathsCollection& pathsCollection)
+{
+    std::vector<std::pair<TextureType, std::filesystem::path>> sources;
+    for (const auto& [type, path] : pathsCollection)
+        if (!path.empty())
+            sources.emplace_back(type, string2widestring(path));
+
+    std::for_each(std::execution::par, sources.begin(), sources.end(), [](const auto& source)
+    {
+        TextureCooker::GetCookedTexture(source.second, GetCookOptions(source.first, source.second));
+    });
+}
+
 pyr::Material::Material(
     const MaterialTexturePathsCollection& pathsCollection, 
     const MaterialRenderingCoefficients& matCoefs, 
     const Effect* renderShader, 
     std::string name)
 {
-    // For each texture type, try to fetch the path and produce a texture (and register it to the grr)
+    // Source images that need cooking are decoded in parallel, a single png can't be split across threads but a material has several
+    std::vector<std::pair<TextureType, std::filesystem::path>> sources;
     for (TextureType type = TextureType::ALBEDO; type < TextureType::__COUNT; (*(int*)&type)++)
         if (pathsCollection.contains(type) && !pathsCollection.at(type).empty())
-            m_textures[type] = m_grr.loadTexture(string2widestring(pathsCollection.at(type)));
+            sources.emplace_back(type, string2widestring(pathsCollection.at(type)));
         else
             m_textures[type] = Texture::getDefaultTextureSet().WhitePixel;
 
+    std::vector<std::filesystem::path> cookedPaths(sources.size());
+    std::transform(std::execution::par, sources.begin(), sources.end(), cookedPaths.begin(), [](const auto& source)
+    {
+        return TextureCooker::GetCookedTexture(source.second, GetCookOptions(source.first, source.second));
+    });
+
+    // Uploads stay on this thread, the texture cache is not thread safe
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        const auto& [type, sourcePath] = sources[i];
+        m_cachedTextures[type] = TextureCache::get().acquire(cookedPaths[i]);
+
+        const uint32_t channel = cookedPaths[i] == sourcePath ? GetCookOptions(type, sourcePath).maskChannel : 0;
+        if (type == TextureType::METALNESS) m_metalnessChannel = channel;
+        if (type == TextureType::ROUGHNESS) m_roughnessChannel = channel;
+    }
+
     m_shader = renderShader;
     coefs = matCoefs;
     d_publicName = name;
 }
 
+// Effect variables fed by each texture type. BUMP and NORMAL share mat_normal, see buildBindingTable.
+static constexpr std::pair<TextureType, const char*> TEXTURE_VARIABLES[] = {
+    { TextureType::ALBEDO,    "mat_albedo" },
+    { TextureType::NORMAL,    "mat_normal" },
+    { TextureType::AO,        "mat_ao" },
+    { TextureType::ROUGHNESS, "mat_roughness" },
+    { TextureType::METALNESS, "mat_metalness" },
+    { TextureType::HEIGHT,    "mat_height" },
+};
+
+void pyr::Material::buildBindingTable() const
+{
+    m_bindingTable.clear();
+    m_bindingTableEffect = m_shader;
+    m_bindingTableGeneration = m_shader->getGeneration();
+
+    for (auto [type, variableName] : TEXTURE_VARIABLES)
+    {
+        ID3DX11EffectShaderResourceVariable* variable = m_shader->getShaderResourceVariable(variableName);
+        if (!variable) continue;
+
+        // Materials without a normal map may have a bump map instead, used as one. Every type has at least a white pixel,
+        // only textures loaded from a file count here, or the default bump texture would hide the normal map.
+        if (type == TextureType::NORMAL && !m_cachedTextures.contains(TextureType::NORMAL) && m_cachedTextures.contains(TextureType::BUMP))
+            type = TextureType::BUMP;
+
+        TextureBinding binding{ .variable = variable };
+        if (auto cached = m_cachedTextures.find(type); cached != m_cachedTextures.end())
+            binding.cached = cached->second;
+        else if (auto texture = m_textures.find(type); texture != m_textures.end())
+            binding.texture = texture->second;
+        else
+            continue;
+        m_bindingTable.push_back(std::move(binding));
+    }
+}
+
+void pyr::Material::bindTextures() const
+{
+    if (!m_shader) return;
+    if (m_bindingTableEffect != m_shader || m_bindingTableGeneration != m_shader->getGeneration())
+        buildBindingTable();
+
+    for (const TextureBinding& binding : m_bindingTable)
+    {
+        const Texture& texture = binding.cached ? TextureCache::get().use(binding.cached) : binding.texture;
+        DXTry(binding.variable->SetResource(texture.getRawTexture()), "Could not bind a material texture");
+    }
+}
+
 const pyr::Effect* pyr::MaterialBank::RegisterOrGetCachedShader(const std::filesystem::path& renderShaderPath)
 {
     auto& bank = Get();
@@ -74,3 +177,61 @@ const pyr::Effect* pyr::MaterialBank::RegisterOrGetCachedShader(const std::files
     bank.cachedRenderShaders[renderShaderPath.string()] = loadedShader;
     return loadedShader;
 }
+
+pyr::MaterialBank::mat_id_t pyr::MaterialBank::RegisterMaterial(std::shared_ptr<Material> material, std::string name)
+{
+    auto& bank = Get();
+
+    uint32_t slotIndex;
+    if (!bank.m_freeSlots.empty())
+    {
+        slotIndex = bank.m_freeSlots.back();
+        bank.m_freeSlots.pop_back();
+    }
+    else
+    {
+        PYR_ASSERT(bank.m_slots.size() <= MaterialHandle::INDEX_MASK, "Too many materials for the handle index bits");
+        slotIndex = static_cast<uint32_t>(bank.m_slots.size());
+        bank.m_slots.push_back(Slot{ .generation = 1 });
+    }
+
+    Slot& slot = bank.m_slots[slotIndex];
+    slot.denseIndex = static_cast<uint32_t>(bank.m_materials.size());
+    const mat_id_t handle = MaterialHandle::Make(slotIndex, slot.generation);
+
+    material->m_bankHandle = handle;
+    bank.m_materials.push_back(std::move(material));
+    bank.m_slotIndices.push_back(slotIndex);
+    bank.m_idsByName[name] = handle;
+    bank.m_names.push_back(std::move(name));
+    return handle;
+}
+
+void pyr::MaterialBank::UnregisterMaterial(mat_id_t materialGlobalId)
+{
+    if (!IsValid(materialGlobalId)) return;
+    auto& bank = Get();
+
+    Slot& slot = bank.m_slots[materialGlobalId.getIndex()];
+    const uint32_t denseIndex = slot.denseIndex;
+    if (auto it = bank.m_idsByName.find(bank.m_names[denseIndex]); it != bank.m_idsByName.end() && it->second == materialGlobalId)
+        bank.m_idsByName.erase(it);
+    bank.m_materials[denseIndex]->m_bankHandle = {};
+
+    // The last material fills the hole, its slot follows it
+    const uint32_t lastIndex = static_cast<uint32_t>(bank.m_materials.size() - 1);
+    if (denseIndex != lastIndex)
+    {
+        bank.m_materials[denseIndex] = std::move(bank.m_materials[lastIndex]);
+        bank.m_names[denseIndex] = std::move(bank.m_names[lastIndex]);
+        bank.m_slotIndices[denseIndex] = bank.m_slotIndices[lastIndex];
+        bank.m_slots[bank.m_slotIndices[denseIndex]].denseIndex = denseIndex;
+    }
+    bank.m_materials.pop_back();
+    bank.m_names.pop_back();
+    bank.m_slotIndices.pop_back();
+
+    // Generation 0 is skipped when wrapping around, so that the default handle stays invalid
+    slot.generation = slot.generation == MaterialHandle::GENERATION_MASK ? 1 : slot.generation + 1;
+    bank.m_freeSlots.push_back(materialGlobalId.getIndex());
+}
@@ -3,8 +3,13 @@
 #include "display/GraphicalResource.h"
 #include "world/Mesh/RawMeshData.h"
 
+#include <cstdint>
 #include <filesystem>
 #include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 // todo rename coefs, remove material and give shader to submeshes
 
@@ -26,21 +31,63 @@ namespace pyr
         float Metallic = 0.2F; // specular exponent
         float Ni = 0.04f; // optical density 
         float d = 0.f; // transparency
+        // Channel the maps are sampled from, set by the material from how its textures were loaded (see Material::coefsToData)
+        uint32_t MetalnessChannel = 0;
+        uint32_t RoughnessChannel = 0;
+        float padding[2];
     };
 
 
     using MaterialTexturePathsCollection = std::unordered_map<TextureType, std::string>;
 
+    // Identifies a material of the MaterialBank in 32 bits, small enough to be packed in draw sort keys.
+    // The low bits are the slot of the material in the bank, the high bits the generation of the slot: a handle kept past
+    // MaterialBank::UnregisterMaterial is detected as stale even once its slot is reused.
+    struct MaterialHandle
+    {
+        static constexpr uint32_t INDEX_BITS = 20;
+        static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+        static constexpr uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+        uint32_t value = 0; // generations start at 1, a default constructed handle is never valid
+
+        static constexpr MaterialHandle Make(uint32_t index, uint32_t generation) { return MaterialHandle{ (generation << INDEX_BITS) | index }; }
+        constexpr uint32_t getIndex() const noexcept { return value & INDEX_MASK; }
+        constexpr uint32_t getGeneration() const noexcept { return value >> INDEX_BITS; }
+        constexpr bool operator==(const MaterialHandle&) const = default;
+    };
+
 
     
 class Material
 {
 private:
+
+    friend class MaterialBank;
     
     const Effect* m_shader = nullptr;
     GraphicalResourceRegistry m_grr;
     std::unordered_map<TextureType, Texture> m_textures;
+    // Textures loaded from files, kept out of the registry so that the TextureCache can evict or downgrade them
+    std::unordered_map<TextureType, TextureCache::Handle> m_cachedTextures;
     MaterialRenderingCoefficients coefs;
+    MaterialHandle m_bankHandle; // invalid until registered
+    uint32_t m_metalnessChannel = 0;
+    uint32_t m_roughnessChannel = 0;
+
+    // A texture of the material resolved against a variable of its effect
+    struct TextureBinding
+    {
+        ID3DX11EffectShaderResourceVariable* variable = nullptr;
+        TextureCache::Handle cached; // resolved when binding, the cache may swap the texture between two frames
+        Texture texture;
+    };
+    // Built on the first bind, once the effect is compiled, and again if the effect or the material changes
+    mutable std::vector<TextureBinding> m_bindingTable;
+    mutable const Effect* m_bindingTableEffect = nullptr;
+    mutable uint32_t m_bindingTableGeneration = 0;
+
+    void buildBindingTable() const;
 
 public:
     
@@ -67,6 +114,10 @@ public:
         const Effect* renderShader = nullptr,
         std::string name = "UnnamedMaterial");
 
+    // Cooks the source images of a material ahead of its construction, can be called from any thread.
+    // Constructing the material afterwards only loads the cooked files.
+    static void CookTextures(const MaterialTexturePathsCollection& pathsCollection);
+
     // -- Standard constructor.
     Material(
         const MaterialTexturePathsCollection& pathsCollection,
@@ -88,15 +139,21 @@ public:
         m_shader->uploadAllBindings();
     }
 
-    Texture* getTexture(TextureType type)  {
-        return m_textures.contains(type) ? &m_textures.at(type) : nullptr;
-    }
+    // Sets every texture of the material on its effect, to do before binding the effect.
+    // Goes through the binding table, there is no name lookup past the first call.
+    void bindTextures() const;
+
+    // Marks the texture as used this frame, the pointer must not be kept past the frame
     const Texture* getTexture(TextureType type) const {
+        if (auto cached = m_cachedTextures.find(type); cached != m_cachedTextures.end())
+            return &TextureCache::get().use(cached->second);
         return m_textures.contains(type) ? &m_textures.at(type) : nullptr;
     }
+    const std::unordered_map<TextureType, TextureCache::Handle>& getCachedTextures() const { return m_cachedTextures; }
 
     const Effect* getEffect() const { return m_shader; }
-    void setEffect(Effect* shader) { m_shader = shader; }
+    MaterialHandle getBankHandle() const { return m_bankHandle; }
+    void setEffect(Effect* shader) { m_shader = shader; m_bindingTableEffect = nullptr; }
 
     // Cbuffer helper, temp
     MaterialCoefficientsBuffer::data_t coefsToData() const 
@@ -110,6 +167,8 @@ public:
                 .Metallic = coefs.Metallic, // specular exponent
                 .Ni = coefs.Ni , // optical density 
                 .d = coefs.d , // transparency
+                .MetalnessChannel = m_metalnessChannel,
+                .RoughnessChannel = m_roughnessChannel,
         };
     }
 
@@ -129,55 +188,61 @@ public:
 
 
 
-// This will hold every single material present at runtime and load shaders
+// Holds every registered material and loads their shaders, main thread only.
+// Materials are addressed by handles to a slot, the slot points into dense arrays that removals keep packed by moving the last
+// material into the hole. Handles therefore stay valid when other materials are unregistered, and stale ones are detected in O(1).
 class MaterialBank
 {
 public:
 
-    using mat_id_t = size_t;
+    using mat_id_t = MaterialHandle;
 
-    // We only want a single material that is called unnamedmaterial ? maybe we could generate more names
+    // Several materials may have the same name, name lookups return the last one registered.
     // This is called automatically when creating a material ! You should not call this on your own.
-    static mat_id_t RegisterMaterial(std::shared_ptr<Material> material, std::string name = "UnnamedMaterial")
+    static mat_id_t RegisterMaterial(std::shared_ptr<Material> material, std::string name = "UnnamedMaterial");
+    // Invalidates the handle, the material lives on as long as something else references it
+    static void UnregisterMaterial(mat_id_t materialGlobalId);
+
+    static bool IsValid(mat_id_t materialGlobalId)
     {
         auto& bank = Get();
-        size_t nextId = bank.elements.size();
-        bank.elements[nextId] = material;
-        bank.elementsNames[nextId] = name;
-        bank.elementsIds[name] = nextId; // will override each time...
-        return nextId;
+        const uint32_t index = materialGlobalId.getIndex();
+        return index < bank.m_slots.size() && bank.m_slots[index].generation == materialGlobalId.getGeneration();
+    }
+
+    // Does not touch the reference count, to use in loops over many materials. Null if the handle is stale.
+    static Material* GetMaterial(mat_id_t materialGlobalId)
+    {
+        if (!IsValid(materialGlobalId)) return nullptr;
+        auto& bank = Get();
+        return bank.m_materials[bank.m_slots[materialGlobalId.getIndex()].denseIndex].get();
     }
 
     static std::shared_ptr<Material> GetMaterialReference(mat_id_t materialGlobalId)
     {
+        if (!IsValid(materialGlobalId)) return nullptr;
         auto& bank = Get();
-        if (!bank.elements.contains(materialGlobalId)) return nullptr;
-        return bank.elements[materialGlobalId];
+        return bank.m_materials[bank.m_slots[materialGlobalId.getIndex()].denseIndex];
     }
 
     static std::shared_ptr<Material> GetMaterialReference(const std::string& materialName)
     {
-        mat_id_t globalMaterialId = GetMaterialGlobalId(materialName);
-        if (globalMaterialId == -1) return nullptr; // todo handle error
-
-        auto& bank = Get();
-        return bank.elements[globalMaterialId];
+        return GetMaterialReference(GetMaterialGlobalId(materialName));
     }
 
-    static std::string GetMaterialName(mat_id_t globalMaterialId)
+    static std::string GetMaterialName(mat_id_t materialGlobalId)
     {
+        if (!IsValid(materialGlobalId)) return "MATERIAL_NOT_FOUND";
         auto& bank = Get();
-        if (!bank.elementsNames.contains(globalMaterialId)) return "MATERIAL_NOT_FOUND";
-        std::string matName = bank.elementsNames[globalMaterialId];
-        return matName;
+        return bank.m_names[bank.m_slots[materialGlobalId.getIndex()].denseIndex];
     }
 
+    // Returns an invalid handle if there is no material with that name
     static mat_id_t GetMaterialGlobalId(const std::string& materialName)
     {
         auto& bank = Get();
-        if (!bank.elementsIds.contains(materialName)) return -1;
-        mat_id_t globalMaterialId = bank.elementsIds[materialName];
-        return globalMaterialId;
+        auto it = bank.m_idsByName.find(materialName);
+        return it != bank.m_idsByName.end() ? it->second : mat_id_t{};
     }
 
     static const Effect* RegisterOrGetCachedShader(const std::filesystem::path& renderShaderPath);
@@ -189,10 +254,10 @@ public:
         return defaultGGXShader;
     }
 
-    static const std::unordered_map<mat_id_t, std::shared_ptr<Material>>& GetAllMaterials()
+    // Packed, in no particular order. The handle of each material is given by Material::getBankHandle.
+    static std::span<const std::shared_ptr<Material>> GetAllMaterials()
     {
-        auto& bank = Get();
-        return bank.elements;
+        return Get().m_materials;
     }
 
 private:
@@ -210,17 +275,21 @@ private:
 
 private:
 
+    struct Slot
+    {
+        uint32_t denseIndex = 0;
+        uint32_t generation = 0; // of the material in the slot, bumped when it is unregistered
+    };
+
     GraphicalResourceRegistry m_grr;
 
-    std::unordered_map<mat_id_t, std::shared_ptr<Material>> elements;
-    std::unordered_map<mat_id_t, std::string> elementsNames;
-    std::unordered_map<std::string, mat_id_t> elementsIds; // bad
+    std::vector<Slot> m_slots;          // indexed by handle
+    std::vector<uint32_t> m_freeSlots;
+    std::vector<std::shared_ptr<Material>> m_materials; // dense
+    std::vector<std::string> m_names;   // dense
+    std::vector<uint32_t> m_slotIndices; // dense, slot of each material, to fix the slot of the material moved by a removal
+    std::unordered_map<std::string, mat_id_t> m_idsByName; // side index, lookups by handle never go through it
     std::unordered_map<std::string, const Effect*> cachedRenderShaders;
 };
 
-
-
-
-
-
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "MeshComponents.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+
+#include "engine/AsyncTasks.h"
+#include "world/camera.h"
+#include "world/Mesh/StaticMesh.h"
+
+namespace pyr
+{
+
+	static size_t RoundUpTo4(size_t count) { return (count + 3) & ~size_t{ 3 }; }
+
+	void MeshComponents::sync(std::span<const StaticMesh* const> meshes)
+	{
+		// Read before matching the meshes, which may move them to other indices
+		std::vector<SceneChangeJournal::actor_id_t> movedActors;
+		const bool bComplete = SceneChangeJournal::get().consume(m_journalCursor, [&](const SceneChangeJournal::Change& change)
+		{
+			if (change.flags & SceneChangeJournal::TRANSFORM)
+				movedActors.push_back(change.actor);
+		});
+		if (!bComplete)
+			m_meshes.clear(); // nothing can be kept
+
+		if (!std::ranges::equal(meshes, m_meshes))
+		{
+			MeshComponents previous;
+			std::swap(previous, *this);
+			m_journalCursor = previous.m_journalCursor;
+
+			std::unordered_map<const StaticMesh*, uint32_t> previousIndices;
+			for (uint32_t i = 0; i < previous.m_meshes.size(); i++)
+				previousIndices.emplace(previous.m_meshes[i], i);
+
+			resize(meshes.size());
+			m_meshes.assign(meshes.begin(), meshes.end());
+			for (uint32_t i = 0; i < m_meshes.size(); i++)
+			{
+				m_indicesByActor.emplace(m_meshes[i]->GetActorID(), i);
+
+				auto it = previousIndices.find(m_meshes[i]);
+				if (it == previousIndices.end() || previous.m_revisions[it->second] != m_meshes[i]->getRevision())
+				{
+					refresh(i);
+					continue;
+				}
+				const uint32_t p = it->second;
+				m_minX[i] = previous.m_minX[p]; m_minY[i] = previous.m_minY[p]; m_minZ[i] = previous.m_minZ[p];
+				m_maxX[i] = previous.m_maxX[p]; m_maxY[i] = previous.m_maxY[p]; m_maxZ[i] = previous.m_maxZ[p];
+				m_revisions[i] = previous.m_revisions[p];
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < m_meshes.size(); i++)
+				if (m_revisions[i] != m_meshes[i]->getRevision()) refresh(i);
+		}
+
+		for (SceneChangeJournal::actor_id_t actor : movedActors)
+		{
+			auto [first, last] = m_indicesByActor.equal_range(actor);
+			for (; first != last; ++first)
+				refresh(first->second);
+		}
+	}
+
+	AABB MeshComponents::getWorldBounds(size_t index) const
+	{
+		return AABB::make_aabb(vec3{ m_minX[index], m_minY[index], m_minZ[index] }, vec3{ m_maxX[index], m_maxY[index], m_maxZ[index] });
+	}
+
+	void MeshComponents::resize(size_t count)
+	{
+		// Padding entries are tested with the others, their results are ignored
+		for (std::vector<float>* bounds : { &m_minX, &m_minY, &m_minZ, &m_maxX, &m_maxY, &m_maxZ })
+			bounds->assign(RoundUpTo4(count), 0.F);
+		m_revisions.assign(count, 0);
+	}
+
+	void MeshComponents::refresh(size_t index)
+	{
+		const AABB bounds = m_meshes[index]->getWorldBounds();
+		const vec3 min = bounds.getOrigin();
+		const vec3 max = bounds.getOrigin() + bounds.getSize();
+		m_minX[index] = min.x; m_minY[index] = min.y; m_minZ[index] = min.z;
+		m_maxX[index] = max.x; m_maxY[index] = max.y; m_maxZ[index] = max.z;
+		m_revisions[index] = m_meshes[index]->getRevision();
+	}
+
+	template<class F>
+	void MeshComponents::cull(const F& testGroup, std::vector<const StaticMesh*>& outMeshes) const
+	{
+		// Smaller collections are not worth waking the workers for
+		constexpr size_t PARALLEL_GROUP_COUNT = 4096;
+		constexpr size_t GRAIN_SIZE = 1024;
+
+		const size_t groupCount = RoundUpTo4(m_meshes.size()) / 4;
+		std::vector<uint8_t> masks(groupCount);
+		auto testGroups = [&](size_t first, size_t last)
+		{
+			for (size_t group = first; group < last; group++)
+				masks[group] = static_cast<uint8_t>(testGroup(group * 4));
+		};
+		if (groupCount < PARALLEL_GROUP_COUNT)
+			testGroups(0, groupCount);
+		else
+			WorkerPool::get().parallelFor(groupCount, GRAIN_SIZE, testGroups);
+
+		for (size_t i = 0; i < m_meshes.size(); i++)
+			if (masks[i / 4] & (1 << (i % 4))) outMeshes.push_back(m_meshes[i]);
+	}
+
+	void MeshComponents::cullFrustum(const Frustum& frustum, std::vector<const StaticMesh*>& outMeshes) const
+	{
+		const Plane* planes[] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace, &frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+		cull([&](size_t first)
+		{
+			// Same test as Frustum::isOnFrustum, through the corner of each box that is the furthest along the plane's normal
+			__m128 bOnFrustum = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const Plane* plane : planes)
+			{
+				const float* xs = plane->normal.x >= 0 ? m_maxX.data() : m_minX.data();
+				const float* ys = plane->normal.y >= 0 ? m_maxY.data() : m_minY.data();
+				const float* zs = plane->normal.z >= 0 ? m_maxZ.data() : m_minZ.data();
+				__m128 distance = _mm_mul_ps(_mm_set1_ps(plane->normal.x), _mm_loadu_ps(xs + first));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane->normal.y), _mm_loadu_ps(ys + first)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane->normal.z), _mm_loadu_ps(zs + first)));
+				bOnFrustum = _mm_and_ps(bOnFrustum, _mm_cmpge_ps(distance, _mm_set1_ps(plane->distanceToOrigin)));
+			}
+			return _mm_movemask_ps(bOnFrustum);
+		}, outMeshes);
+	}
+
+	void MeshComponents::cullSphere(const vec3& center, float radius, std::vector<const StaticMesh*>& outMeshes) const
+	{
+		const __m128 centerX = _mm_set1_ps(center.x);
+		const __m128 centerY = _mm_set1_ps(center.y);
+		const __m128 centerZ = _mm_set1_ps(center.z);
+		const __m128 radiusSquared = _mm_set1_ps(radius * radius);
+		cull([&](size_t first)
+		{
+			// From the center to the closest point of each box
+			const __m128 dx = _mm_sub_ps(_mm_min_ps(_mm_max_ps(centerX, _mm_loadu_ps(&m_minX[first])), _mm_loadu_ps(&m_maxX[first])), centerX);
+			const __m128 dy = _mm_sub_ps(_mm_min_ps(_mm_max_ps(centerY, _mm_loadu_ps(&m_minY[first])), _mm_loadu_ps(&m_maxY[first])), centerY);
+			const __m128 dz = _mm_sub_ps(_mm_min_ps(_mm_max_ps(centerZ, _mm_loadu_ps(&m_minZ[first])), _mm_loadu_ps(&m_maxZ[first])), centerZ);
+			const __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			return _mm_movemask_ps(_mm_cmple_ps(distanceSquared, radiusSquared));
+		}, outMeshes);
+	}
+
+}
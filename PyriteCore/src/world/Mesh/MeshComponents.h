@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "scene/SceneChangeJournal.h"
+#include "world/aabb.h"
+
+namespace pyr
+{
+
+class StaticMesh;
+struct Frustum;
+
+// The data culling reads for each mesh of a RegisteredRenderableActorCollection, stored in parallel arrays so that
+// tests run on 4 meshes at a time and large collections can be split across the workers.
+// Entries follow the order of the collection's meshes, only the ones added, moved (see SceneChangeJournal) or whose
+// model changed (see StaticMesh::getRevision) are read again by sync.
+class MeshComponents
+{
+public:
+
+    // Copies start empty and assigning one keeps the entries of the destination, a collection copied every frame
+    // (see RenderContext) keeps synchronizing incrementally
+    MeshComponents() = default;
+    MeshComponents(const MeshComponents&) {}
+    MeshComponents& operator=(const MeshComponents&) { return *this; }
+    MeshComponents(MeshComponents&&) = default;
+    MeshComponents& operator=(MeshComponents&&) = default;
+
+    void sync(std::span<const StaticMesh* const> meshes);
+
+    size_t size() const { return m_meshes.size(); }
+    std::span<const StaticMesh* const> getMeshes() const { return m_meshes; }
+    AABB getWorldBounds(size_t index) const;
+
+    // Append the meshes whose world bounds are on the frustum or intersect the sphere, in the collection's order
+    void cullFrustum(const Frustum& frustum, std::vector<const StaticMesh*>& outMeshes) const;
+    void cullSphere(const vec3& center, float radius, std::vector<const StaticMesh*>& outMeshes) const;
+
+private:
+
+    void resize(size_t count);
+    void refresh(size_t index);
+
+    // testGroup(first) returns the 4 bits visibility mask of entries [first, first+4)
+    template<class F>
+    void cull(const F& testGroup, std::vector<const StaticMesh*>& outMeshes) const;
+
+private:
+
+    // World bounds, padded to a multiple of 4 entries
+    std::vector<float> m_minX, m_minY, m_minZ;
+    std::vector<float> m_maxX, m_maxY, m_maxZ;
+
+    std::vector<const StaticMesh*> m_meshes;
+    std::vector<uint64_t> m_revisions;
+    std::unordered_multimap<SceneChangeJournal::actor_id_t, uint32_t> m_indicesByActor; // copies of an actor share its id
+    uint64_t m_journalCursor = 0;
+};
+
+}
@@ -11,6 +11,8 @@
 #include "Model.h"
 #include <set>
 #include <array>
+#include <optional>
+#include <stdexcept>
 
 namespace fs = std::filesystem;
 using namespace DirectX::SimpleMath;
@@ -21,7 +23,28 @@ namespace pyr
 	class MeshImporter
 	{
 	public:
+
+		// Material description read from the file, turned into a registered Material by CreateModels
+		struct ImportedMaterial
+		{
+			std::string name;
+			MaterialTexturePathsCollection paths;
+			MaterialRenderingCoefficients coefs;
+		};
+
+		// Everything that can be read without touching the device or the MaterialBank, safe to build on a worker thread
+		struct ImportedMeshes
+		{
+			std::vector<std::shared_ptr<pyr::RawMeshData>> meshes;
+			std::vector<std::optional<ImportedMaterial>> materials; // indexed by the assimp material index, empty if unused
+		};
+
 		static std::vector<std::shared_ptr<pyr::Model>> ImportMeshesFromFile(const fs::path& filePath, bool bFlipUVs = false)
+		{
+			return CreateModels(ReadMeshesFromFile(filePath, bFlipUVs));
+		}
+
+		static ImportedMeshes ReadMeshesFromFile(const fs::path& filePath, bool bFlipUVs = false)
 		{
 			Assimp::Importer importer;
 
@@ -29,14 +52,29 @@ namespace pyr
 			if (!bExists) return {};
 
 			const aiScene* scene = importer.ReadFile(filePath.string().c_str(), aiProcess_Triangulate | aiProcess_PreTransformVertices | (bFlipUVs ? aiProcess_FlipUVs : 0) | aiProcess_FlipWindingOrder);
-			PYR_ASSERT(scene, "Could not load mesh ", filePath);
-			std::vector<std::shared_ptr<pyr::RawMeshData>> outMeshes;
+			// Also read on workers (see AssetLoader) where PYR_ASSERT would race on the logger, the loader reports the exception
+			if (!scene)
+				throw std::runtime_error("Could not load mesh " + filePath.string() + ": " + importer.GetErrorString());
+			ImportedMeshes imported;
+			imported.materials.resize(scene->mNumMaterials);
+			ProcessNode(scene->mRootNode, scene, imported);
+			return imported;
+		}
+
+		// Creates the GPU buffers and registers the materials, main thread only
+		static std::vector<std::shared_ptr<pyr::Model>> CreateModels(const ImportedMeshes& imported)
+		{
 			Model::SubmeshesMaterialTable defaultMaterials;
-			defaultMaterials.resize(scene->mNumMaterials);
-			ProcessNode(scene->mRootNode, scene, outMeshes, defaultMaterials);
+			defaultMaterials.resize(imported.materials.size());
+			for (size_t i = 0; i < imported.materials.size(); i++)
+			{
+				if (!imported.materials[i]) continue;
+				const ImportedMaterial& material = *imported.materials[i];
+				defaultMaterials[i] = Material::MakeRegisteredMaterial(material.paths, material.coefs, pyr::MaterialBank::GetDefaultGGXShader(), material.name);
+			}
 
 			std::vector<std::shared_ptr<pyr::Model>> outModels;
-			for (auto& meshData : outMeshes)
+			for (auto& meshData : imported.meshes)
 			{
 				auto Model = std::make_shared<pyr::Model>(meshData, defaultMaterials);
 				if (!Model) continue;
@@ -45,30 +83,22 @@ namespace pyr
 			return outModels;
 		}
 private:
-			static void ProcessNode(
-						aiNode* node, const aiScene* scene, 
-						std::vector<std::shared_ptr<pyr::RawMeshData>>& outMeshes, 
-						Model::SubmeshesMaterialTable& outDefaultMaterials
-						)
+			static void ProcessNode(aiNode* node, const aiScene* scene, ImportedMeshes& outImported)
 			{
 				// process all the node's meshes (if any)
 				for (unsigned int i = 0; i < node->mNumMeshes; i++)
 				{
 					aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-					outMeshes.push_back(ProcessMeshFromAssimp(mesh, scene));
+					outImported.meshes.push_back(ProcessMeshFromAssimp(mesh, scene));
 
-					if (outDefaultMaterials[mesh->mMaterialIndex] == nullptr)
-					{
-						MaterialBank::mat_id_t matGlobalId = CreateMaterialFromMesh(mesh, scene);
-						const std::shared_ptr<Material>& computedDefaultMaterial = MaterialBank::GetMaterialReference(matGlobalId);
-						outDefaultMaterials[mesh->mMaterialIndex] = computedDefaultMaterial;
-					}
+					if (!outImported.materials[mesh->mMaterialIndex])
+						outImported.materials[mesh->mMaterialIndex] = ReadMaterialFromMesh(mesh, scene);
 
 				}
 				// then do the same for each of its children
 				for (unsigned int i = 0; i < node->mNumChildren; i++)
 				{
-					ProcessNode(node->mChildren[i], scene, outMeshes, outDefaultMaterials);
+					ProcessNode(node->mChildren[i], scene, outImported);
 				}
 			}
 			
@@ -118,7 +148,7 @@ private:
 				return std::make_shared<RawMeshData>(vertices, indices, submeshes);
 			}
 
-			static pyr::MaterialBank::mat_id_t CreateMaterialFromMesh(aiMesh* aimesh, const aiScene* scene)
+			static ImportedMaterial ReadMaterialFromMesh(aiMesh* aimesh, const aiScene* scene)
 			{
 			
 				aiMaterial* currMeshMaterial = scene->mMaterials[aimesh->mMaterialIndex];
@@ -164,8 +194,7 @@ private:
 					}
 				}
 				delete outputPath;
-				std::shared_ptr<Material> toRegister = Material::MakeRegisteredMaterial( paths, coefs, pyr::MaterialBank::GetDefaultGGXShader(), materialName);
-				return pyr::MaterialBank::GetMaterialGlobalId(materialName);
+				return ImportedMaterial{ .name = materialName, .paths = paths, .coefs = coefs };
 			}
 
 	};
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <cmath>
 #include <span>
 #include <vector>
 #include <string>
 
 #include "display/IndexBuffer.h"
 #include "display/Vertex.h"
+#include "world/AABB.h"
 
 namespace pyr
 {
@@ -41,6 +43,47 @@ private:
     std::vector<mesh_vertex_t> m_vertices;
     std::vector<mesh_indice_t> m_indices;
 
+    AABB m_localBounds;
+    std::vector<float> m_submeshesUVDensity;
+
+    void computeLocalBounds()
+    {
+        if (m_vertices.empty()) return;
+
+        vec3 min = vec3{ m_vertices[0].position.x, m_vertices[0].position.y, m_vertices[0].position.z };
+        vec3 max = min;
+        for (const mesh_vertex_t& vertex : m_vertices)
+        {
+            const vec3 position{ vertex.position.x, vertex.position.y, vertex.position.z };
+            min = vec3::Min(min, position);
+            max = vec3::Max(max, position);
+        }
+        m_localBounds = AABB::make_aabb(min, max);
+    }
+
+    // Texture space covered per unit of local space, sqrt(uv area / surface area), used to pick the mips to stream in
+    void computeUVDensities()
+    {
+        m_submeshesUVDensity.clear();
+        for (const SubMesh& submesh : m_submeshes)
+        {
+            double uvArea = 0, surfaceArea = 0;
+            for (size_t i = submesh.startIndex; i + 2 < submesh.endIndex && i + 2 < m_indices.size(); i += 3)
+            {
+                const mesh_vertex_t& a = m_vertices[m_indices[i]];
+                const mesh_vertex_t& b = m_vertices[m_indices[i + 1]];
+                const mesh_vertex_t& c = m_vertices[m_indices[i + 2]];
+                const vec3 ab = vec3{ b.position.x - a.position.x, b.position.y - a.position.y, b.position.z - a.position.z };
+                const vec3 ac = vec3{ c.position.x - a.position.x, c.position.y - a.position.y, c.position.z - a.position.z };
+                const vec2 uvAB = b.texCoords - a.texCoords;
+                const vec2 uvAC = c.texCoords - a.texCoords;
+                surfaceArea += ab.Cross(ac).Length() * .5;
+                uvArea += std::abs(uvAB.x * uvAC.y - uvAB.y * uvAC.x) * .5;
+            }
+            m_submeshesUVDensity.push_back(surfaceArea > 0 ? static_cast<float>(std::sqrt(uvArea / surfaceArea)) : 0.F);
+        }
+    }
+
 public:
 
     RawMeshData() = default;
@@ -48,7 +91,10 @@ public:
         const std::vector<mesh_indice_t>& indices)
         : m_vertices(vertices)
         , m_indices(indices)
-    {}
+    {
+        computeLocalBounds();
+        computeUVDensities();
+    }
     RawMeshData(const std::vector<mesh_vertex_t>& vertices,
         const std::vector<mesh_indice_t>& indices,
         const std::vector<SubMesh>& submeshes
@@ -56,11 +102,16 @@ public:
         : m_vertices(vertices)
         , m_indices(indices)
         , m_submeshes(submeshes)
-    {}
+    {
+        computeLocalBounds();
+        computeUVDensities();
+    }
 
     const std::vector<SubMesh>& getSubmeshes()      const noexcept { return  m_submeshes; };
     const std::vector<mesh_vertex_t>& getVertices() const noexcept { return m_vertices; }
     const std::vector<mesh_indice_t>& getIndices()  const noexcept { return m_indices; }
+    const AABB& getLocalBounds()                    const noexcept { return m_localBounds; }
+    float getSubmeshUVDensity(size_t submesh)       const noexcept { return submesh < m_submeshesUVDensity.size() ? m_submeshesUVDensity[submesh] : 0.F; }
 
 
 };
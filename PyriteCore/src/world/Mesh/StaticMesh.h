@@ -1,6 +1,8 @@
 ﻿#pragma once
 
+#include <atomic>
 #include <filesystem>
+#include <limits>
 
 #include "Model.h"
 
@@ -20,6 +22,9 @@ namespace pyr
 
         Model::SubmeshesMaterialTable m_submeshesMaterials;
 
+        static inline std::atomic<uint64_t> NextRevision = 1;
+        uint64_t m_revision = NextRevision.fetch_add(1, std::memory_order_relaxed);
+
     public:
 
 
@@ -38,21 +43,46 @@ namespace pyr
             }
 
             m_submeshesMaterials[materialLocalIndex] = materialOverride;
+            m_revision = NextRevision.fetch_add(1, std::memory_order_relaxed);
+            SceneChangeJournal::get().record(GetActorID(), SceneChangeJournal::MATERIAL);
         }
 
-        std::shared_ptr<const Material> getMaterial(size_t submeshLocalIndex) const
+        // Changes when the model or a material of the mesh changes, never shared by two meshes that differ, for the caches
+        // of things built from them (see DrawCommandCache). The transform is not covered.
+        uint64_t getRevision() const { return m_revision; }
+
+        // Owned by the mesh for as long as it is not overridden, does not touch the reference count
+        const Material* getMaterial(size_t submeshLocalIndex) const
         {
             if (submeshLocalIndex >= m_submeshesMaterials.size())
             {
                 return nullptr;
             }
-            return m_submeshesMaterials[submeshLocalIndex];
+            return m_submeshesMaterials[submeshLocalIndex].get();
         }
 
         std::shared_ptr<const Model> getModel() const { return m_model; }
         std::shared_ptr<Model> getModel() { return m_model; }
 
         void bindModel()    const { m_model->bind(); }
+
+        // Bounds of the transformed local bounds, not the tightest fit once rotated but good enough for culling
+        AABB getWorldBounds() const
+        {
+            const AABB& local = m_model->getRawMeshData()->getLocalBounds();
+            const mat4 world = GetWorldMatrix();
+
+            vec3 min{ std::numeric_limits<float>::max() };
+            vec3 max{ std::numeric_limits<float>::lowest() };
+            for (int corner = 0; corner < 8; corner++)
+            {
+                const vec3 offset{ corner & 1 ? local.getSize().x : 0.F, corner & 2 ? local.getSize().y : 0.F, corner & 4 ? local.getSize().z : 0.F };
+                const vec3 worldCorner = vec3::Transform(local.getOrigin() + offset, world);
+                min = vec3::Min(min, worldCorner);
+                max = vec3::Max(max, worldCorner);
+            }
+            return AABB::make_aabb(min, max);
+        }
     };
 
 }
\ No newline at end of file
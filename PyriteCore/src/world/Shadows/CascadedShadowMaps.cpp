@@ -0,0 +1,134 @@
+#include "CascadedShadowMaps.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "world/Mesh/StaticMesh.h"
+
+namespace pyr
+{
+
+	float CascadedShadowMaps::ComputeSplitDistance(float zNear, float zFar, float lambda, uint32_t index, uint32_t count)
+	{
+		const float t = static_cast<float>(index) / static_cast<float>(count);
+		const float logSplit = zNear * std::pow(zFar / zNear, t);
+		const float uniformSplit = zNear + (zFar - zNear) * t;
+		return mathf::lerp(uniformSplit, logSplit, std::clamp(lambda, 0.F, 1.F));
+	}
+
+	std::vector<ShadowCascade> CascadedShadowMaps::ComputeCascades(const Camera& viewCamera, const DirectionalLight& light, std::span<const StaticMesh* const> casters, uint32_t shadowMapResolution)
+	{
+		const uint32_t cascadeCount = std::clamp<uint32_t>(static_cast<uint32_t>(std::max(light.cascadeCount, 1)), 1U, MAX_CASCADES_PER_LIGHT);
+
+		// -- Shape of the view frustum, the section of an orthographic camera does not depend on the distance
+		float zNear = .1F, zFar = light.shadowDistance;
+		float tanHalfWidth = 0.F, tanHalfHeight = 0.F, halfWidth = 0.F, halfHeight = 0.F;
+		if (const auto* perspective = std::get_if<PerspectiveProjection>(&viewCamera.getProjection()))
+		{
+			zNear = perspective->zNear;
+			zFar = std::min(zFar, perspective->zFar);
+			tanHalfHeight = std::tan(perspective->fovy * .5F);
+			tanHalfWidth = tanHalfHeight * perspective->aspect;
+		}
+		else if (const auto* ortho = std::get_if<OrthographicProjection>(&viewCamera.getProjection()))
+		{
+			zNear = ortho->zNear;
+			zFar = std::min(zFar, ortho->zFar);
+			halfWidth = ortho->width * .5F;
+			halfHeight = ortho->height * .5F;
+		}
+		zNear = std::max(zNear, .01F);
+		zFar = std::max(zFar, zNear + .01F);
+
+		const vec3 viewPosition = viewCamera.getPosition();
+		const vec3 viewForward = viewCamera.getForward();
+		const vec3 viewRight = viewCamera.getRight();
+		const vec3 viewUp = viewCamera.getUp();
+
+		// -- Light space, every cascade shares the orientation of the light so their view matrices only differ by a translation
+		vec3 lightDirection{ light.GetTransform().rotation.x, light.GetTransform().rotation.y, light.GetTransform().rotation.z };
+		if (lightDirection.LengthSquared() < 1e-6F) lightDirection = -vec3::UnitY;
+		lightDirection.Normalize();
+
+		Camera lightBasis{};
+		lightBasis.lookAt(lightDirection);
+		const mat4 lightView = lightBasis.getViewMatrix();
+		const mat4 lightViewInverse = lightView.Invert();
+
+		// Casters bounds are needed by every cascade, transform them once
+		struct LightSpaceBounds { vec3 min, max; };
+		std::vector<LightSpaceBounds> castersBounds;
+		castersBounds.reserve(casters.size());
+		for (const StaticMesh* caster : casters)
+		{
+			const AABB worldBounds = caster->getWorldBounds();
+			LightSpaceBounds bounds{ vec3{ std::numeric_limits<float>::max() }, vec3{ std::numeric_limits<float>::lowest() } };
+			for (int corner = 0; corner < 8; corner++)
+			{
+				const vec3 offset{ corner & 1 ? worldBounds.getSize().x : 0.F, corner & 2 ? worldBounds.getSize().y : 0.F, corner & 4 ? worldBounds.getSize().z : 0.F };
+				const vec3 lightSpaceCorner = vec3::Transform(worldBounds.getOrigin() + offset, lightView);
+				bounds.min = vec3::Min(bounds.min, lightSpaceCorner);
+				bounds.max = vec3::Max(bounds.max, lightSpaceCorner);
+			}
+			castersBounds.push_back(bounds);
+		}
+
+		std::vector<ShadowCascade> cascades(cascadeCount);
+		for (uint32_t cascadeIndex = 0; cascadeIndex < cascadeCount; cascadeIndex++)
+		{
+			const float sliceNear = ComputeSplitDistance(zNear, zFar, light.cascadeSplitLambda, cascadeIndex, cascadeCount);
+			const float sliceFar = ComputeSplitDistance(zNear, zFar, light.cascadeSplitLambda, cascadeIndex + 1, cascadeCount);
+
+			// -- Bounding sphere of the slice of the view frustum
+			std::array<vec3, 8> corners;
+			for (int corner = 0; corner < 8; corner++)
+			{
+				const float distance = corner & 4 ? sliceFar : sliceNear;
+				const float sx = corner & 1 ? 1.F : -1.F;
+				const float sy = corner & 2 ? 1.F : -1.F;
+				const float extentX = tanHalfWidth * distance + halfWidth;
+				const float extentY = tanHalfHeight * distance + halfHeight;
+				corners[corner] = viewPosition + viewForward * distance + viewRight * (sx * extentX) + viewUp * (sy * extentY);
+			}
+
+			vec3 center{};
+			for (const vec3& corner : corners) center += corner;
+			center /= static_cast<float>(corners.size());
+
+			float radius = 0.F;
+			for (const vec3& corner : corners) radius = std::max(radius, vec3::Distance(center, corner));
+			radius = std::ceil(radius * 16.F) / 16.F; // < avoid tiny size changes from float imprecisions
+
+			// -- Snap the center to the texel grid of the shadow map
+			const float worldUnitsPerTexel = 2.F * radius / static_cast<float>(shadowMapResolution);
+			vec3 lightSpaceCenter = vec3::Transform(center, lightView);
+			lightSpaceCenter.x = std::floor(lightSpaceCenter.x / worldUnitsPerTexel) * worldUnitsPerTexel;
+			lightSpaceCenter.y = std::floor(lightSpaceCenter.y / worldUnitsPerTexel) * worldUnitsPerTexel;
+
+			// -- Cull the casters, anything that overlaps the cascade seen from the light and is not behind it may throw a shadow in it
+			ShadowCascade& cascade = cascades[cascadeIndex];
+			float depthMin = lightSpaceCenter.z - radius;
+			const float depthMax = lightSpaceCenter.z + radius;
+			for (size_t casterIndex = 0; casterIndex < casters.size(); casterIndex++)
+			{
+				const LightSpaceBounds& bounds = castersBounds[casterIndex];
+				if (bounds.max.x < lightSpaceCenter.x - radius || bounds.min.x > lightSpaceCenter.x + radius) continue;
+				if (bounds.max.y < lightSpaceCenter.y - radius || bounds.min.y > lightSpaceCenter.y + radius) continue;
+				if (bounds.min.z > depthMax) continue;
+
+				cascade.casters.push_back(casters[casterIndex]);
+				depthMin = std::min(depthMin, bounds.min.z);
+			}
+
+			const vec3 cameraPosition = vec3::Transform(vec3{ lightSpaceCenter.x, lightSpaceCenter.y, depthMin }, lightViewInverse);
+			cascade.camera.setProjection(OrthographicProjection{ .width = 2.F * radius, .height = 2.F * radius, .zNear = 0.F, .zFar = depthMax - depthMin });
+			cascade.camera.setPosition(cameraPosition);
+			cascade.camera.lookAt(cameraPosition + lightDirection);
+		}
+
+		return cascades;
+	}
+
+}
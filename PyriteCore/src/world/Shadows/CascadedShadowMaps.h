@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "display/ConstantBuffer.h"
+#include "utils/math.h"
+#include "world/camera.h"
+#include "world/Lights/Light.h"
+
+namespace pyr
+{
+
+class StaticMesh;
+
+// Matches ShadowCascade in shadow_utils.incl
+struct hlsl_ShadowCascade
+{
+    mat4 viewProjection;
+    vec4 shadowMapRect; // < uv offset (xy) and scale (zw) in the slice
+    uint32_t slice = 0;
+    float padding[3];
+};
+
+struct ShadowCascade
+{
+    Camera camera;
+    std::vector<const StaticMesh*> casters; // only the meshes that can throw a shadow in this cascade
+};
+
+// Splits the view frustum of a camera in slices and fits one orthographic shadow camera per slice, for directional lights.
+class CascadedShadowMaps
+{
+public:
+
+    static constexpr uint32_t MAX_CASCADES_PER_LIGHT = 4;
+    static constexpr uint32_t MAX_CASCADES = 16; // must match MAX_SHADOW_CASCADES in shadow_utils.incl
+
+    // Cascades are ordered from the closest to the camera to the farthest.
+    // Each cascade is sized after the bounding sphere of its slice so that its size does not change when the camera rotates, and its
+    // position is snapped to texels of the shadow map, otherwise the shadow edges shimmer when the camera moves.
+    // Its depth range is extended towards the light to include every caster that may throw a shadow inside of it.
+    static std::vector<ShadowCascade> ComputeCascades(const Camera& viewCamera, const DirectionalLight& light, std::span<const StaticMesh* const> casters, uint32_t shadowMapResolution);
+
+    // Blend of logarithmic (lambda=1) and uniform (lambda=0) splits, index 0 is zNear and index count is zFar
+    static float ComputeSplitDistance(float zNear, float zFar, float lambda, uint32_t index, uint32_t count);
+};
+
+using ShadowCascadesBuffer = pyr::ConstantBuffer < InlineStruct(pyr::hlsl_ShadowCascade cascades[CascadedShadowMaps::MAX_CASCADES]; ) > ;
+
+}
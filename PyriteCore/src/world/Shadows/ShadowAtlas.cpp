@@ -0,0 +1,157 @@
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+
+#include "engine/Engine.h"
+#include "engine/directxlib.h"
+
+namespace pyr
+{
+
+	vec4 ShadowAtlas::Region::toUVRect(uint32_t sliceResolution) const
+	{
+		const float invResolution = 1.F / static_cast<float>(sliceResolution);
+		return vec4{ x * invResolution, y * invResolution, size * invResolution, size * invResolution };
+	}
+
+	ShadowAtlas::ShadowAtlas(uint32_t resolution, uint32_t cubeResolution)
+		: m_resolution(std::max(1U, resolution))
+		, m_cubeResolution(std::max(1U, cubeResolution))
+	{
+	}
+
+	void ShadowAtlas::reset()
+	{
+		m_slices.clear();
+		m_usedCubeCount = 0;
+	}
+
+	uint32_t ShadowAtlas::ImportanceToTier(float importance)
+	{
+		if (importance >= .5F) return 0;
+		if (importance >= .2F) return 1;
+		return 2;
+	}
+
+	ShadowAtlas::Region ShadowAtlas::allocate2D(float importance)
+	{
+		const uint32_t tier = ImportanceToTier(importance);
+		const uint32_t cellsPerRow = 1U << tier;
+
+		// Slices are dedicated to a single tier so that packing them is trivial
+		auto slice = std::ranges::find_if(m_slices, [&](const Slice& s) { return s.tier == tier && s.usedCells < cellsPerRow * cellsPerRow; });
+		if (slice == m_slices.end())
+		{
+			m_slices.push_back(Slice{ .tier = tier });
+			slice = std::prev(m_slices.end());
+		}
+
+		const uint32_t cell = slice->usedCells++;
+		const uint32_t cellSize = m_resolution >> tier;
+		return Region{
+			.slice = static_cast<uint32_t>(std::distance(m_slices.begin(), slice)),
+			.x = (cell % cellsPerRow) * cellSize,
+			.y = (cell / cellsPerRow) * cellSize,
+			.size = cellSize,
+		};
+	}
+
+	uint32_t ShadowAtlas::allocateCube()
+	{
+		return m_usedCubeCount++;
+	}
+
+	void ShadowAtlas::commit()
+	{
+		// Grow by doubling so that a light being turned on and off does not recreate the arrays every frame
+		auto growCapacity = [](size_t current, size_t required) {
+			size_t capacity = std::max<size_t>(current, 1);
+			while (capacity < required) capacity *= 2;
+			return capacity;
+		};
+
+		if (!m_slices.empty() && (!m_array2D || m_array2D->getTextureOrCubeCount() < m_slices.size()))
+		{
+			const size_t capacity = growCapacity(m_array2D ? m_array2D->getTextureOrCubeCount() : 0, m_slices.size());
+			PYR_LOGF(LogShadows, INFO, "Growing the 2D shadow array to {} slices", capacity);
+			m_array2D = std::make_unique<TextureArray>(m_resolution, m_resolution, capacity, TextureArray::Texture2D, true, true);
+			m_staticArray2D = std::make_unique<TextureArray>(m_resolution, m_resolution, capacity, TextureArray::Texture2D, true, true);
+			m_generation++;
+		}
+
+		if (m_usedCubeCount > 0 && (!m_cubeArray || m_cubeArray->getTextureOrCubeCount() / 6 < m_usedCubeCount))
+		{
+			const size_t capacity = growCapacity(m_cubeArray ? m_cubeArray->getTextureOrCubeCount() / 6 : 0, m_usedCubeCount);
+			PYR_LOGF(LogShadows, INFO, "Growing the cube shadow array to {} cubes", capacity);
+			m_cubeArray = std::make_unique<TextureArray>(m_cubeResolution, m_cubeResolution, capacity, TextureArray::TextureCube, true, true);
+			m_staticCubeArray = std::make_unique<TextureArray>(m_cubeResolution, m_cubeResolution, capacity, TextureArray::TextureCube, true, true);
+			m_staticCubeDepth = std::make_unique<TextureArray>(m_cubeResolution, m_cubeResolution, capacity * 6, TextureArray::Texture2D, true, true);
+			if (!m_cubeFaceDepth)
+				m_cubeFaceDepth = std::make_unique<TextureArray>(m_cubeResolution, m_cubeResolution, 1, TextureArray::Texture2D, true, true);
+			m_generation++;
+		}
+	}
+
+	void ShadowAtlas::bindRegion(const Region& region, Layer layer) const
+	{
+		PYR_ASSERT(m_array2D && region.slice < m_array2D->getTextureOrCubeCount(), "Shadow region used before the atlas was committed");
+
+		const TextureArray& target = layer == Layer::Static ? *m_staticArray2D : *m_array2D;
+		D3D11_VIEWPORT viewport{ static_cast<float>(region.x), static_cast<float>(region.y), static_cast<float>(region.size), static_cast<float>(region.size), 0, 1 };
+		ID3D11RenderTargetView* noColor = nullptr;
+		Engine::d3dcontext().OMSetRenderTargets(1, &noColor, target.getSliceDepthView(region.slice));
+		Engine::d3dcontext().RSSetViewports(1, &viewport);
+	}
+
+	void ShadowAtlas::clearStaticSlice(uint32_t slice) const
+	{
+		Engine::d3dcontext().ClearDepthStencilView(m_staticArray2D->getSliceDepthView(slice), D3D11_CLEAR_DEPTH, 1.0f, 0);
+	}
+
+	void ShadowAtlas::restoreSlice(uint32_t slice) const
+	{
+		const UINT subresource = D3D11CalcSubresource(0, slice, 1);
+		Engine::d3dcontext().CopySubresourceRegion(m_array2D->getRawResource(), subresource, 0, 0, 0, m_staticArray2D->getRawResource(), subresource, nullptr);
+	}
+
+	void ShadowAtlas::bindCubeFace(uint32_t cubeIndex, uint8_t face, Layer layer) const
+	{
+		PYR_ASSERT(m_cubeArray && cubeIndex < m_usedCubeCount, "Shadow cube used before the atlas was committed");
+
+		auto& context = Engine::d3dcontext();
+		const uint32_t faceSlice = cubeIndex * 6 + face;
+		ID3D11RenderTargetView* faceView = nullptr;
+		ID3D11DepthStencilView* depthView = nullptr;
+
+		if (layer == Layer::Static)
+		{
+			faceView = m_staticCubeArray->getSliceRenderTargetView(faceSlice);
+			depthView = m_staticCubeDepth->getSliceDepthView(faceSlice);
+
+			// The cube stores the distance to the closest caster, nothing rendered means nothing occludes
+			constexpr float clearDistance[4]{ D3D11_FLOAT32_MAX, D3D11_FLOAT32_MAX, D3D11_FLOAT32_MAX, D3D11_FLOAT32_MAX };
+			context.ClearRenderTargetView(faceView, clearDistance);
+			context.ClearDepthStencilView(depthView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+		}
+		else
+		{
+			faceView = m_cubeArray->getSliceRenderTargetView(faceSlice);
+			depthView = m_cubeFaceDepth->getSliceDepthView(0);
+			context.CopySubresourceRegion(m_cubeFaceDepth->getRawResource(), 0, 0, 0, 0, m_staticCubeDepth->getRawResource(), D3D11CalcSubresource(0, faceSlice, 1), nullptr);
+		}
+
+		D3D11_VIEWPORT viewport{ 0, 0, static_cast<float>(m_cubeResolution), static_cast<float>(m_cubeResolution), 0, 1 };
+		context.OMSetRenderTargets(1, &faceView, depthView);
+		context.RSSetViewports(1, &viewport);
+	}
+
+	void ShadowAtlas::restoreCube(uint32_t cubeIndex) const
+	{
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			const UINT subresource = D3D11CalcSubresource(0, cubeIndex * 6 + face, 1);
+			Engine::d3dcontext().CopySubresourceRegion(m_cubeArray->getRawResource(), subresource, 0, 0, 0, m_staticCubeArray->getRawResource(), subresource, nullptr);
+		}
+	}
+
+}
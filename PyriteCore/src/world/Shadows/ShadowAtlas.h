@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "display/texture.h"
+#include "utils/math.h"
+#include "utils/Debug.h"
+
+static inline PYR_DEFINELOG(LogShadows, VERBOSE);
+
+namespace pyr
+{
+
+// Hands out the shadow maps of the lights of a frame, and owns the arrays they are rendered into.
+//  - 2D maps (spots, directionals) are regions of the slices of a depth Texture2DArray, lights deemed less important
+//    get a smaller region and share their slice with other lights of the same size.
+//  - Point lights get a whole cube of a TextureCubeArray.
+// Lights render straight into their slice, the arrays grow when more slices than available are requested.
+//
+// Every slice and cube also has a cached copy holding only the static casters. The static layer is rendered once into the cache,
+// then copied into the live slice each time the dynamic casters have to be drawn on top of it.
+class ShadowAtlas
+{
+public:
+
+    enum class Layer : uint8_t
+    {
+        Static,  // renders into the cache
+        Dynamic, // renders into the live maps, over what was restored from the cache
+    };
+
+    static constexpr uint32_t TIER_COUNT = 3; // full slice, quarter slice, sixteenth of a slice
+
+    struct Region
+    {
+        uint32_t slice = 0;
+        uint32_t x = 0, y = 0;
+        uint32_t size = 0;
+
+        // xy is the offset and zw the scale of the region in the slice, in uv space
+        vec4 toUVRect(uint32_t sliceResolution) const;
+    };
+
+    explicit ShadowAtlas(uint32_t resolution = 1024, uint32_t cubeResolution = 512);
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+    // Frees every region, call once per frame before allocating
+    void reset();
+
+    // importance in [0,1], 1 gets a full slice
+    Region allocate2D(float importance);
+    uint32_t allocateCube();
+
+    // Grows the arrays to fit every allocation, must be called between allocating and rendering.
+    // Slices keep their content from one frame to the next unless the arrays had to grow, see getGeneration.
+    void commit();
+
+    // Binds the slice of the region in the given layer as the only target, with a viewport restricted to the region. Nothing is cleared.
+    void bindRegion(const Region& region, Layer layer) const;
+    void clearStaticSlice(uint32_t slice) const;
+    // Copies the static layer of a whole slice into the live one, regions of a depth slice can't be copied individually
+    void restoreSlice(uint32_t slice) const;
+
+    // Static faces are cleared before being bound, dynamic ones are bound with the depth of the static layer so that casters are tested against it
+    void bindCubeFace(uint32_t cubeIndex, uint8_t face, Layer layer) const;
+    void restoreCube(uint32_t cubeIndex) const;
+
+    // Incremented every time the arrays are recreated, which loses every shadow map
+    uint32_t getGeneration() const { return m_generation; }
+
+    const TextureArray* getTexture2DArray() const { return m_array2D.get(); }
+    const TextureArray* getCubeArray() const { return m_cubeArray.get(); }
+    uint32_t getResolution() const { return m_resolution; }
+    uint32_t getCubeResolution() const { return m_cubeResolution; }
+    uint32_t getUsedSliceCount() const { return static_cast<uint32_t>(m_slices.size()); }
+    uint32_t getUsedCubeCount() const { return m_usedCubeCount; }
+
+private:
+
+    struct Slice
+    {
+        uint32_t tier = 0;
+        uint32_t usedCells = 0;
+    };
+
+    static uint32_t ImportanceToTier(float importance);
+
+    uint32_t m_resolution;
+    uint32_t m_cubeResolution;
+
+    std::vector<Slice> m_slices;
+    uint32_t m_usedCubeCount = 0;
+    uint32_t m_generation = 0;
+
+    std::unique_ptr<TextureArray> m_array2D;
+    std::unique_ptr<TextureArray> m_staticArray2D;
+    std::unique_ptr<TextureArray> m_cubeArray;
+    std::unique_ptr<TextureArray> m_staticCubeArray;
+    std::unique_ptr<TextureArray> m_staticCubeDepth; // z-buffer of every face of the static layer, the cube arrays only store the linear distance
+    std::unique_ptr<TextureArray> m_cubeFaceDepth;   // z-buffer of the face being drawn in the dynamic layer
+};
+
+}
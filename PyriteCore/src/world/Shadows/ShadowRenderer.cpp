@@ -0,0 +1,341 @@
+#include "ShadowRenderer.h"
+
+#include <algorithm>
+#include <ranges>
+#include <utility>
+
+#include "display/shader.h"
+#include "display/UpdateScheduler.h"
+#include "world/Mesh/StaticMesh.h"
+#include "world/Tools/SceneRenderTools.h"
+
+namespace pyr
+{
+
+	static constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+
+	// FNV-1a, only used to detect changes from one frame to the next
+	static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	template<class T>
+	static uint64_t HashValue(uint64_t hash, const T& value)
+	{
+		return HashBytes(hash, &value, sizeof(T));
+	}
+
+	static Camera MakeShadowCamera(const SpotLight& light)
+	{
+		Camera camera{};
+		camera.setProjection(light.shadow_projection);
+		camera.setPosition(light.GetTransform().position);
+		vec3 direction = { light.GetTransform().rotation.x, light.GetTransform().rotation.y, light.GetTransform().rotation.z };
+		camera.lookAt(light.GetTransform().position + direction);
+		return camera;
+	}
+
+	float ShadowRenderer::ComputeShadowImportance(const Camera& viewCamera, const vec3& lightPosition)
+	{
+		// Lights far from the camera get a smaller region of the atlas, see ShadowAtlas::allocate2D
+		const float distance = (viewCamera.getPosition() - lightPosition).Length();
+		return 1.F / (1.F + distance / 25.F);
+	}
+
+	void ShadowRenderer::render(RegisteredRenderableActorCollection& actors, const Camera& viewCamera)
+	{
+		auto castsShadows = [](const BaseLight& light) -> bool { return light.isOn && light.shadowMode == DynamicShadow; };
+		auto makeKey = [](const Actor& light, uint32_t subIndex) { return (static_cast<uint64_t>(light.GetActorID()) << 32) | subIndex; };
+
+		m_atlas.reset();
+		m_views.clear();
+		m_stats = {};
+
+		// -- Allocate every shadow map first, the atlas must know about all of them before anything is rendered
+		for (SpotLight& light : actors.lights.Spots)
+		{
+			if (!castsShadows(light)) continue;
+
+			ShadowView view{ .key = makeKey(light, 0), .camera = MakeShadowCamera(light) };
+			view.priority = ComputeShadowImportance(viewCamera, std::as_const(light).GetTransform().position);
+			view.region = m_atlas.allocate2D(view.priority);
+			view.lightHash = HashValue(HASH_SEED, view.camera.getViewProjectionMatrix());
+			light.shadowMapIndex = static_cast<int>(view.region.slice);
+			light.shadowMapRect = view.region.toUVRect(m_atlas.getResolution());
+
+			const Frustum frustum = Frustum::createFrustumFromCamera(view.camera);
+			std::vector<const StaticMesh*> casters;
+			actors.getMeshComponents().cullFrustum(frustum, casters);
+			addView(std::move(view), casters);
+		}
+
+		// Directional lights get one full slice per cascade
+		ShadowCascadesBuffer::data_t cascadesData{};
+		uint32_t cascadeCount = 0;
+		for (DirectionalLight& light : actors.lights.Directionals)
+		{
+			light.shadowCascadeCount = 0;
+			if (!castsShadows(light)) continue;
+
+			std::vector<ShadowCascade> cascades = CascadedShadowMaps::ComputeCascades(viewCamera, light, actors.meshes, m_atlas.getResolution());
+			if (cascadeCount + cascades.size() > CascadedShadowMaps::MAX_CASCADES)
+			{
+				PYR_LOG(LogShadows, WARN, "Too many shadow cascades, some directional lights won't cast shadows");
+				continue;
+			}
+
+			light.shadowMapIndex = static_cast<int>(cascadeCount);
+			light.shadowCascadeCount = static_cast<uint32_t>(cascades.size());
+			for (uint32_t cascadeIndex = 0; cascadeIndex < cascades.size(); cascadeIndex++)
+			{
+				ShadowCascade& cascade = cascades[cascadeIndex];
+				ShadowView view{ .key = makeKey(light, cascadeIndex), .camera = cascade.camera, .cascade = static_cast<int>(cascadeCount) };
+				view.priority = 1.F / static_cast<float>(1 + cascadeIndex); // < the first cascades cover most of the screen
+				view.region = m_atlas.allocate2D(1.F);
+				view.lightHash = HashValue(HASH_SEED, view.camera.getViewProjectionMatrix());
+
+				cascadesData.cascades[cascadeCount++] = hlsl_ShadowCascade{
+					.shadowMapRect = view.region.toUVRect(m_atlas.getResolution()),
+					.slice = view.region.slice,
+				};
+				addView(std::move(view), cascade.casters);
+			}
+		}
+
+		for (PointLight& light : actors.lights.Points)
+		{
+			if (!castsShadows(light)) continue;
+
+			// Past its range the light is too dim for its shadow to matter
+			const float range = light.range.x;
+			const vec3& position = std::as_const(light).GetTransform().position;
+			const float distance = (viewCamera.getPosition() - position).Length();
+
+			ShadowView view{ .key = makeKey(light, 0), .bIsCube = true, .origin = position };
+			view.priority = distance <= range ? 1.F : range / distance; // < rough size of the lit area on screen
+			view.cube = m_atlas.allocateCube();
+			view.lightHash = HashValue(HASH_SEED, view.origin);
+			light.shadowMapIndex = static_cast<int>(view.cube);
+
+			std::vector<const StaticMesh*> casters;
+			actors.getMeshComponents().cullSphere(view.origin, range, casters);
+			addView(std::move(view), casters);
+		}
+
+		m_atlas.commit();
+
+		for (ShadowView& view : m_views)
+			prepareView(view);
+
+		scheduleStaticLayers();
+		renderDynamicLayers();
+
+		// -- Cascades are sampled with the camera their static layer was rendered with, which may be a few frames old
+		for (const ShadowView& view : m_views)
+		{
+			if (view.cascade >= 0)
+				cascadesData.cascades[view.cascade].viewProjection = view.renderedCamera.getViewProjectionMatrix();
+		}
+		m_cascadesBuffer->setData(cascadesData);
+
+		// -- Remember what was rendered, lights that disappeared are forgotten
+		std::unordered_map<uint64_t, CachedView> cache;
+		cache.reserve(m_views.size());
+		for (const ShadowView& view : m_views)
+		{
+			cache[view.key] = CachedView{
+				.lightHash = view.lightHash,
+				.staticCastersHash = view.staticCastersHash,
+				.region = view.region,
+				.cube = view.cube,
+				.atlasGeneration = m_atlas.getGeneration(),
+				.bIsCube = view.bIsCube,
+				.bHadDynamicCasters = !view.dynamicCasters.empty(),
+				.staleFaces = view.staleFaces,
+				.renderedCamera = view.renderedCamera,
+			};
+
+			if (view.bStaticLayerRendered) m_stats.staticLayersRendered++;
+			if (view.staleFaces != 0) m_stats.staleShadowMaps++;
+		}
+		m_cache = std::move(cache);
+		m_stats.shadowMapCount = static_cast<uint32_t>(m_views.size());
+	}
+
+	void ShadowRenderer::addView(ShadowView&& view, std::span<const StaticMesh* const> casters)
+	{
+		view.staticCastersHash = HASH_SEED;
+		for (const StaticMesh* caster : casters)
+		{
+			if (caster->GetMobility() == ActorMobility::Movable)
+			{
+				view.dynamicCasters.push_back(caster);
+				continue;
+			}
+
+			view.staticCasters.push_back(caster);
+			view.staticCastersHash = HashValue(view.staticCastersHash, caster->GetActorID());
+			view.staticCastersHash = HashValue(view.staticCastersHash, caster->GetWorldMatrix());
+		}
+		m_views.push_back(std::move(view));
+	}
+
+	void ShadowRenderer::prepareView(ShadowView& view) const
+	{
+		const uint8_t allFaces = view.bIsCube ? ALL_CUBE_FACES : 1;
+		view.renderedCamera = view.camera;
+
+		auto it = m_cache.find(view.key);
+		const bool bSameLocation = it != m_cache.end() && (view.bIsCube
+			? it->second.bIsCube && it->second.cube == view.cube
+			: !it->second.bIsCube && it->second.region.slice == view.region.slice && it->second.region.x == view.region.x && it->second.region.y == view.region.y && it->second.region.size == view.region.size);
+
+		if (!bSameLocation || it->second.atlasGeneration != m_atlas.getGeneration())
+		{
+			view.staleFaces = allFaces;
+			view.bMustRefresh = true;
+			return;
+		}
+
+		const CachedView& cached = it->second;
+		view.bHadDynamicCasters = cached.bHadDynamicCasters;
+		view.staleFaces = cached.staleFaces;
+		view.renderedCamera = cached.renderedCamera;
+		if (cached.lightHash != view.lightHash || cached.staticCastersHash != view.staticCastersHash)
+			view.staleFaces = allFaces;
+
+		// Spots and points are sampled with the light as it is now, a map rendered from elsewhere would be plain wrong.
+		// Cascades carry the camera they were rendered with and can wait.
+		view.bMustRefresh = cached.lightHash != view.lightHash && view.cascade < 0;
+	}
+
+	void ShadowRenderer::scheduleStaticLayers()
+	{
+		std::vector<UpdateScheduler::Update> updates;
+
+		// -- 2D maps, depth slices can only be cleared and copied as a whole so every region of a slice is refreshed together
+		struct SliceUpdate
+		{
+			bool bStale = false;
+			bool bMandatory = false;
+			float priority = 0.F;
+			uint32_t cost = 0;
+		};
+		std::vector<SliceUpdate> slices(m_atlas.getUsedSliceCount());
+		for (const ShadowView& view : m_views)
+		{
+			if (view.bIsCube) continue;
+			SliceUpdate& slice = slices[view.region.slice];
+			slice.bStale |= view.staleFaces != 0;
+			slice.bMandatory |= view.bMustRefresh;
+			slice.priority = std::max(slice.priority, view.priority);
+			slice.cost += static_cast<uint32_t>(view.staticCasters.size());
+		}
+
+		for (uint32_t slice = 0; slice < slices.size(); slice++)
+		{
+			if (!slices[slice].bStale) continue;
+			updates.push_back(UpdateScheduler::Update{
+				.key = UpdateScheduler::MakeKey(this, slice),
+				.priority = slices[slice].priority,
+				.cost = std::max(1U, slices[slice].cost),
+				.bMandatory = slices[slice].bMandatory,
+				.run = [this, slice] { renderStaticSlice(slice); },
+			});
+		}
+
+		// -- Cubes are updated face by face
+		for (size_t viewIndex = 0; viewIndex < m_views.size(); viewIndex++)
+		{
+			const ShadowView& view = m_views[viewIndex];
+			if (!view.bIsCube) continue;
+			for (uint8_t face = 0; face < 6; face++)
+			{
+				if (!(view.staleFaces & (1 << face))) continue;
+				updates.push_back(UpdateScheduler::Update{
+					.key = UpdateScheduler::MakeKey(this, (1ull << 32) | (view.cube * 6 + face)),
+					.priority = view.priority,
+					.cost = std::max(1U, static_cast<uint32_t>(view.staticCasters.size())),
+					.bMandatory = view.bMustRefresh,
+					.run = [this, viewIndex, face] { renderStaticCubeFace(m_views[viewIndex], face); },
+				});
+			}
+		}
+
+		UpdateScheduler::get().schedule(updates);
+	}
+
+	void ShadowRenderer::renderStaticSlice(uint32_t slice)
+	{
+		m_atlas.clearStaticSlice(slice);
+		for (ShadowView& view : m_views | std::views::filter([slice](const ShadowView& view) { return !view.bIsCube && view.region.slice == slice; }))
+		{
+			SceneRenderTools::MakeSceneDepth(view.staticCasters, view.camera, m_atlas, view.region, ShadowAtlas::Layer::Static);
+			view.renderedCamera = view.camera;
+			view.staleFaces = 0;
+			view.bStaticLayerRendered = true;
+		}
+	}
+
+	void ShadowRenderer::renderStaticCubeFace(ShadowView& view, uint8_t face)
+	{
+		SceneRenderTools::MakeSceneDepthCubeFaceFromPoint(view.staticCasters, view.origin, m_atlas, view.cube, face, ShadowAtlas::Layer::Static);
+		view.staleFaces &= static_cast<uint8_t>(~(1 << face));
+		view.bStaticLayerRendered = true;
+	}
+
+	void ShadowRenderer::renderDynamicLayers()
+	{
+		// The live maps are restored from the static layer when it changed, or to erase last frame's movable casters
+		auto needsRestore = [](const ShadowView& view) { return view.bStaticLayerRendered || view.bHadDynamicCasters || !view.dynamicCasters.empty(); };
+
+		std::vector<bool> slicesToRestore(m_atlas.getUsedSliceCount(), false);
+		for (const ShadowView& view : m_views)
+		{
+			if (!view.bIsCube && needsRestore(view))
+				slicesToRestore[view.region.slice] = true;
+		}
+
+		for (uint32_t slice = 0; slice < slicesToRestore.size(); slice++)
+		{
+			if (!slicesToRestore[slice]) continue;
+
+			m_atlas.restoreSlice(slice);
+			for (const ShadowView& view : m_views | std::views::filter([slice](const ShadowView& view) { return !view.bIsCube && view.region.slice == slice; }))
+			{
+				if (view.dynamicCasters.empty()) continue;
+				SceneRenderTools::MakeSceneDepth(view.dynamicCasters, view.renderedCamera, m_atlas, view.region, ShadowAtlas::Layer::Dynamic);
+				m_stats.dynamicLayersRendered++;
+			}
+		}
+
+		for (const ShadowView& view : m_views)
+		{
+			if (!view.bIsCube || !needsRestore(view)) continue;
+
+			m_atlas.restoreCube(view.cube);
+			if (!view.dynamicCasters.empty())
+			{
+				SceneRenderTools::MakeSceneDepthCubemapFromPoint(view.dynamicCasters, view.origin, m_atlas, view.cube, ShadowAtlas::Layer::Dynamic);
+				m_stats.dynamicLayersRendered++;
+			}
+		}
+	}
+
+	void ShadowRenderer::bindShadowMaps(const Effect& effect) const
+	{
+		if (m_atlas.getUsedSliceCount() > 0)
+			effect.bindTexture(*m_atlas.getTexture2DArray(), "lightmaps_2D");
+		if (m_atlas.getUsedCubeCount() > 0)
+			effect.bindTexture(*m_atlas.getCubeArray(), "lightmaps_3D");
+		effect.bindConstantBuffer("ShadowCascadesBuffer", m_cascadesBuffer);
+	}
+
+}
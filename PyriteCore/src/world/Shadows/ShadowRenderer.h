@@ -0,0 +1,108 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "CascadedShadowMaps.h"
+#include "ShadowAtlas.h"
+#include "scene/RenderableActorCollection.h"
+#include "world/camera.h"
+
+namespace pyr
+{
+
+class Effect;
+class StaticMesh;
+
+// Renders the shadow maps of every shadow casting light of a scene into a ShadowAtlas, and binds them for the lighting shaders.
+//
+// Shadow maps are cached from one frame to the next: static casters are rendered once into the static layer of the atlas and only
+// movable casters are redrawn on top of it every frame. The static layer of a shadow map is invalidated when its light moves or changes
+// its projection, or when a static caster in the light's volume moves, appears or disappears.
+//
+// Static layers are re-rendered through the UpdateScheduler, by slice for 2D maps and by face for cubes, most important lights first.
+// Until its update runs a shadow map keeps its stale static layer, cascades are even sampled with the camera they were rendered with.
+// A map that can't be used at all (new light, moved spot or point light, region that changed) is always rendered right away.
+class ShadowRenderer
+{
+public:
+
+    struct Stats
+    {
+        uint32_t shadowMapCount = 0;
+        uint32_t staticLayersRendered = 0; // shadow maps which static layer was (partly) re-rendered this frame
+        uint32_t dynamicLayersRendered = 0; // shadow maps which movable casters were drawn this frame
+        uint32_t staleShadowMaps = 0; // shadow maps still waiting for an update at the end of the frame
+    };
+
+    ShadowRenderer() = default;
+    ShadowRenderer(const ShadowRenderer&) = delete;
+    ShadowRenderer& operator=(const ShadowRenderer&) = delete;
+
+    // Also updates the shadow indices of the lights, must be called before converting them for the shaders
+    void render(RegisteredRenderableActorCollection& actors, const Camera& viewCamera);
+    void bindShadowMaps(const Effect& effect) const;
+
+    const Stats& getStats() const { return m_stats; }
+    const ShadowAtlas& getAtlas() const { return m_atlas; }
+
+private:
+
+    static constexpr uint8_t ALL_CUBE_FACES = 0b111111;
+
+    // A single shadow map: the region of a spot, of a cascade, or the cube of a point light
+    struct ShadowView
+    {
+        uint64_t key = 0; // actor id and cascade index
+        bool bIsCube = false;
+        Camera camera; // 2D views only
+        vec3 origin;   // cubes only
+        ShadowAtlas::Region region;
+        uint32_t cube = 0;
+        int cascade = -1; // index in the cascades buffer
+        float priority = 0.F;
+
+        std::vector<const StaticMesh*> staticCasters;
+        std::vector<const StaticMesh*> dynamicCasters;
+        uint64_t lightHash = 0;
+        uint64_t staticCastersHash = 0;
+
+        // Set by prepareView and the updates
+        uint8_t staleFaces = 0; // parts of the static layer to re-render, a single bit for 2D views
+        bool bMustRefresh = false; // the stale static layer can't be used, even for a frame
+        bool bHadDynamicCasters = false;
+        bool bStaticLayerRendered = false; // this frame
+        Camera renderedCamera; // 2D views only, the camera the static layer was rendered with
+    };
+
+    struct CachedView
+    {
+        uint64_t lightHash = 0;
+        uint64_t staticCastersHash = 0;
+        ShadowAtlas::Region region;
+        uint32_t cube = 0;
+        uint32_t atlasGeneration = 0;
+        bool bIsCube = false;
+        bool bHadDynamicCasters = false;
+        uint8_t staleFaces = 0;
+        Camera renderedCamera;
+    };
+
+    void addView(ShadowView&& view, std::span<const StaticMesh* const> casters);
+    void prepareView(ShadowView& view) const;
+    void scheduleStaticLayers();
+    void renderStaticSlice(uint32_t slice);
+    void renderStaticCubeFace(ShadowView& view, uint8_t face);
+    void renderDynamicLayers();
+
+    static float ComputeShadowImportance(const Camera& viewCamera, const vec3& lightPosition);
+
+    ShadowAtlas m_atlas;
+    std::vector<ShadowView> m_views;
+    std::unordered_map<uint64_t, CachedView> m_cache;
+    std::shared_ptr<ShadowCascadesBuffer> m_cascadesBuffer = std::make_shared<ShadowCascadesBuffer>();
+    Stats m_stats;
+};
+
+}
@@ -0,0 +1,106 @@
+#include "DrawCommandCache.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "world/Material.h"
+#include "world/Mesh/StaticMesh.h"
+
+namespace pyr
+{
+
+	// Only used to group commands, collisions cost a few redundant bindings at worst
+	static uint64_t Fold16(const void* pointer)
+	{
+		const size_t hash = std::hash<const void*>{}(pointer);
+		return (hash ^ (hash >> 16) ^ (hash >> 32) ^ (hash >> 48)) & 0xffff;
+	}
+
+	// effect (16 bits) | material handle (32 bits) | mesh (16 bits)
+	static uint64_t MakeSortKey(const Material* material, const StaticMesh& mesh)
+	{
+		uint64_t key = Fold16(&mesh);
+		if (material)
+		{
+			key |= static_cast<uint64_t>(material->getBankHandle().value) << 16;
+			key |= Fold16(material->getEffect()) << 48;
+		}
+		return key;
+	}
+
+	void DrawCommandCache::buildCommands(const StaticMesh& mesh, std::vector<DrawCommand>& outCommands) const
+	{
+		outCommands.clear();
+		std::span<const SubMesh> submeshes = mesh.getModel()->getRawMeshData()->getSubmeshes();
+		for (const SubMesh& submesh : submeshes)
+		{
+			if (submesh.getIndexCount() == 0) continue;
+
+			if (m_type == CommandType::DepthOnly)
+			{
+				if (!outCommands.empty() && outCommands.back().startIndex + outCommands.back().indexCount == submesh.startIndex)
+				{
+					outCommands.back().indexCount += static_cast<uint32_t>(submesh.getIndexCount());
+					continue;
+				}
+				outCommands.push_back(DrawCommand{
+					.sortKey = MakeSortKey(nullptr, mesh),
+					.mesh = &mesh,
+					.startIndex = static_cast<uint32_t>(submesh.startIndex),
+					.indexCount = static_cast<uint32_t>(submesh.getIndexCount()),
+				});
+				continue;
+			}
+
+			const Material* material = mesh.getMaterial(submesh.materialIndex);
+			if (!material || !material->getEffect()) continue;
+			outCommands.push_back(DrawCommand{
+				.sortKey = MakeSortKey(material, mesh),
+				.mesh = &mesh,
+				.material = material,
+				.startIndex = static_cast<uint32_t>(submesh.startIndex),
+				.indexCount = static_cast<uint32_t>(submesh.getIndexCount()),
+			});
+		}
+	}
+
+	bool DrawCommandCache::isSameAsPreviousFrame(std::span<const StaticMesh* const> meshes) const
+	{
+		if (meshes.size() != m_previousMeshes.size()) return false;
+		for (size_t i = 0; i < meshes.size(); i++)
+			if (meshes[i] != m_previousMeshes[i] || meshes[i]->getRevision() != m_previousRevisions[i])
+				return false;
+		return true;
+	}
+
+	std::span<const DrawCommand> DrawCommandCache::update(std::span<const StaticMesh* const> meshes)
+	{
+		if (isSameAsPreviousFrame(meshes))
+			return m_sortedCommands;
+
+		m_frame++;
+		m_sortedCommands.clear();
+		m_previousMeshes.assign(meshes.begin(), meshes.end());
+		m_previousRevisions.clear();
+		for (const StaticMesh* mesh : meshes)
+		{
+			MeshCommands& cached = m_meshCommands[mesh];
+			// Revisions are unique across meshes, a new mesh allocated where a destroyed one was is built again too
+			if (cached.revision != mesh->getRevision())
+			{
+				buildCommands(*mesh, cached.commands);
+				cached.revision = mesh->getRevision();
+			}
+			cached.lastFrame = m_frame;
+			m_previousRevisions.push_back(cached.revision);
+			m_sortedCommands.insert(m_sortedCommands.end(), cached.commands.begin(), cached.commands.end());
+		}
+
+		// Meshes that were not given this time may have been destroyed, their commands can't be kept
+		std::erase_if(m_meshCommands, [this](const auto& entry) { return entry.second.lastFrame != m_frame; });
+
+		std::ranges::stable_sort(m_sortedCommands, {}, &DrawCommand::sortKey);
+		return m_sortedCommands;
+	}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace pyr
+{
+
+class Material;
+class StaticMesh;
+
+// A DrawIndexed of a pass, resolved once and reused for as long as its mesh does not change
+struct DrawCommand
+{
+    uint64_t sortKey = 0;
+    const StaticMesh* mesh = nullptr;
+    const Material* material = nullptr; // null for depth only commands
+    uint32_t startIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+// The draw commands of a pass, kept from one frame to the next.
+// Commands of a mesh are only built again when the mesh's model or materials change (see StaticMesh::getRevision), and the
+// sorted list is reused as is when the pass is given the same meshes as the previous frame. Transforms are not part of
+// the commands, they are read when submitting.
+//
+// Shaded commands are sorted by effect then material so that consecutive draws share their bindings.
+// Depth only commands need no material, the contiguous submeshes of a mesh are merged into a single draw.
+class DrawCommandCache
+{
+public:
+
+    enum class CommandType { Shaded, DepthOnly };
+
+    explicit DrawCommandCache(CommandType type) : m_type(type) {}
+
+    // Valid until the next call
+    std::span<const DrawCommand> update(std::span<const StaticMesh* const> meshes);
+
+private:
+
+    struct MeshCommands
+    {
+        uint64_t revision = 0;
+        uint64_t lastFrame = 0;
+        std::vector<DrawCommand> commands;
+    };
+
+    void buildCommands(const StaticMesh& mesh, std::vector<DrawCommand>& outCommands) const;
+    bool isSameAsPreviousFrame(std::span<const StaticMesh* const> meshes) const;
+
+private:
+
+    CommandType m_type;
+    uint64_t m_frame = 0;
+    std::unordered_map<const StaticMesh*, MeshCommands> m_meshCommands;
+
+    // Meshes given to the last update, with their revision at that time
+    std::vector<const StaticMesh*> m_previousMeshes;
+    std::vector<uint64_t> m_previousRevisions;
+    std::vector<DrawCommand> m_sortedCommands;
+};
+
+}
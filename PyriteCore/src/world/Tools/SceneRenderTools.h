@@ -7,9 +7,11 @@
 #include "scene/scene.h"
 #include "world/camera.h"
 
+#include "display/EffectPermutations.h"
 #include "display/RenderGraph/RenderGraph.h"
 #include "display/RenderGraph/BuiltinPasses/DepthPrePass.h"
 #include "display/RenderProfiles.h"
+#include "world/Shadows/ShadowAtlas.h"
 
 namespace pyr
 {
@@ -25,7 +27,6 @@ private:
 	{
 		pyr::Effect* depthOnlyEffect = nullptr;
 		pyr::Camera camera;
-		pyr::GraphicalResourceRegistry registry;
 		struct Buffers
 		{
 			std::shared_ptr<pyr::CameraBuffer>  pcameraBuffer = std::make_shared<pyr::CameraBuffer>();
@@ -34,24 +35,21 @@ private:
 
 		enum RenderType { Texture2D, TextureCube };
 		DepthDrawer(RenderType type)
+			: depthOnlyEffect(GetDepthOnlyEffects().get(type == TextureCube ? LINEARIZE_DEPTH : 0))
 		{
-			std::vector<pyr::Effect::define_t> defines{};
-		
-			if (type == TextureCube) defines.emplace_back("LINEARIZE_DEPTH", "1");
-
-			depthOnlyEffect = registry.loadEffect(
-				L"res/shaders/depthOnly.fx",
-				InputLayout::MakeLayoutFromVertex<pyr::RawMeshData::mesh_vertex_t>(),
-				defines);
-
 		}
 
 		void Render(const RegisteredRenderableActorCollection& sceneDescription)
 		{
-			for (const StaticMesh* smesh : sceneDescription.meshes)
+			Render(sceneDescription.meshes);
+		}
+
+		void Render(std::span<const StaticMesh* const> meshes)
+		{
+			for (const StaticMesh* smesh : meshes)
 			{
 				smesh->bindModel();
-				buffers.pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = smesh->GetTransform().getWorldMatrix() });
+				buffers.pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = smesh->GetWorldMatrix() });
 				depthOnlyEffect->bindConstantBuffer("ActorBuffer", buffers.pActorBuffer);
 				depthOnlyEffect->bind();
 				std::span<const SubMesh> submeshes = smesh->getModel()->getRawMeshData()->getSubmeshes();
@@ -64,11 +62,54 @@ private:
 
 	};
 
+	static constexpr EffectPermutations::mask_t LINEARIZE_DEPTH = 1 << 0;
+
+	// Both permutations are compiled together, by whichever drawer is created first
+	static EffectPermutations& GetDepthOnlyEffects()
+	{
+		static GraphicalResourceRegistry registry;
+		static EffectPermutations permutations = []
+		{
+			EffectPermutations permutations{ registry, L"res/shaders/depthOnly.fx", { "LINEARIZE_DEPTH" } };
+			permutations.addAll(InputLayout::MakeLayoutFromVertex<pyr::RawMeshData::mesh_vertex_t>());
+			return permutations;
+		}();
+		return permutations;
+	}
+
+	// Shared by the framebuffer and atlas versions so that the effects are only compiled once
+	static DepthDrawer& GetDepthDrawer(DepthDrawer::RenderType type)
+	{
+		static DepthDrawer depthDrawer2D{ DepthDrawer::Texture2D };
+		static DepthDrawer depthDrawer3D{ DepthDrawer::TextureCube };
+		return type == DepthDrawer::TextureCube ? depthDrawer3D : depthDrawer2D;
+	}
+
+	static void SetupCubeFaceCamera(pyr::Camera& camera, const vec3& worldPosition, int faceID)
+	{
+		static constexpr std::array<vec3, 6> directions{
+			{
+				{1,0,0},
+				{-1,0,0},
+				{0,1,0},
+				{0,-1,0},
+				{0,0,-1},
+				{0,0, 1},
+		} };
+
+		camera.setPosition(worldPosition);
+		camera.lookAt(worldPosition + directions[faceID]);
+		if (faceID == 2) camera.rotate(0.f, 3.14159f, 0.f); // why ? it works
+		if (faceID == 3) camera.rotate(0.f, 3.14159f, 0.f); // why ? it works
+		if (faceID == 4) camera.rotate(0.f, 3.14159f, 0.f); // why ? it works
+		if (faceID == 5) camera.rotate(0.f, 3.14159f, 0.f); // why ? it works
+	}
+
 public:
 
 	static Texture MakeSceneDepth(const RegisteredRenderableActorCollection& sceneDescription, const Camera& camera, pyr::FrameBuffer& outFramebuffer)
 	{
-		static DepthDrawer depthDrawer2D{ DepthDrawer::Texture2D };
+		DepthDrawer& depthDrawer2D = GetDepthDrawer(DepthDrawer::Texture2D);
 
 		outFramebuffer.bind();
 		pyr::Engine::d3dcontext().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -95,21 +136,10 @@ public:
 
 	static Cubemap MakeSceneDepthCubemapFromPoint(const RegisteredRenderableActorCollection& sceneDescription, const vec3& worldPositon, pyr::CubemapFramebuffer& outFramebuffer)
 	{
-		static DepthDrawer depthDrawer3D{ DepthDrawer::TextureCube };
-
-		static constexpr std::array<vec3, 6> directions{
-			{
-				{1,0,0},
-				{-1,0,0},
-				{0,1,0},
-				{0,-1,0},
-				{0,0,-1},
-				{0,0, 1},
-		} };
+		DepthDrawer& depthDrawer3D = GetDepthDrawer(DepthDrawer::TextureCube);
 
 		static pyr::Camera renderCamera{};
 		renderCamera.setProjection(pyr::PerspectiveProjection{ .fovy = XM_PIDIV2, .aspect = 1.F,.zNear = 0.01f,  .zFar = 1000.F });
-		renderCamera.setPosition(worldPositon);
 
 		pyr::Engine::d3dcontext().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 		pyr::RenderProfiles::pushRasterProfile(pyr::RasterizerProfile::NOCULL_RASTERIZER);
@@ -118,11 +148,7 @@ public:
 		// -- Draw the 6 faces
 		for (int faceID = 0; faceID < 6; faceID++)
 		{
-			renderCamera.lookAt(renderCamera.getPosition() + directions[faceID]);
-			if (faceID == 2) renderCamera.rotate(0.f, 3.14159f, 0.f); // why ? it works
-			if (faceID == 3) renderCamera.rotate(0.f, 3.14159f, 0.f); // why ? it works
-			if (faceID == 4) renderCamera.rotate(0.f, 3.14159f, 0.f); // why ? it works
-			if (faceID == 5) renderCamera.rotate(0.f, 3.14159f, 0.f); // why ? it works
+			SetupCubeFaceCamera(renderCamera, worldPositon, faceID);
 
 			depthDrawer3D.buffers.pcameraBuffer->setData(pyr::CameraBuffer::data_t{
 					.mvp = renderCamera.getViewProjectionMatrix(),
@@ -145,5 +171,66 @@ public:
 
 		return outFramebuffer.getTargetAsCubemap(FrameBuffer::COLOR_0);
 	}
+
+	// Renders the depth of the casters seen from the camera into a region of one layer of the shadow atlas, the atlas must have been committed
+	static void MakeSceneDepth(std::span<const StaticMesh* const> casters, const Camera& camera, const ShadowAtlas& atlas, const ShadowAtlas::Region& region, ShadowAtlas::Layer layer)
+	{
+		DepthDrawer& depthDrawer2D = GetDepthDrawer(DepthDrawer::Texture2D);
+
+		atlas.bindRegion(region, layer);
+		pyr::Engine::d3dcontext().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		pyr::RenderProfiles::pushRasterProfile(pyr::RasterizerProfile::NOCULL_RASTERIZER);
+		pyr::RenderProfiles::pushDepthProfile(pyr::DepthProfile::TESTWRITE_DEPTH);
+
+		depthDrawer2D.buffers.pcameraBuffer->setData(pyr::CameraBuffer::data_t{
+				.mvp = camera.getViewProjectionMatrix(),
+				.pos = camera.getPosition()
+		});
+
+		depthDrawer2D.depthOnlyEffect->bindConstantBuffer("CameraBuffer", depthDrawer2D.buffers.pcameraBuffer);
+		depthDrawer2D.Render(casters);
+		depthDrawer2D.depthOnlyEffect->unbindResources();
+
+		pyr::RenderProfiles::popDepthProfile();
+		pyr::RenderProfiles::popRasterProfile();
+
+		FrameBuffer::getActiveFrameBuffer().bindToD3DContext();
+	}
+
+	// Renders the distance from the point to the casters into one face of a cube of one layer of the shadow atlas, the atlas must have been committed
+	static void MakeSceneDepthCubeFaceFromPoint(std::span<const StaticMesh* const> casters, const vec3& worldPositon, const ShadowAtlas& atlas, uint32_t cubeIndex, uint8_t faceID, ShadowAtlas::Layer layer)
+	{
+		DepthDrawer& depthDrawer3D = GetDepthDrawer(DepthDrawer::TextureCube);
+
+		static pyr::Camera renderCamera{};
+		renderCamera.setProjection(pyr::PerspectiveProjection{ .fovy = XM_PIDIV2, .aspect = 1.F,.zNear = 0.01f,  .zFar = 1000.F });
+		SetupCubeFaceCamera(renderCamera, worldPositon, faceID);
+
+		pyr::Engine::d3dcontext().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		pyr::RenderProfiles::pushRasterProfile(pyr::RasterizerProfile::NOCULL_RASTERIZER);
+		pyr::RenderProfiles::pushDepthProfile(pyr::DepthProfile::TESTWRITE_DEPTH);
+
+		depthDrawer3D.buffers.pcameraBuffer->setData(pyr::CameraBuffer::data_t{
+				.mvp = renderCamera.getViewProjectionMatrix(),
+				.pos = renderCamera.getPosition()
+			});
+
+		atlas.bindCubeFace(cubeIndex, faceID, layer);
+		depthDrawer3D.depthOnlyEffect->bindConstantBuffer("CameraBuffer", depthDrawer3D.buffers.pcameraBuffer);
+		depthDrawer3D.depthOnlyEffect->setUniform("u_sourcePosition", worldPositon);
+		depthDrawer3D.Render(casters);
+		depthDrawer3D.depthOnlyEffect->unbindResources();
+
+		pyr::RenderProfiles::popDepthProfile();
+		pyr::RenderProfiles::popRasterProfile();
+
+		FrameBuffer::getActiveFrameBuffer().bindToD3DContext();
+	}
+
+	static void MakeSceneDepthCubemapFromPoint(std::span<const StaticMesh* const> casters, const vec3& worldPositon, const ShadowAtlas& atlas, uint32_t cubeIndex, ShadowAtlas::Layer layer)
+	{
+		for (uint8_t faceID = 0; faceID < 6; faceID++)
+			MakeSceneDepthCubeFaceFromPoint(casters, worldPositon, atlas, cubeIndex, faceID, layer);
+	}
 }; 
 }
\ No newline at end of file
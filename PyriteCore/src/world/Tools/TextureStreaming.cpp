@@ -0,0 +1,52 @@
+#include "TextureStreaming.h"
+
+#include <algorithm>
+#include <cmath>
+#include <variant>
+
+#include "display/TextureCache.h"
+#include "world/camera.h"
+#include "world/Mesh/MeshComponents.h"
+#include "world/Mesh/StaticMesh.h"
+
+namespace pyr
+{
+
+	void TextureStreaming::RequestVisibleMips(const MeshComponents& meshes, const Camera& camera, float viewportHeight)
+	{
+		const PerspectiveProjection* projection = std::get_if<PerspectiveProjection>(&camera.getProjection());
+		if (!projection) return;
+
+		const Frustum frustum = Frustum::createFrustumFromCamera(camera);
+		const float pixelsPerUnitAtUnitDistance = viewportHeight / (2.F * std::tan(projection->fovy * .5F));
+
+		std::vector<const StaticMesh*> visibleMeshes;
+		meshes.cullFrustum(frustum, visibleMeshes);
+		for (const StaticMesh* mesh : visibleMeshes)
+		{
+			const AABB bounds = mesh->getWorldBounds();
+
+			// The closest point of the mesh decides, any submesh may be there
+			const vec3 center = bounds.getOrigin() + bounds.getSize() * .5F;
+			const float radius = bounds.getSize().Length() * .5F;
+			const float distance = std::max(vec3::Distance(camera.getPosition(), center) - radius, projection->zNear);
+
+			const vec3& scale = mesh->GetTransform().scale;
+			const float pixelsPerLocalUnit = pixelsPerUnitAtUnitDistance / distance * std::max({ scale.x, scale.y, scale.z });
+
+			std::span<const SubMesh> submeshes = mesh->getModel()->getRawMeshData()->getSubmeshes();
+			for (size_t i = 0; i < submeshes.size(); i++)
+			{
+				const float uvDensity = mesh->getModel()->getRawMeshData()->getSubmeshUVDensity(i);
+				const Material* material = mesh->getMaterial(submeshes[i].materialIndex);
+				if (uvDensity <= 0 || !material) continue;
+
+				// A texture of N texels covers uvDensity * N texels per unit of surface, one texel per pixel is enough
+				const float texels = pixelsPerLocalUnit / uvDensity;
+				for (const auto& [_, texture] : material->getCachedTextures())
+					TextureCache::get().requestResolution(texture, texels);
+			}
+		}
+	}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+namespace pyr
+{
+
+class Camera;
+class MeshComponents;
+
+// Computes the texture resolution each visible material needs on screen and requests it to the TextureCache,
+// which streams the corresponding mips in.
+// The resolution comes from the projected size of the meshes and the texture space their submeshes cover per unit of surface.
+class TextureStreaming
+{
+public:
+
+    TextureStreaming() = delete;
+
+    static void RequestVisibleMips(const MeshComponents& meshes, const Camera& camera, float viewportHeight);
+};
+
+}
@@ -0,0 +1,217 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+
+#include "engine/AsyncTasks.h"
+#include "scene/SceneChangeJournal.h"
+#include "utils/Debug.h"
+#include "world/Actor.h"
+
+namespace pyr
+{
+
+	TransformHierarchy TransformHierarchy::s_singleton;
+
+	TransformHierarchy::~TransformHierarchy()
+	{
+		// Actors destroyed after the hierarchy (other statics) must not reach it
+		for (Actor* actor : m_actors)
+			if (actor) actor->m_hierarchyNode = NO_NODE;
+	}
+
+	void TransformHierarchy::setParent(Actor& child, Actor* parent)
+	{
+		if (!parent && child.m_hierarchyNode == NO_NODE) return;
+
+		const node_t childNode = getOrAddNode(child);
+		const node_t parentNode = parent ? getOrAddNode(*parent) : NO_NODE;
+		if (m_parents[childNode] == parentNode) return;
+
+		for (node_t ancestor = parentNode; ancestor != NO_NODE; ancestor = m_parents[ancestor])
+			PYR_ASSERT(ancestor != childNode, "An actor can't be parented to one of its descendants");
+
+		if (m_parents[childNode] != NO_NODE)
+			m_childCounts[m_parents[childNode]]--;
+		m_parents[childNode] = parentNode;
+		if (parentNode != NO_NODE)
+			m_childCounts[parentNode]++;
+
+		markChanged(childNode);
+		m_bSorted = false;
+	}
+
+	Actor* TransformHierarchy::getParent(const Actor& child) const
+	{
+		if (child.m_hierarchyNode == NO_NODE) return nullptr;
+		const node_t parent = m_parents[child.m_hierarchyNode];
+		return parent != NO_NODE ? m_actors[parent] : nullptr;
+	}
+
+	const mat4& TransformHierarchy::getParentWorldMatrix(node_t node) const
+	{
+		const node_t parent = m_parents[node];
+		return parent != NO_NODE ? m_worldMatrices[parent] : mat4::Identity;
+	}
+
+	void TransformHierarchy::update()
+	{
+		// Smaller levels are not worth waking the workers for
+		constexpr size_t PARALLEL_LEVEL_SIZE = 4096;
+		constexpr size_t GRAIN_SIZE = 1024;
+
+		if (!m_bSorted)
+			sortBreadthFirst();
+
+		for (size_t level = 0; level + 1 < m_levelStarts.size(); level++)
+		{
+			const size_t first = m_levelStarts[level];
+			const size_t last = m_levelStarts[level + 1];
+			if (last - first < PARALLEL_LEVEL_SIZE)
+				updateNodes(first, last);
+			else
+				WorkerPool::get().parallelFor(last - first, GRAIN_SIZE, [this, first](size_t begin, size_t end) { updateNodes(first + begin, first + end); });
+		}
+
+		// The journal is main thread only, changes inherited from a parent are recorded once all levels are done
+		for (node_t node = 0; node < m_actors.size(); node++)
+		{
+			if (m_parents[node] != NO_NODE && m_changed[m_parents[node]])
+				SceneChangeJournal::get().record(m_actors[node]->GetActorID(), SceneChangeJournal::TRANSFORM);
+		}
+	}
+
+	void TransformHierarchy::updateNodes(size_t first, size_t last)
+	{
+		for (size_t node = first; node < last; node++)
+		{
+			const Actor& actor = *m_actors[node];
+			const node_t parent = m_parents[node];
+			const bool bParentChanged = parent != NO_NODE && m_changed[parent];
+			const bool bChanged = bParentChanged || actor.m_transformRevision != m_seenRevisions[node];
+			m_changed[node] = bChanged;
+			if (!bChanged) continue;
+
+			if (bParentChanged)
+				actor.m_bWorldMatrixDirty = true;
+			m_seenRevisions[node] = actor.m_transformRevision;
+			m_worldMatrices[node] = actor.GetWorldMatrix();
+		}
+	}
+
+	TransformHierarchy::node_t TransformHierarchy::getOrAddNode(Actor& actor)
+	{
+		if (actor.m_hierarchyNode != NO_NODE) return actor.m_hierarchyNode;
+
+		const node_t node = static_cast<node_t>(m_actors.size());
+		m_actors.push_back(&actor);
+		m_parents.push_back(NO_NODE);
+		m_childCounts.push_back(0);
+		m_worldMatrices.push_back(actor.GetWorldMatrix());
+		m_seenRevisions.push_back(actor.m_transformRevision);
+		actor.m_hierarchyNode = node;
+		m_bSorted = false;
+		return node;
+	}
+
+	void TransformHierarchy::removeNode(node_t node)
+	{
+		Actor* actor = m_actors[node];
+		actor->m_hierarchyNode = NO_NODE;
+		actor->m_bWorldMatrixDirty = true;
+
+		if (m_parents[node] != NO_NODE)
+			m_childCounts[m_parents[node]]--;
+
+		// Leaves are the common case, the children of a removed node are only searched for when there are some
+		if (m_childCounts[node] > 0)
+		{
+			for (node_t child = 0; child < m_actors.size(); child++)
+			{
+				if (m_parents[child] != node) continue;
+				m_parents[child] = NO_NODE;
+				markChanged(child);
+			}
+		}
+
+		m_actors[node] = nullptr;
+		m_parents[node] = NO_NODE;
+		m_childCounts[node] = 0;
+		m_bSorted = false;
+	}
+
+	void TransformHierarchy::relocateNode(node_t node, Actor& actor)
+	{
+		m_actors[node] = &actor;
+	}
+
+	void TransformHierarchy::markChanged(node_t node)
+	{
+		Actor& actor = *m_actors[node];
+		actor.m_bWorldMatrixDirty = true;
+		m_seenRevisions[node] = actor.m_transformRevision - 1;
+		SceneChangeJournal::get().record(actor.GetActorID(), SceneChangeJournal::TRANSFORM);
+	}
+
+	void TransformHierarchy::sortBreadthFirst()
+	{
+		constexpr uint32_t UNKNOWN_DEPTH = ~0u;
+		const size_t nodeCount = m_actors.size();
+
+		// Nodes are not ordered yet, each one walks up to the first ancestor of known depth
+		std::vector<uint32_t> depths(nodeCount, UNKNOWN_DEPTH);
+		std::vector<node_t> unknownAncestors;
+		uint32_t maxDepth = 0;
+		for (node_t node = 0; node < nodeCount; node++)
+		{
+			if (!m_actors[node] || depths[node] != UNKNOWN_DEPTH) continue;
+
+			node_t ancestor = node;
+			for (; ancestor != NO_NODE && depths[ancestor] == UNKNOWN_DEPTH; ancestor = m_parents[ancestor])
+				unknownAncestors.push_back(ancestor);
+			uint32_t depth = ancestor == NO_NODE ? 0 : depths[ancestor] + 1;
+			for (auto it = unknownAncestors.rbegin(); it != unknownAncestors.rend(); ++it)
+				depths[*it] = depth++;
+			unknownAncestors.clear();
+			maxDepth = std::max(maxDepth, depths[node]);
+		}
+
+		// Counting sort on the depth, nodes of a level keep their relative order
+		m_levelStarts.assign(maxDepth + 2, 0);
+		for (node_t node = 0; node < nodeCount; node++)
+			if (m_actors[node]) m_levelStarts[depths[node] + 1]++;
+		for (size_t level = 1; level < m_levelStarts.size(); level++)
+			m_levelStarts[level] += m_levelStarts[level - 1];
+
+		std::vector<size_t> nextInLevel(m_levelStarts.begin(), m_levelStarts.end() - 1);
+		std::vector<node_t> sortedNodes(nodeCount, NO_NODE);
+		for (node_t node = 0; node < nodeCount; node++)
+			if (m_actors[node]) sortedNodes[node] = static_cast<node_t>(nextInLevel[depths[node]]++);
+
+		const size_t liveCount = m_levelStarts.back();
+		std::vector<Actor*> actors(liveCount);
+		std::vector<node_t> parents(liveCount);
+		std::vector<uint32_t> childCounts(liveCount);
+		std::vector<mat4> worldMatrices(liveCount);
+		std::vector<uint32_t> seenRevisions(liveCount);
+		for (node_t node = 0; node < nodeCount; node++)
+		{
+			if (!m_actors[node]) continue;
+			const node_t sorted = sortedNodes[node];
+			actors[sorted] = m_actors[node];
+			parents[sorted] = m_parents[node] != NO_NODE ? sortedNodes[m_parents[node]] : NO_NODE;
+			childCounts[sorted] = m_childCounts[node];
+			worldMatrices[sorted] = m_worldMatrices[node];
+			seenRevisions[sorted] = m_seenRevisions[node];
+			actors[sorted]->m_hierarchyNode = sorted;
+		}
+
+		m_actors = std::move(actors);
+		m_parents = std::move(parents);
+		m_childCounts = std::move(childCounts);
+		m_worldMatrices = std::move(worldMatrices);
+		m_seenRevisions = std::move(seenRevisions);
+		m_changed.assign(liveCount, 0);
+		m_bSorted = true;
+	}
+
+}
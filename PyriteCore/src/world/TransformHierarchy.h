@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utils/math.h"
+
+namespace pyr
+{
+
+class Actor;
+
+// Parent/child links between actors, an actor's Transform is relative to its parent's world matrix.
+// Only actors that have a parent or children are stored, in arrays sorted breadth first so that update() goes through them
+// level by level, each level reading the world matrices the previous one wrote. Large levels are split across the workers.
+//
+// Actors keep their place when they are moved (when a vector of actors grows...), they leave the hierarchy when destroyed
+// and their children become roots. A copy of an actor has no parent.
+// Main thread only.
+class TransformHierarchy
+{
+public:
+
+    using node_t = uint32_t;
+    static constexpr node_t NO_NODE = ~node_t{ 0 };
+
+    static TransformHierarchy& get() { return s_singleton; }
+
+    ~TransformHierarchy();
+
+    // A null parent detaches the child. Cycles are not allowed.
+    void setParent(Actor& child, Actor* parent);
+    Actor* getParent(const Actor& child) const;
+
+    // Propagates transform changes from the roots to the leaves, called by the engine between the scene update and render.
+    // Children whose world matrix changed through a parent are recorded as transform changes in the SceneChangeJournal.
+    void update();
+
+    // As of the last update, identity for roots
+    const mat4& getParentWorldMatrix(node_t node) const;
+
+private:
+
+    friend class Actor;
+
+    TransformHierarchy() = default;
+    TransformHierarchy(const TransformHierarchy&) = delete;
+    TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+    node_t getOrAddNode(Actor& actor);
+    void removeNode(node_t node);
+    void relocateNode(node_t node, Actor& actor);
+    void markChanged(node_t node);
+    void sortBreadthFirst();
+    void updateNodes(size_t first, size_t last);
+
+private:
+
+    // Indexed by node, removed nodes keep a null actor until the next sort
+    std::vector<Actor*> m_actors;
+    std::vector<node_t> m_parents;
+    std::vector<uint32_t> m_childCounts;
+    std::vector<mat4> m_worldMatrices;
+    std::vector<uint32_t> m_seenRevisions; // Actor::m_transformRevision as of the last update
+    std::vector<uint8_t> m_changed;        // during update, not a vector<bool> as workers write neighbouring entries
+
+    std::vector<size_t> m_levelStarts;     // first node of each depth, then the node count
+    bool m_bSorted = true;
+
+    static TransformHierarchy s_singleton;
+};
+
+}
@@ -47,6 +47,8 @@ cbuffer ActorMaterials
     float metallic;     // specular exponent
     float Ni;           // optical density 
     float d;            // transparency < todo 
+    uint metalnessChannel; // cooked maps hold the mask in red, maps loaded as they are keep it in its source channel
+    uint roughnessChannel;
 };
 
 cbuffer lightsBuffer
@@ -175,9 +177,9 @@ float4 GGXPixelShader(VertexOut vsIn, float4 vpos : SV_Position) : SV_Target
     pixelNormal = normalize(pixelNormal);
     
     float computed_metallic = metallic; 
-    computed_metallic *= sampleFromTexture(mat_metalness, vsIn.uv).b;
+    computed_metallic *= sampleFromTexture(mat_metalness, vsIn.uv)[metalnessChannel];
     float computed_roughness = roughness;
-    computed_roughness *= sampleFromTexture(mat_roughness, vsIn.uv).g;
+    computed_roughness *= sampleFromTexture(mat_roughness, vsIn.uv)[roughnessChannel];
     
     float3 R = reflect(-V, pixelNormal);
     
@@ -201,7 +203,7 @@ float4 GGXPixelShader(VertexOut vsIn, float4 vpos : SV_Position) : SV_Target
         {
             if (bShouldCastShadows)
             {
-                shadow_attenuation = 1.f - getShadowFactor_2D_Ortho(vsIn.worldpos.xyz, vsIn.norm.xyz, light.lightmap_index, CreateViewProjectionMatrixForLight_Ortho(light));
+                shadow_attenuation = 1.f - getShadowFactor_Cascaded(vsIn.worldpos.xyz, vsIn.norm.xyz, light.lightmap_index, light.shadowCascadeCount);
             }
             
             L = normalize(-light.direction);
@@ -213,7 +215,7 @@ float4 GGXPixelShader(VertexOut vsIn, float4 vpos : SV_Position) : SV_Target
 
             if (bShouldCastShadows)
             {
-                shadow_attenuation = 1.f - getShadowFactor_3D(vsIn.worldpos.xyz, vsIn.norm.xyz, light.lightmap_index - 16, light.position.xyz);
+                shadow_attenuation = 1.f - getShadowFactor_3D(vsIn.worldpos.xyz, vsIn.norm.xyz, light.lightmap_index, light.position.xyz);
             }
             
             float LightToPixel = light.position.xyz - vsIn.worldpos.xyz;
@@ -229,7 +231,7 @@ float4 GGXPixelShader(VertexOut vsIn, float4 vpos : SV_Position) : SV_Target
             {
                 shadow_attenuation = 1.f - getShadowFactor_2D_Perspective(
                     vsIn.worldpos.xyz, vsIn.norm.xyz,
-                    light.lightmap_index, CreateViewProjectionMatrixForLight_Perspective(light), light.position.xyz);
+                    light.lightmap_index, light.shadowMapRect, CreateViewProjectionMatrixForLight_Perspective(light), light.position.xyz);
             }
             
             L = normalize(light.position.xyz - vsIn.worldpos.xyz);
@@ -95,15 +95,15 @@ namespace pye
             m_RDG.addPass(&m_billboardsPass);
             m_RDG.addPass(&m_editorHUD);
             m_RDG.addPass(&m_picker);
-            m_RDG.getResourcesManager().addProduced(&m_depthPrePass, "depthBuffer");
-            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture_blurred");
-            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture");
-            m_RDG.getResourcesManager().addRequirement(&m_SSAOPass, "depthBuffer");
-
-            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_SSAOPass);
-            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_forwardPass);
-            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_picker);
-            m_RDG.getResourcesManager().linkResource(&m_SSAOPass, "ssaoTexture_blurred", &m_forwardPass);
+            m_RDG.getResourcesManager().addProduced(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer);
+            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred);
+            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTexture);
+            m_RDG.getResourcesManager().addRequirement(&m_SSAOPass, pyr::BuiltinResources::DepthBuffer);
+
+            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_SSAOPass);
+            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_forwardPass);
+            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_picker);
+            m_RDG.getResourcesManager().linkResource(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred, &m_forwardPass);
             bool bIsGraphValid = m_RDG.getResourcesManager().checkResourcesValidity();
 #pragma endregion RDG
 
@@ -114,17 +114,17 @@ namespace pye
                 sceneMeshes.back().GetTransform().scale = { 10,10,10 };
             }
 
-            SceneActors.lights.Points.push_back({});
-            SceneActors.lights.Spots.push_back({});
-            SceneActors.lights.Points.back().GetTransform().position = { 0,-5.F,0 };
-            SceneActors.lights.Spots.back().GetTransform().position = { 0,14.F,28 };
-            SceneActors.lights.Spots.back().GetTransform().rotation = { 0,0, -1.0f };
-            SceneActors.lights.Spots.back().strength = 26.f;
-            SceneActors.lights.Spots.back().shadowMode = pyr::DynamicShadow;
+            pyr::PointLight& point = SceneActors.lights.AddLight(pyr::PointLight{});
+            point.GetTransform().position = { 0,-5.F,0 };
+            pyr::SpotLight& spot = SceneActors.lights.AddLight(pyr::SpotLight{});
+            spot.GetTransform().position = { 0,14.F,28 };
+            spot.GetTransform().rotation = { 0,0, -1.0f };
+            spot.strength = 26.f;
+            spot.shadowMode = pyr::DynamicShadow;
 
             for (const auto& m : sceneMeshes)
             {
-                SceneActors.meshes.push_back(&m); // < this assumes that the scene manager will eventually clear them at the end of the frame, which is a stupid idea. I hate me
+                SceneActors.addMesh(&m); // < this assumes that the scene manager will eventually clear them at the end of the frame, which is a stupid idea. I hate me
             }
         }
 
@@ -13,6 +13,7 @@
 #include "world/camera.h"
 #include "world/Mesh/MeshImporter.h"
 #include "display/GraphicalResource.h"
+#include "display/ImageDecoder.h"
 #include "display/RenderProfiles.h"
 #include "world/RayCasting.h"
 #include "RenderDoc/renderdoc_app.h"
@@ -67,6 +68,11 @@ namespace pye
         pyr::Effect* m_specularBRDF;
         
         pyr::FreecamController m_camController;
+
+        // Runtime recaptures, spread over several frames
+        static constexpr uint32_t RUNTIME_PREFILTER_MIPS = 5;
+        pyr::CubemapCapture m_irradianceCapture;
+        pyr::CubemapCapture m_prefilterCapture;
         
         float m_currentPrefilterRougness = 0.0F;
         bool bRuntimeFramebufferIrradianceCapture = false;
@@ -95,6 +101,49 @@ namespace pye
 
             m_camera.setProjection(pyr::PerspectiveProjection{ .fovy = 3.141592f/2.f, .aspect = 1.F} ); // this gives an FOVx of 90 in radians...
             m_camController.setCamera(&m_camera);
+
+            m_irradianceCapture = pyr::CubemapCapture{ 32, 1, [this](uint32_t face, uint32_t) {
+                lookAtFace(face);
+                m_irradiancePrecompute->bindConstantBuffer("CameraBuffer", pcameraBuffer);
+                m_irradiancePrecompute->bindCubemap(*OutputCubemaps.Cubemap, "cubemapHDR");
+                m_irradiancePrecompute->bind();
+                pyr::Engine::d3dcontext().Draw(36, 0);
+                m_irradiancePrecompute->unbindResources();
+            }};
+
+            m_prefilterCapture = pyr::CubemapCapture{ 256, RUNTIME_PREFILTER_MIPS, [this](uint32_t face, uint32_t mipLevel) {
+                lookAtFace(face);
+                m_specularPreFilter->bindConstantBuffer("CameraBuffer", pcameraBuffer);
+                m_specularPreFilter->setUniform<float>("roughness", static_cast<float>(mipLevel) / static_cast<float>(RUNTIME_PREFILTER_MIPS));
+                m_specularPreFilter->bindCubemap(*OutputCubemaps.Cubemap, "environmentMap");
+                m_specularPreFilter->bind();
+                pyr::Engine::d3dcontext().Draw(36, 0);
+                m_specularPreFilter->unbindResources();
+            }};
+        }
+
+        void lookAtFace(uint32_t face)
+        {
+            m_camera.lookAt(lookAtDirs[face]);
+            if (face == 2) m_camera.rotate(0.f, 3.14159f, 0.f);
+            if (face == 3) m_camera.rotate(0.f, 3.14159f, 0.f);
+            pcameraBuffer->setData(pyr::CameraBuffer::data_t{
+                .mvp = m_camera.getViewProjectionMatrix(),
+                .pos = m_camera.getPosition()
+            });
+        }
+
+        std::optional<pyr::Cubemap> tickCapture(pyr::CubemapCapture& capture)
+        {
+            // The faces are rendered with the scene camera, give it back to the user afterward
+            const pyr::Camera userCamera = m_camera;
+            std::optional<pyr::Cubemap> cubemap = capture.tick();
+            m_camera = userCamera;
+            pcameraBuffer->setData(pyr::CameraBuffer::data_t{
+                .mvp = m_camera.getViewProjectionMatrix(),
+                .pos = m_camera.getPosition()
+            });
+            return cubemap;
         }
 
         void SetHDRBackground(const std::filesystem::path& path)
@@ -230,11 +279,6 @@ namespace pye
         void render() override
 
         {
-            // -- Debug runtime values, should not be used if you are not in the scene
-            constexpr size_t mipCount = 5;
-            uint32_t baseWidth = 256;
-            static std::array<pyr::Texture, mipCount * 6> prefiltered;
-
             pyr::Engine::d3dcontext().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
             pyr::RenderProfiles::pushRasterProfile(pyr::RasterizerProfile::NOCULL_RASTERIZER);
             pyr::RenderProfiles::pushDepthProfile(pyr::DepthProfile::TESTWRITE_DEPTH);
@@ -273,73 +317,37 @@ namespace pye
 
                     if (bRuntimeFramebufferIrradianceCapture)
                     {
-                        for (int i = 0; i < 6; i++)
+                        if (!m_irradianceCapture.isRunning()) m_irradianceCapture.restart();
+                        if (std::optional<pyr::Cubemap> irradiance = tickCapture(m_irradianceCapture))
                         {
-                            m_camera.lookAt(lookAtDirs[i]);
-                            if (i == 2) m_camera.rotate(0, 3.14159f, 0);
-                            if (i == 3) m_camera.rotate(0, 3.14159f, 0);
-                            update(0.0F);
-                            framebuffers[i] = pyr::FrameBuffer{ 32, 32, pyr::FrameBuffer::COLOR_0 };
-                            framebuffers[i].bind();
-                            m_irradiancePrecompute->bind();
-                            m_irradiancePrecompute->bindConstantBuffer("CameraBuffer", pcameraBuffer);
-                            m_irradiancePrecompute->bindCubemap(*OutputCubemaps.Cubemap, "cubemapHDR");
-                            pyr::Engine::d3dcontext().Draw(36, 0);
-                            framebuffers[i].unbind();
+                            OutputCubemaps.Irradiance = std::make_shared<pyr::Cubemap>(*irradiance);
+                            bRuntimeFramebufferIrradianceCapture = false;
+                            renderMode = SKYBOX;
                         }
-                        bRuntimeFramebufferIrradianceCapture = false;
-                        renderMode = SKYBOX;
                     }
-                    else {
 
-                        m_irradiancePrecompute->bindConstantBuffer("CameraBuffer", pcameraBuffer);
-                        m_irradiancePrecompute->bindCubemap(*OutputCubemaps.Cubemap, "cubemapHDR");
-                        m_irradiancePrecompute->bind();
-                    }
+                    m_irradiancePrecompute->bindConstantBuffer("CameraBuffer", pcameraBuffer);
+                    m_irradiancePrecompute->bindCubemap(*OutputCubemaps.Cubemap, "cubemapHDR");
+                    m_irradiancePrecompute->bind();
                     break;
                 }
 
                 case SPECULAR:
                 {
+                    if (!OutputCubemaps.Cubemap) break;
 
-                    if (bRuntimeFramebufferPrefilterCapture && OutputCubemaps.Cubemap)
+                    // Keeps recapturing while enabled, a few faces per frame
+                    if (bRuntimeFramebufferPrefilterCapture)
                     {
-                        for (size_t mipLevel = 0; mipLevel < mipCount; mipLevel++)
-                        {
-                            m_currentPrefilterRougness = (float)mipLevel / (float)mipCount;
-                            uint32_t framebufferWidth = baseWidth / static_cast<uint32_t>(std::pow(2, mipLevel));
-                            for (int i = 0; i < 6; i++)
-                            {
-                                m_camera.lookAt(lookAtDirs[i]);
-                                if (i == 2) m_camera.rotate(0, 3.14159f, 0);
-                                if (i == 3) m_camera.rotate(0, 3.14159f, 0);
-                                pcameraBuffer->setData(pyr::CameraBuffer::data_t{
-                                    .mvp = m_camera.getViewProjectionMatrix(),
-                                    .pos = m_camera.getPosition()
-                                    });
-                                framebuffers[i] = pyr::FrameBuffer{ framebufferWidth, framebufferWidth, pyr::FrameBuffer::COLOR_0 };
-                                framebuffers[i].bind();
-                                
-                                m_specularPreFilter->bindConstantBuffer("CameraBuffer", pcameraBuffer);
-                                m_specularPreFilter->setUniform<float>("roughness", m_currentPrefilterRougness);
-                                m_specularPreFilter->bindCubemap(*OutputCubemaps.Cubemap, "environmentMap");
-                                m_specularPreFilter->bind();
-                                pyr::Engine::d3dcontext().Draw(36, 0);
-
-                                framebuffers[i].unbind();
-                                prefiltered[mipLevel * 6 + i] = framebuffers[i].getTargetAsTexture(pyr::FrameBuffer::COLOR_0);
-
-                            }
-                        }
-                    }
-                    else
-                    {
-                        if (!OutputCubemaps.Cubemap) break;
-                        m_specularPreFilter->bindConstantBuffer("CameraBuffer", pcameraBuffer);
-                        m_specularPreFilter->setUniform<float>("roughness", m_currentPrefilterRougness);
-                        m_specularPreFilter->bindCubemap(*OutputCubemaps.Cubemap, "environmentMap");
-                        m_specularPreFilter->bind();
+                        if (!m_prefilterCapture.isRunning()) m_prefilterCapture.restart();
+                        if (std::optional<pyr::Cubemap> prefiltered = tickCapture(m_prefilterCapture))
+                            OutputCubemaps.SpecularFiltered = std::make_shared<pyr::Cubemap>(*prefiltered);
                     }
+
+                    m_specularPreFilter->bindConstantBuffer("CameraBuffer", pcameraBuffer);
+                    m_specularPreFilter->setUniform<float>("roughness", m_currentPrefilterRougness);
+                    m_specularPreFilter->bindCubemap(*OutputCubemaps.Cubemap, "environmentMap");
+                    m_specularPreFilter->bind();
                     break;
                 }
                 default:
@@ -358,27 +366,6 @@ namespace pye
             {
                 ComputeIBLCubemaps();
             }
-            if (bRuntimeFramebufferIrradianceCapture && renderMode == RenderMode::IRRADIANCE && ImGui::Button("Recapture irradiance cubemap"))
-            {
-                std::array<pyr::Texture, 6> textures2 = {
-                    framebuffers[0].getTargetAsTexture(pyr::FrameBuffer::COLOR_0),
-                    framebuffers[1].getTargetAsTexture(pyr::FrameBuffer::COLOR_0),
-                    framebuffers[2].getTargetAsTexture(pyr::FrameBuffer::COLOR_0),
-                    framebuffers[3].getTargetAsTexture(pyr::FrameBuffer::COLOR_0),
-                    framebuffers[4].getTargetAsTexture(pyr::FrameBuffer::COLOR_0),
-                    framebuffers[5].getTargetAsTexture(pyr::FrameBuffer::COLOR_0)
-                };
-                OutputCubemaps.Irradiance = std::make_unique<pyr::Cubemap>(pyr::CubemapBuilder::MakeCubemapFromTextures(textures2));
-                
-                bRuntimeFramebufferIrradianceCapture = false;
-
-            }
-
-            if (bRuntimeFramebufferPrefilterCapture && renderMode == RenderMode::SPECULAR)
-            {
-                OutputCubemaps.SpecularFiltered = std::make_shared<pyr::Cubemap>(pyr::CubemapBuilder::MakeCubemapFromTexturesLOD<mipCount>(prefiltered));
-            }
-
             ImGui::Checkbox("Skybox render using irradiance compute :", &bRenderIrradianceMap);
             ImGui::Checkbox("Prefilter runtime", &bRuntimeFramebufferPrefilterCapture);
             if (ImGui::Button("ReCompute irradiance cubemapat runtime :"))
@@ -392,6 +379,11 @@ namespace pye
             {
                 renderMode = static_cast<RenderMode>(Selecteditem);
             }
+            if (ImGui::Button("Benchmark HDR decode"))
+            {
+                // Results are logged, stbi_loadf against the parallel decoder
+                pyr::ImageDecoder::BenchmarkHDR(DefaultHDRMap);
+            }
 
             ImGui::End();
 
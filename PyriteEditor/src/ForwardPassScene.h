@@ -67,14 +67,14 @@ namespace pye
                 sceneMeshes.back().GetTransform().scale = { 30,30, 30 };
             }
 
-            m_RDG.getResourcesManager().addProduced(&m_depthPrePass, "depthBuffer");
-            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture_blurred");
-            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture");
+            m_RDG.getResourcesManager().addProduced(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer);
+            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred);
+            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTexture);
 
-            m_RDG.getResourcesManager().addRequirement(&m_SSAOPass, "depthBuffer");
+            m_RDG.getResourcesManager().addRequirement(&m_SSAOPass, pyr::BuiltinResources::DepthBuffer);
 
-            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_SSAOPass);
-            m_RDG.getResourcesManager().linkResource(&m_SSAOPass, "ssaoTexture_blurred", &m_forwardPass);
+            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_SSAOPass);
+            m_RDG.getResourcesManager().linkResource(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred, &m_forwardPass);
 
             bool bIsGraphValid = m_RDG.getResourcesManager().checkResourcesValidity();
 
@@ -84,7 +84,7 @@ namespace pye
 
             for (const auto& mesh : sceneMeshes)
             {
-                SceneActors.meshes.push_back(&mesh);
+                SceneActors.addMesh(&mesh);
             }
         }
 
@@ -102,7 +102,7 @@ namespace pye
                 coefs.Roughness = std::clamp((i / gridSize) / (gridSize - 1.f), 0.05f, 1.f);
                 auto mat = pyr::Material::MakeRegisteredMaterial({}, coefs, m_ggxShader, std::format("Material_%d",i));
                 m_balls[i].overrideSubmeshMaterial(0, mat);
-                SceneActors.meshes.push_back(&m_balls[i]);
+                SceneActors.addMesh(&m_balls[i]);
             }
 #pragma endregion BALLS
 
@@ -118,14 +118,14 @@ namespace pye
             m_RDG.addPass(&m_billboardsPass);
             m_RDG.addPass(&m_editorHUD);
             m_RDG.addPass(&m_picker);
-            m_RDG.getResourcesManager().addProduced(&m_depthPrePass, "depthBuffer");
-            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture_blurred");
-            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture");
-            m_RDG.getResourcesManager().addRequirement(&m_SSAOPass, "depthBuffer");
-            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_SSAOPass);
-            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_forwardPass);
-            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_picker);
-            m_RDG.getResourcesManager().linkResource(&m_SSAOPass, "ssaoTexture_blurred", &m_forwardPass);
+            m_RDG.getResourcesManager().addProduced(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer);
+            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred);
+            m_RDG.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTexture);
+            m_RDG.getResourcesManager().addRequirement(&m_SSAOPass, pyr::BuiltinResources::DepthBuffer);
+            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_SSAOPass);
+            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_forwardPass);
+            m_RDG.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_picker);
+            m_RDG.getResourcesManager().linkResource(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred, &m_forwardPass);
             bool bIsGraphValid = m_RDG.getResourcesManager().checkResourcesValidity();
 #pragma endregion RDG
             auto& device = pyr::Engine::device();
@@ -135,8 +135,20 @@ namespace pye
 
             for (int i = 0; i < m_balls.size(); i++)
             {
-                SceneActors.meshes.push_back(&m_balls[i]);
+                SceneActors.addMesh(&m_balls[i]);
             }
+        }
+
+        ~MaterialScene() override
+        {
+            // The ball materials were registered for this scene only
+            for (const pyr::StaticMesh& ball : m_balls)
+                if (const pyr::Material* material = ball.getMaterial(0))
+                    pyr::MaterialBank::UnregisterMaterial(material->getBankHandle());
+        }
+
+        void onActivated() override
+        {
             pye::Editor::Get().UpdateRegisteredActors(SceneActors);
         }
 
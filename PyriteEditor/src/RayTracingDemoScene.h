@@ -57,13 +57,13 @@ public:
     //cubeInstance.setBaseMaterial(std::make_shared<pyr::Material>(m_baseEffect));
     Transform& cubeTransform = cubeInstance.GetTransform();
     cubeTransform = Transform{ vec3(1,2,3), vec3(1,.5f,2.f), quat::CreateFromAxisAngle(mathf::normalize(vec3(1,2,3)), 1.f) };
-    SceneActors.meshes.push_back(&cubeInstance);
+    SceneActors.addMesh(&cubeInstance);
 
     // Setup this scene's rendergraph
     m_RDG.addPass(&m_depthPrePass);
     m_RDG.addPass(&m_forwardPass);
-    m_RDG.getResourcesManager().addProduced(&m_depthPrePass, "depthBuffer");
-    m_RDG.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_forwardPass);
+    m_RDG.getResourcesManager().addProduced(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer);
+    m_RDG.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_forwardPass);
     m_RDG.getResourcesManager().checkResourcesValidity();
 
     // Setup the camera
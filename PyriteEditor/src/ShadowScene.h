@@ -51,14 +51,14 @@ namespace pye
             SceneRenderGraph.addPass(&m_depthPrePass);
             SceneRenderGraph.addPass(&m_SSAOPass);
             SceneRenderGraph.addPass(&m_forwardPass);
-            SceneRenderGraph.getResourcesManager().addProduced(&m_depthPrePass, "depthBuffer");
-            SceneRenderGraph.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture_blurred");
-            SceneRenderGraph.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture");
-            SceneRenderGraph.getResourcesManager().addRequirement(&m_SSAOPass, "depthBuffer");
-
-            SceneRenderGraph.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_SSAOPass);
-            SceneRenderGraph.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_forwardPass);
-            SceneRenderGraph.getResourcesManager().linkResource(&m_SSAOPass, "ssaoTexture_blurred", &m_forwardPass);
+            SceneRenderGraph.getResourcesManager().addProduced(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer);
+            SceneRenderGraph.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred);
+            SceneRenderGraph.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTexture);
+            SceneRenderGraph.getResourcesManager().addRequirement(&m_SSAOPass, pyr::BuiltinResources::DepthBuffer);
+
+            SceneRenderGraph.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_SSAOPass);
+            SceneRenderGraph.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_forwardPass);
+            SceneRenderGraph.getResourcesManager().linkResource(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred, &m_forwardPass);
             bool bIsGraphValid = SceneRenderGraph.getResourcesManager().checkResourcesValidity();
 #pragma endregion RDG
             for (const auto& model : m_catModels)
@@ -76,26 +76,29 @@ namespace pye
 
             for (const auto& m : sceneMeshes)
             {
-                SceneActors.meshes.push_back(&m);
+                SceneActors.addMesh(&m);
             }
-            SceneActors.lights.Spots.push_back({});
-            SceneActors.lights.Spots.back().GetTransform().position = { -2.3f,3.39f,-0.3f };
-            SceneActors.lights.Spots.back().GetTransform().rotation = { 0.69f, -0.724f };
-            SceneActors.lights.Spots.back().strength = 300.f;
-            SceneActors.lights.Spots.back().insideAngle = 0.650f;
-            SceneActors.lights.Spots.back().outsideAngle = 0.f;
-            SceneActors.lights.Spots.back().isOn = false;
-
-            SceneActors.lights.Points.push_back({});
-            SceneActors.lights.Points.back().GetTransform().position = { -2.3f,3.39f,-0.3f };
-            SceneActors.lights.Points.back().specularFactor = 20;
-            SceneActors.lights.Points.back().isOn = true;
-            SceneActors.lights.Points.back().shadowMode = pyr::DynamicShadow;
+            pyr::SpotLight& spot = SceneActors.lights.AddLight(pyr::SpotLight{});
+            spot.GetTransform().position = { -2.3f,3.39f,-0.3f };
+            spot.GetTransform().rotation = { 0.69f, -0.724f };
+            spot.strength = 300.f;
+            spot.insideAngle = 0.650f;
+            spot.outsideAngle = 0.f;
+            spot.isOn = false;
+
+            pyr::PointLight& point = SceneActors.lights.AddLight(pyr::PointLight{});
+            point.GetTransform().position = { -2.3f,3.39f,-0.3f };
+            point.specularFactor = 20;
+            point.isOn = true;
+            point.shadowMode = pyr::DynamicShadow;
             
             m_camera.setProjection(pyr::PerspectiveProjection{});
             m_camera.setPosition({ -4, 3 ,8 });
             m_camera.lookAt({ 0,0,0 });
+        }
 
+        void onActivated() override
+        {
             pye::Editor::Get().UpdateRegisteredActors(SceneActors);
             pye::EditorSceneInjector::InjectEditorToolsToScene(*this);
         }
@@ -10,7 +10,11 @@
 #include "scene/Scene.h"
 #include "world/Tools/SceneRenderTools.h"
 #include "display/DebugDraw.h"
+#include "display/TextureCache.h"
+#include "scene/AssetLoader.h"
+#include "scene/SceneManager.h"
 #include <editor/EditorSceneInjector.h>
+#include <exception>
 
 namespace pye
 {
@@ -20,7 +24,8 @@ namespace pye
 
         pyr::GraphicalResourceRegistry m_registry;
 
-        std::vector<std::shared_ptr<pyr::Model>> m_sponzaModels = pyr::MeshImporter::ImportMeshesFromFile(L"res/meshes/main1_sponza/NewSponza_Main_glTF_003.gltf");
+        // Replaced once loaded, the placeholder cube is what remains if loading fails
+        std::vector<std::shared_ptr<pyr::Model>> m_sponzaModels = { pyr::AssetLoader::GetPlaceholderModel() };
 
         pyr::BuiltinPasses::ForwardPass     m_forwardPass;
         pyr::BuiltinPasses::SSAOPass        m_SSAOPass;
@@ -36,6 +41,8 @@ namespace pye
 
         std::vector<pyr::StaticMesh> sceneMeshes;
 
+        pyr::AssetLoader m_assets{ m_registry }; // last, pending loads reference the members above
+
     public:
 
         SponzaScene()
@@ -44,32 +51,70 @@ namespace pye
             SceneRenderGraph.addPass(&m_depthPrePass);
             SceneRenderGraph.addPass(&m_SSAOPass);
             SceneRenderGraph.addPass(&m_forwardPass);
-            SceneRenderGraph.getResourcesManager().addProduced(&m_depthPrePass, "depthBuffer");
-            SceneRenderGraph.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture_blurred");
-            SceneRenderGraph.getResourcesManager().addProduced(&m_SSAOPass, "ssaoTexture");
-            SceneRenderGraph.getResourcesManager().addRequirement(&m_SSAOPass, "depthBuffer");
-
-            SceneRenderGraph.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_SSAOPass);
-            SceneRenderGraph.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_forwardPass);
-            SceneRenderGraph.getResourcesManager().linkResource(&m_SSAOPass, "ssaoTexture_blurred", &m_forwardPass);
+            SceneRenderGraph.getResourcesManager().addProduced(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer);
+            SceneRenderGraph.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred);
+            SceneRenderGraph.getResourcesManager().addProduced(&m_SSAOPass, pyr::BuiltinResources::SSAOTexture);
+            SceneRenderGraph.getResourcesManager().addRequirement(&m_SSAOPass, pyr::BuiltinResources::DepthBuffer);
+
+            SceneRenderGraph.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_SSAOPass);
+            SceneRenderGraph.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_forwardPass);
+            SceneRenderGraph.getResourcesManager().linkResource(&m_SSAOPass, pyr::BuiltinResources::SSAOTextureBlurred, &m_forwardPass);
             bool bIsGraphValid = SceneRenderGraph.getResourcesManager().checkResourcesValidity();
 #pragma endregion RDG
+            m_camera.setProjection(pyr::PerspectiveProjection{});
+
+            createSceneMeshes();
+
+            m_assets.run(loadSponza());
+        }
+
+        void onActivated() override
+        {
+            pye::EditorSceneInjector::InjectEditorToolsToScene(*this);
+            pye::Editor::Get().UpdateRegisteredActors(SceneActors);
+        }
+
+        pyr::Task<void> loadSponza()
+        {
+            std::exception_ptr failure;
+            try
+            {
+                m_sponzaModels = co_await m_assets.loadModel(L"res/meshes/main1_sponza/NewSponza_Main_glTF_003.gltf");
+                createSceneMeshes();
+                // Sponza materials share many of their maps, see how much loading them once saved
+                pyr::TextureCache::get().logStats();
+            }
+            catch (...)
+            {
+                failure = std::current_exception();
+            }
+
+            // When the scene was activated before the end of the load, the editor registered the placeholders
+            if (pyr::SceneManager::getActiveScene() == this)
+                pye::Editor::Get().UpdateRegisteredActors(SceneActors);
+            if (failure)
+                std::rethrow_exception(failure); // reported by the AssetLoader
+        }
+
+        void createSceneMeshes()
+        {
+            sceneMeshes.clear();
             for (const auto& model : m_sponzaModels)
             {
                 sceneMeshes.push_back(pyr::StaticMesh{ model });
                 sceneMeshes.back().GetTransform().scale = { 10,10,10 };
             }
 
+            SceneActors.clearMeshes();
             for (const auto& m : sceneMeshes)
             {
-                SceneActors.meshes.push_back(&m);
+                SceneActors.addMesh(&m);
             }
-            m_camera.setProjection(pyr::PerspectiveProjection{});
-
-            pye::Editor::Get().UpdateRegisteredActors(SceneActors);
-            pye::EditorSceneInjector::InjectEditorToolsToScene(*this);
         }
 
+        // The SceneManager keeps the previous scene active until the models are loaded
+        float getLoadingProgress() override { return m_assets.getProgress(); }
+
         void update(float delta) override
         {
 
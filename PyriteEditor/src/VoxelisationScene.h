@@ -210,7 +210,7 @@ public:
 
     voxeliseMesh();
     updateCubesToMatchVoxelGrid();
-    SceneActors.meshes.push_back(&m_mesh);
+    SceneActors.addMesh(&m_mesh);
   }
 
   void update(float delta) override
@@ -274,8 +274,8 @@ public:
     static bool showMesh = true;
     ImGui::Checkbox("Autogen", &autogen);
     if (ImGui::Checkbox("ShowMesh", &showMesh)) {
-        SceneActors.meshes.clear();
-      if (showMesh && SceneActors.meshes.empty()) SceneActors.meshes.push_back(&m_mesh);
+        SceneActors.clearMeshes();
+      if (showMesh && SceneActors.meshes.empty()) SceneActors.addMesh(&m_mesh);
     }
     if ((ImGui::DragInt3("Dimensions", &dims.x, 1, 1, 100)
         + ImGui::DragFloat3("Position", &position.x)
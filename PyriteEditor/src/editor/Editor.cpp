@@ -10,6 +10,8 @@
 #include "world/Actor.h"
 #include "world/Mesh/StaticMesh.h"
 
+#include <utility>
+
 pye::Editor::Editor()
 {
 	assets.lightbulb = m_editorAssetsLoader.loadTexture(L"editor/icons/world/lights/lightbulb.png", false);
@@ -48,7 +50,8 @@ void pye::Editor::UpdateRegisteredActors(const pyr::RegisteredRenderableActorCol
 		pf_BillboardHUD* editorBillboard = new pf_BillboardHUD;
 		editorBillboard->editorBillboard = bb;
 		editorBillboard->coreActor = light;
-		bb->transform.position = { light->GetTransform().position.x,light->GetTransform().position.y,light->GetTransform().position.z };
+		const pyr::Transform& lightTransform = std::as_const(*light).GetTransform();
+		bb->transform.position = { lightTransform.position.x,lightTransform.position.y,lightTransform.position.z };
 		WorldHUD.push_back(editorBillboard);
 		RegisteredActors[editorBillboard->editorBillboard->GetActorID()] = editorBillboard;
 		RegisteredActors[light->GetActorID()] = editorBillboard; // < register the light ID as the billboard for convenience purposes (picking events)
@@ -9,6 +9,7 @@
 #include "../editorPasses/WorldHUDPass.h"
 
 #include "views/Rendergraph/widget_rendergraph.h"
+#include "views/Memory/widget_memory.h"
 
 namespace pye
 {
@@ -23,12 +24,13 @@ namespace pye
 			ref.container.Render();
 		}
 
+		// The passes are shared by all scenes and follow the last one injected, call from Scene::onActivated
 		static void InjectEditorToolsToScene(pyr::Scene& scene)
 		{
 			auto& ref = Get();
 			scene.SceneRenderGraph.addPass(&ref.m_editorHUD);
 			scene.SceneRenderGraph.addPass(&ref.m_picker);
-			scene.SceneRenderGraph.getResourcesManager().linkResource("depthBuffer", &ref.m_picker);
+			scene.SceneRenderGraph.getResourcesManager().linkResource(pyr::BuiltinResources::DepthBuffer, &ref.m_picker);
 		}
 
 	private:
@@ -37,6 +39,7 @@ namespace pye
 		pye::widgets::LightCollectionWidget lightWidget;
 		pye::widgets::MaterialWidget materialWidget;
 		pye::widgets::RenderGraphWidget RenderGraphWidget;
+		pye::widgets::GpuMemoryWidget memoryWidget;
 
 		pye::widgets::WidgetsContainer container;
 
@@ -61,13 +64,19 @@ namespace pye
 			rdgWidgetItem.item_name = "Render graph displayer";
 			rdgWidgetItem.UnderlyingWidget = &RenderGraphWidget;
 
+			pye::widgets::EditorUI::ImGuiItem memoryWidgetItem;
+			memoryWidgetItem.item_name = "GPU memory";
+			memoryWidgetItem.UnderlyingWidget = &memoryWidget;
+
 			tools_menu.push_back(std::move(lightWidgetItem));
 			tools_menu.push_back(std::move(materialWidgetItem));
 			tools_menu.push_back(std::move(rdgWidgetItem));
+			tools_menu.push_back(std::move(memoryWidgetItem));
 
 			container.widgets.push_back(&lightWidget);
 			container.widgets.push_back(&materialWidget);
 			container.widgets.push_back(&RenderGraphWidget);
+			container.widgets.push_back(&memoryWidget);
 		}
 
 		static EditorSceneInjector& Get()
@@ -1,11 +1,16 @@
 #include "ShaderReloader.h"
 
-#include <unordered_map>
-#include <unordered_set>
+#include <algorithm>
 #include <filesystem>
+#include <set>
+#include <unordered_set>
+#include <vector>
 
 #include <efsw/efsw.hpp>
 
+#include "display/ShaderCache.h"
+#include "engine/AsyncTasks.h"
+
 namespace fs = std::filesystem;
 using namespace std::chrono_literals;
 
@@ -19,6 +24,8 @@ public:
   ShaderAutoReloaderImpl()
   {
     m_fileWatcher.watch();
+    // Includes are all read from there, editing one reloads every effect that includes it
+    watchDirectory(pyr::ShaderCache::INCLUDE_DIRECTORY);
   }
 
   ~ShaderAutoReloaderImpl()
@@ -31,21 +38,21 @@ public:
   {
     std::shared_ptr<pyr::Effect> effectLock = effect.lock();
     if (!effectLock) throw std::runtime_error("Cannot watch a null effect");
-    std::string effectDirPath = fs::path(effectLock->getFilePath()).parent_path().string();
-    auto it = m_watchedEffects.find(effectDirPath);
-    if (it == m_watchedEffects.end()) {
-      PYR_LOG(LogShader, INFO, "Watching directory ", effectDirPath, " for shader ", effectLock->getFilePath());
-      m_watchedEffects.emplace(effectDirPath, std::vector<std::weak_ptr<pyr::Effect>>{ { effect }});
-      
-      efsw::WatchID watchId = m_fileWatcher.addWatch(effectDirPath, this);
-      m_watchToPath[watchId] = effectDirPath;
-    } else {
-      PYR_LOG(LogShader, INFO, "Already watching directory ", effectDirPath, " for shader ", effectLock->getFilePath());
-      it->second.push_back(effect);
-    }
+    watchDirectory(fs::path(effectLock->getFilePath()).parent_path());
+    m_watchedEffects.push_back(effect);
   }
 
 private:
+  void watchDirectory(const fs::path &directory)
+  {
+    std::string directoryPath = fs::weakly_canonical(directory).string();
+    if (!m_watchedDirectories.insert(directoryPath).second)
+      return;
+    PYR_LOG(LogShader, INFO, "Watching directory ", directoryPath);
+    m_fileWatcher.addWatch(directoryPath, this);
+  }
+
+  // Called from the file watcher thread
   void handleFileAction(
     efsw::WatchID watchid,
     const std::string &dir,
@@ -57,20 +64,7 @@ private:
     std::lock_guard _{ m_debouncingMutex };
 
     bool isDebouncingThreadRunning = !m_pendingChanges.empty();
-    bool isShaderFileChange = false;
-    for (std::weak_ptr<pyr::Effect> effectPtr : m_watchedEffects.at(m_watchToPath.at(watchid))) {
-      if (auto rawPtr = effectPtr.lock()) {
-        if (rawPtr->getFilePath().ends_with(filename)) {
-          PYR_LOG(LogShader, INFO, "Pickup shader file change: ", rawPtr->getFilePath());
-          m_pendingChanges.emplace(std::hash<std::string>{}(rawPtr->getFilePath()), effectPtr);
-          isShaderFileChange = true;
-        }
-      }
-    }
-
-    if (!isShaderFileChange)
-      return;
-
+    m_pendingChanges.insert(fs::weakly_canonical(fs::path(dir) / filename));
     m_changesTimestamp = clock::now();
 
     if (isDebouncingThreadRunning)
@@ -96,31 +90,51 @@ private:
     });
   }
 
+  // Called from the debouncing thread. Changes are matched to the effects on the main thread, that owns them,
+  // and the effects are recompiled on workers: rendering never waits for the compiler.
   void flushChanges()
   {
     PYR_LOG(LogShader, INFO, "Flushing changes");
+    pyr::MainThread::Post([this, lifetime = std::weak_ptr<void>(m_lifetime), changedFiles = std::move(m_pendingChanges)] {
+      if (!lifetime.expired())
+        reloadAffectedEffects(changedFiles);
+    });
+    m_pendingChanges.clear();
+  }
 
-    std::lock_guard _{ pyr::Engine::getFrameMutex() };
-
-    for (auto &[_,effectPtr] : m_pendingChanges) {
-      if (auto effectRawPtr = effectPtr.lock()) {
-        pyr::Effect &effect = *effectRawPtr;
-        PYR_LOG(LogShader, INFO, "Reloading shader ", effect.getFilePath());
-        pyr::ShaderManager::reloadEffect(effect);
+  void reloadAffectedEffects(const std::set<fs::path> &changedFiles)
+  {
+    std::erase_if(m_watchedEffects, [](const std::weak_ptr<pyr::Effect> &effect) { return effect.expired(); });
+    for (const std::weak_ptr<pyr::Effect> &effectPtr : m_watchedEffects) {
+      std::shared_ptr<pyr::Effect> effect = effectPtr.lock();
+      if (effect && isAffected(*effect, changedFiles)) {
+        PYR_LOG(LogShader, INFO, "Reloading shader ", effect->getFilePath());
+        pyr::ShaderManager::reloadEffect(effectPtr);
       }
     }
-    m_pendingChanges.clear();
+  }
+
+  static bool isAffected(const pyr::Effect &effect, const std::set<fs::path> &changedFiles)
+  {
+    if (changedFiles.contains(fs::weakly_canonical(effect.getFilePath())))
+      return true;
+    if (!effect.isCompiled())
+      return false; // still compiling, with the sources as they are now
+    return std::ranges::any_of(effect.getIncludes(), [&](const std::string &include) {
+      return changedFiles.contains(fs::weakly_canonical(fs::path(pyr::ShaderCache::INCLUDE_DIRECTORY) / include));
+    });
   }
 
 private:
   efsw::FileWatcher m_fileWatcher;
-  std::unordered_map<efsw::WatchID, std::string> m_watchToPath;
-  std::unordered_map<std::string, std::vector<std::weak_ptr<pyr::Effect>>> m_watchedEffects;
+  std::unordered_set<std::string> m_watchedDirectories;
+  std::vector<std::weak_ptr<pyr::Effect>> m_watchedEffects; // main thread only
 
   std::mutex m_debouncingMutex;
-  std::unordered_map<size_t, std::weak_ptr<pyr::Effect>> m_pendingChanges; // only a map because unordered_set<weak_ptr> is not a possibility
+  std::set<fs::path> m_pendingChanges;
   std::chrono::time_point<clock> m_changesTimestamp;
   std::thread m_debouncingThread;
+  std::shared_ptr<void> m_lifetime = std::make_shared<int>(); // tells the tasks posted to the main thread that this is gone
 };
 
 ShaderAutoReloader::ShaderAutoReloader()
@@ -3,6 +3,7 @@
 #include "imgui.h"
 
 #include "display/texture.h"
+#include "world/Shadows/CascadedShadowMaps.h"
 
 #include "editor/bridges/Lights/pf_Light.h"
 #include "editor/views/widget.h"
@@ -83,24 +84,21 @@ namespace pye
 						pyr::BaseLight* bAdded = nullptr;
 						if (ImGui::Selectable("Point light"))
 						{
-							LightsCollectionView.sourceCollection->Points.push_back({});
+							bAdded = &LightsCollectionView.sourceCollection->AddLight(pyr::PointLight{});
 							LightsCollectionView.bIsWidgetDirty = true;
 							LightsCollectionView.selectedLight = nullptr;
-							bAdded = &LightsCollectionView.sourceCollection->Points.back();
 						}
 						if (ImGui::Selectable("Spot light")) 
 						{
-							LightsCollectionView.sourceCollection->Spots.push_back({}); 
+							bAdded = &LightsCollectionView.sourceCollection->AddLight(pyr::SpotLight{});
 							LightsCollectionView.bIsWidgetDirty = true;
 							LightsCollectionView.selectedLight = nullptr;
-							bAdded = &LightsCollectionView.sourceCollection->Spots.back();
 						}
 						if (ImGui::Selectable("Directional light"))
 						{
-							LightsCollectionView.sourceCollection->Directionals.push_back({});
+							bAdded = &LightsCollectionView.sourceCollection->AddLight(pyr::DirectionalLight{});
 							LightsCollectionView.bIsWidgetDirty = true;
 							LightsCollectionView.selectedLight = nullptr;
-							bAdded = &LightsCollectionView.sourceCollection->Directionals.back();
 						}
 						if (bAdded) pye::EditorEvents::OnActorAddedEvent.NotifyAll();
 						//if (bAdded) pye::EditorEvents::OnActorAddedEvent.NotifyAll(bAdded);
@@ -178,21 +176,25 @@ namespace pye
 
 				if (!light.sourceLight) return;
 
+				// Edited on a copy, the transform is only recorded in the SceneChangeJournal when it actually changes
+				pyr::Transform transform = std::as_const(*light.sourceLight).GetTransform();
+
 				ImGui::Checkbox("IsOn", &light.sourceLight->isOn);
 				ImGui::Separator();
 				ImGui::Checkbox("Cast dynamic shadows", (bool*)&light.sourceLight->shadowMode);
 				if (light.sourceLight->shadowMode == pyr::DynamicShadow && light.sourceLight->getType() != pyr::LightTypeID::Point)
 				{
 					ImGui::Text("Projection Parameters");
-					if (pyr::DirectionalLight* asDirectional = static_cast<pyr::DirectionalLight*>(light.sourceLight))
+					if (light.sourceLight->getType() == pyr::LightTypeID::Directional)
 					{
-						ImGui::SliderFloat("Width", &asDirectional->shadow_projection.width, 1.F, 1000.F);
-						ImGui::SliderFloat("Height", &asDirectional->shadow_projection.height, 1.F, 1000.F);
-						ImGui::SliderFloat("zNear", &asDirectional->shadow_projection.zNear, 0.01F, 1.F);
-						ImGui::SliderFloat("zFar", &asDirectional->shadow_projection.zFar,  1.F, 100.F);
+						pyr::DirectionalLight* asDirectional = static_cast<pyr::DirectionalLight*>(light.sourceLight);
+						ImGui::SliderInt("Cascades", &asDirectional->cascadeCount, 1, static_cast<int>(pyr::CascadedShadowMaps::MAX_CASCADES_PER_LIGHT));
+						ImGui::SliderFloat("Split lambda", &asDirectional->cascadeSplitLambda, 0.F, 1.F);
+						ImGui::SliderFloat("Shadow distance", &asDirectional->shadowDistance, 1.F, 1000.F);
 					}
-					if (pyr::SpotLight* asSpotlight = static_cast<pyr::SpotLight*>(light.sourceLight))
+					if (light.sourceLight->getType() == pyr::LightTypeID::Spotlight)
 					{
+						pyr::SpotLight* asSpotlight = static_cast<pyr::SpotLight*>(light.sourceLight);
 						ImGui::SliderFloat("Fov", &asSpotlight->shadow_projection.fovy, 0.01f, XM_PI);
 						ImGui::SliderFloat("zNear", &asSpotlight->shadow_projection.zNear, 0.01F, 1.F);
 						ImGui::SliderFloat("zFar", &asSpotlight->shadow_projection.zFar, 1.1F, 100.F);
@@ -208,7 +210,7 @@ namespace pye
 				{
 					pyr::DirectionalLight* sourceLight = static_cast<pyr::DirectionalLight*>(light.sourceLight);
 					if (!sourceLight) break;
-					ImGui::DragFloat3("Direction", &sourceLight->GetTransform().rotation.x);
+					ImGui::DragFloat3("Direction", &transform.rotation.x);
 					ImGui::DragFloat("Strength", &sourceLight->strength, 1.0, 0);
 					break;
 				}
@@ -216,8 +218,8 @@ namespace pye
 				{
 					pyr::SpotLight* sourceLight = static_cast<pyr::SpotLight*>(light.sourceLight);
 					if (!sourceLight) break;
-					ImGui::DragFloat3("Position", &sourceLight->GetTransform().position.x);
-					ImGui::DragFloat3("Direction", &sourceLight->GetTransform().rotation.x);
+					ImGui::DragFloat3("Position", &transform.position.x);
+					ImGui::DragFloat3("Direction", &transform.rotation.x);
 					ImGui::DragFloat("Strength", &sourceLight->strength);
 					if (ImGui::DragFloat("Hard light angle", &sourceLight->insideAngle, 0.05f, 0.f, XM_PI) +
 						ImGui::DragFloat("Fall-off angle", &sourceLight->outsideAngle, 0.05f, 0.0f, XM_PI))
@@ -235,7 +237,7 @@ namespace pye
 					{
 						sourceLight->range = sourceLight->computeRangeFromDistance(sourceLight->distance);
 					}
-					ImGui::DragFloat3("Position", &sourceLight->GetTransform().position.x);
+					ImGui::DragFloat3("Position", &transform.position.x);
 					ImGui::DragFloat("specularFactor", &sourceLight->specularFactor, 1.0, 0);
 					ImGui::Separator();
 
@@ -243,6 +245,9 @@ namespace pye
 				}
 				}
 
+				if (transform.position != std::as_const(*light.sourceLight).GetTransform().position
+					|| transform.rotation != std::as_const(*light.sourceLight).GetTransform().rotation)
+					light.sourceLight->SetTransform(transform);
 			}
 
 		};
@@ -50,7 +50,7 @@ namespace pye
 			pyr::RegisteredRenderableActorCollection toRender;
 			
 			// TODO : environement here
-			size_t selectedMaterialID = 0;
+			pyr::MaterialBank::mat_id_t selectedMaterialID;
 
 		
 		
@@ -68,12 +68,12 @@ namespace pye
 				renderGraph.addPass(&m_depthPrePass);
 				renderGraph.addPass(&m_forwardPass);
 		
-				renderGraph.getResourcesManager().addProduced(&m_depthPrePass, "depthBuffer");
-				renderGraph.getResourcesManager().linkResource(&m_depthPrePass, "depthBuffer", &m_forwardPass);
+				renderGraph.getResourcesManager().addProduced(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer);
+				renderGraph.getResourcesManager().linkResource(&m_depthPrePass, pyr::BuiltinResources::DepthBuffer, &m_forwardPass);
 		
 				renderGraph.getResourcesManager().checkResourcesValidity();
-				toRender.meshes.push_back(&displayBall);
-				toRender.lights.Directionals.push_back(light);
+				toRender.addMesh(&displayBall);
+				toRender.lights.AddLight(light);
 
 
 				pye::EditorEvents::OnActorPickedEvent.BindCallback(*this, &MaterialWidget::ChangeMaterialFromNewlySelectedActor);
@@ -90,16 +90,17 @@ namespace pye
 
 				if (ImGui::BeginCombo("Material##1", pyr::MaterialBank::GetMaterialName(selectedMaterialID).c_str() ))
 				{
-					for (auto [id, ref] : pyr::MaterialBank::GetAllMaterials())
+					for (const std::shared_ptr<pyr::Material>& ref : pyr::MaterialBank::GetAllMaterials())
 					{
-						ImGui::PushID((int)id);
-						if (ImGui::Selectable((ref->d_publicName + "##" + std::to_string(id)).c_str(), id == selectedMaterialID))
+						const pyr::MaterialBank::mat_id_t id = ref->getBankHandle();
+						ImGui::PushID(static_cast<int>(id.value));
+						if (ImGui::Selectable((ref->d_publicName + "##" + std::to_string(id.value)).c_str(), id == selectedMaterialID))
 						{
 							selectedMaterialID = id;
 							ChangeMaterial(id);
 
 						}
-						if (id == static_cast<int>(selectedMaterialID))
+						if (id == selectedMaterialID)
 							ImGui::SetItemDefaultFocus();
 						ImGui::PopID();
 					}
@@ -173,9 +174,9 @@ namespace pye
 
 				// Current implementation is kinda stupid and each submesh is a mesh so this is a hack until we redo the import correctly for the 10th time
 				size_t firstSubmeshMaterial = asMesh->sourceMesh->getModel()->getRawMeshData()->getSubmeshes()[0].materialIndex;
-				if (auto material = asMesh->sourceMesh->getMaterial(firstSubmeshMaterial))
+				if (const pyr::Material* material = asMesh->sourceMesh->getMaterial(firstSubmeshMaterial))
 				{
-					ChangeMaterial(pyr::MaterialBank::GetMaterialGlobalId(material->d_publicName)); // i dont like this being name based
+					ChangeMaterial(material->getBankHandle());
 				}
 			}
 
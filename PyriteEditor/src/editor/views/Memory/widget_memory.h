@@ -0,0 +1,84 @@
+#pragma once
+
+#include "imgui.h"
+
+#include "display/GpuMemory.h"
+#include "display/TextureCache.h"
+
+#include "editor/views/widget.h"
+
+/// <summary>
+/// GPU memory usage by resource category, biggest resources first, and the TextureCache budget.
+/// </summary>
+
+namespace pye
+{
+	namespace widgets
+	{
+
+		struct GpuMemoryWidget : public Widget
+		{
+
+		private:
+
+			static constexpr size_t TOP_CONSUMERS_COUNT = 20;
+
+			static float ToMB(size_t bytes) { return static_cast<float>(bytes) / (1024.F * 1024.F); }
+
+		public:
+
+			virtual void display() override
+			{
+				using pyr::GpuMemory;
+				pyr::TextureCache& cache = pyr::TextureCache::get();
+
+				ImGui::Begin("GPU memory");
+
+				const size_t budget = cache.getMemoryBudget();
+				const size_t total = GpuMemory::GetTotalBytes();
+				ImGui::Text("Total : %.1f MB", ToMB(total));
+				ImGui::ProgressBar(budget ? static_cast<float>(total) / static_cast<float>(budget) : 1.F, ImVec2(-1, 0), total > budget ? "Over budget" : nullptr);
+
+				int budgetMB = static_cast<int>(budget >> 20);
+				if (ImGui::SliderInt("Budget (MB)", &budgetMB, 64, 8192))
+					cache.setMemoryBudget(static_cast<size_t>(budgetMB) << 20);
+
+				for (size_t category = 0; category < static_cast<size_t>(GpuMemory::Category::__COUNT); category++)
+				{
+					auto asCategory = static_cast<GpuMemory::Category>(category);
+					ImGui::BulletText("%s : %.1f MB", GpuMemory::GetCategoryName(asCategory), ToMB(GpuMemory::GetTotalBytes(asCategory)));
+				}
+
+				if (ImGui::CollapsingHeader("Texture cache"))
+				{
+					const pyr::TextureCache::Stats& stats = cache.getStats();
+					ImGui::Text("Resident : %.1f MB, saved by sharing : %.1f MB", ToMB(stats.residentBytes), ToMB(stats.savedBytes));
+					ImGui::Text("Loads : %u, avoided : %u (%u by content)", stats.loads, stats.avoidedLoads, stats.contentDuplicates);
+					ImGui::Text("Evictions : %u, mips dropped : %u, reloads : %u", stats.evictions, stats.downgrades, stats.reloads);
+					ImGui::Text("Streamed loads : %u (%u in flight)", stats.streamedLoads, stats.streamingLoadsInFlight);
+				}
+
+				if (ImGui::CollapsingHeader("Top consumers", ImGuiTreeNodeFlags_DefaultOpen)
+					&& ImGui::BeginTable("##consumers", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+				{
+					ImGui::TableSetupColumn("Resource");
+					ImGui::TableSetupColumn("Category");
+					ImGui::TableSetupColumn("Size");
+					ImGui::TableHeadersRow();
+
+					for (const GpuMemory::Allocation& allocation : GpuMemory::GetTopConsumers(TOP_CONSUMERS_COUNT))
+					{
+						ImGui::TableNextRow();
+						ImGui::TableNextColumn(); ImGui::TextUnformatted(allocation.name.c_str());
+						ImGui::TableNextColumn(); ImGui::TextUnformatted(GpuMemory::GetCategoryName(allocation.category));
+						ImGui::TableNextColumn(); ImGui::Text("%.2f MB", ToMB(allocation.byteSize));
+					}
+					ImGui::EndTable();
+				}
+
+				ImGui::End();
+			}
+		};
+
+	}
+}
@@ -23,6 +23,7 @@
 
 #include <utils/math.h>
 #include <ranges>
+#include <unordered_set>
 
 
 
@@ -39,7 +40,7 @@ namespace pye
 			static constexpr unsigned int INPUT_PIN_COLOR = IM_COL32(81, 204, 148, 255);
 			static constexpr unsigned int OUTPUT_PIN_COLOR = IM_COL32(148, 81, 72, 255);
 			int id = 0;
-			std::unordered_map<std::string, int> resourceToInputMap;
+			std::unordered_map<pyr::ResourceID, int, pyr::ResourceID::Hasher> resourceToInputMap;
 			std::unordered_map<int, std::vector<int>> inputToOutputsId;
 			std::unordered_map<int, pyr::RenderGraphResourceManager::PassResources> nodeIDToResources;
 			std::unordered_map<pyr::RenderPass*, bool> bIsDebugWindowOpened;
@@ -55,6 +56,22 @@ namespace pye
 			{
 				ImGui::Begin("Render graph editor");
 
+				const pyr::TransientResourcePool::Stats& transientStats = pyr::SceneManager::getActiveScene()->SceneRenderGraph.GetTransientStats();
+				ImGui::Text("Transient targets : %zu in %zu framebuffers, %.1f MB (%.1f MB without aliasing)",
+					transientStats.transientCount, transientStats.physicalCount,
+					static_cast<float>(transientStats.bytesWithAliasing) / (1024.F * 1024.F),
+					static_cast<float>(transientStats.bytesWithoutAliasing) / (1024.F * 1024.F));
+
+				pyr::RenderGraphProfiler& profiler = pyr::SceneManager::getActiveScene()->SceneRenderGraph.GetProfiler();
+				if (ImGui::Button("Dump timings (CSV)")) profiler.dumpToCSV("rendergraph_timings.csv");
+				ImGui::SameLine();
+				if (ImGui::Button("Dump timings (JSON)")) profiler.dumpToJSON("rendergraph_timings.json");
+				if (!profiler.isGpuTimingAvailable())
+				{
+					ImGui::SameLine();
+					ImGui::TextDisabled("(no GPU timings)");
+				}
+
 				ImNodes::BeginNodeEditor();
 
 				BuildSceneRenderGraph();
@@ -63,7 +80,7 @@ namespace pye
 				ImNodes::EndNodeEditor();
 
 				int out = 0;
-				for (auto [name, output_id] : resourceToInputMap)
+				for (auto [resId, output_id] : resourceToInputMap)
 				{
 					if (ImNodes::IsPinHovered(&out))
 					{
@@ -73,9 +90,9 @@ namespace pye
 							auto& rdgResources = pyr::SceneManager::getActiveScene()->SceneRenderGraph.getResourcesManager();
 							for (const auto& res : rdgResources.GetAllResources() | std::ranges::views::values)
 							{
-								if (res.producedResources.contains(name))
+								if (res.producedResources.contains(resId))
 								{
-									ImGui::Image((void*)res.producedResources.at(name).res.getRawTexture(), ImVec2{ 128,128 });
+									ImGui::Image((void*)res.producedResources.at(resId).res.getRawTexture(), ImVec2{ 128,128 });
 									break;
 								}
 							}
@@ -114,26 +131,28 @@ namespace pye
 					ImGui::EndDisabled();
 				}
 
+				DisplayPassTimings(pass);
+
 				ImGui::Dummy({ 0,0 });
 
 				ImNodes::PushColorStyle(ImNodesCol_Pin, INPUT_PIN_COLOR);
-				for (const auto& [name, ref] : resources.incomingResources)
+				for (const auto& [resId, ref] : resources.incomingResources)
 				{
-					int incomingResourceId = resourceToInputMap[name];
+					int incomingResourceId = resourceToInputMap[resId];
 					inputToOutputsId[incomingResourceId].push_back(id);
 					ImNodes::BeginInputAttribute(id++);
-					ImGui::Text(name.c_str());
+					ImGui::TextUnformatted(resId.name.data(), resId.name.data() + resId.name.size());
 					ImNodes::EndOutputAttribute();
 				}
 
 				ImNodes::PopColorStyle();
 				ImNodes::PushColorStyle(ImNodesCol_Pin, OUTPUT_PIN_COLOR);
 
-				for (const auto& [name, ref] : resources.producedResources)
+				for (const auto& [resId, ref] : resources.producedResources)
 				{
-					resourceToInputMap[name] = id;
+					resourceToInputMap[resId] = id;
 					ImNodes::BeginOutputAttribute(id);
-					ImGui::Text(name.c_str());
+					ImGui::TextUnformatted(resId.name.data(), resId.name.data() + resId.name.size());
 					ImNodes::EndOutputAttribute();
 					id++;
 				}
@@ -172,7 +191,7 @@ namespace pye
 
 				int depth = 0;
 				int height = 0;
-				std::set<std::string> producedFounds{};
+				std::unordered_set<pyr::ResourceID, pyr::ResourceID::Hasher> producedFounds{};
 				while (nodeIdToDepth.size() != nodeIDToResources.size() && depth < 10)
 				{
 					height = 0;
@@ -182,7 +201,7 @@ namespace pye
 						if (nodeIdToDepth.contains(node_id)) continue;
 						auto filtered = resources.incomingResources 
 										| std::ranges::views::keys
-										| std::ranges::views::filter([&](const std::string& name) { return !producedFounds.contains(name); });
+										| std::ranges::views::filter([&](const pyr::ResourceID& resId) { return !producedFounds.contains(resId); });
 
 						if (filtered.empty())
 						{
@@ -194,7 +213,7 @@ namespace pye
 					{
 						// if the node has been solved the say that its produced resources are recorded
 						if (nodeIdToDepth.contains(node_id) && nodeIdToDepth.at(node_id).first == depth)
-							std::ranges::for_each(resources.producedResources | std::ranges::views::keys, [&](const std::string& name) { producedFounds.insert(name); });
+							std::ranges::for_each(resources.producedResources | std::ranges::views::keys, [&](const pyr::ResourceID& resId) { producedFounds.insert(resId); });
 					}
 
 					depth++;
@@ -210,7 +229,37 @@ namespace pye
 
 		private:
 
-		
+			void DisplayPassTimings(pyr::RenderPass* pass)
+			{
+				const pyr::RenderGraph& graph = pyr::SceneManager::getActiveScene()->SceneRenderGraph;
+				const pyr::RenderGraphProfiler& profiler = graph.GetProfiler();
+
+				auto passIt = std::ranges::find(graph.GetPasses(), pass);
+				size_t passIndex = std::distance(graph.GetPasses().begin(), passIt);
+				if (passIt == graph.GetPasses().end() || passIndex >= profiler.getHistory().size()) return;
+
+				// Averages skip the zeros, which are frames where the pass was disabled or GPU results that are not back yet
+				auto average = [](const auto& samples) {
+					float sum = 0.F; int count = 0;
+					for (float sample : samples) if (sample > 0.F) { sum += sample; count++; }
+					return count ? sum / static_cast<float>(count) : 0.F;
+				};
+
+				const pyr::RenderGraphProfiler::PassHistory& history = profiler.getHistory()[passIndex];
+				const int historySize = static_cast<int>(pyr::RenderGraphProfiler::HISTORY_SIZE);
+				const int offset = static_cast<int>(profiler.getHistoryOffset());
+
+				ImGui::PushID(pass);
+				ImGui::Text("CPU %.3f ms (avg %.3f)", history.cpuMs[profiler.getLatestSampleIndex()], average(history.cpuMs));
+				ImGui::PlotLines("##cpu", history.cpuMs.data(), historySize, offset, nullptr, 0.F, FLT_MAX, ImVec2{ 160, 30 });
+				if (profiler.isGpuTimingAvailable())
+				{
+					ImGui::Text("GPU avg %.3f ms", average(history.gpuMs));
+					ImGui::PlotLines("##gpu", history.gpuMs.data(), historySize, offset, nullptr, 0.F, FLT_MAX, ImVec2{ 160, 30 });
+				}
+				ImGui::PopID();
+			}
+
 		};
 	}
 }
\ No newline at end of file
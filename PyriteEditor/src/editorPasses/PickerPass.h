@@ -4,10 +4,12 @@
 #include <ranges>
 #include <span>
 #include <memory>
+#include <utility>
 
 #include "utils/Debug.h"
 #include "display/RenderGraph/RenderPass.h"
 #include "display/GraphicalResource.h"
+#include "display/EffectPermutations.h"
 #include "world/Mesh/RawMeshData.h"
 #include "world/Mesh/StaticMesh.h"
 #include "world/Transform.h"
@@ -54,12 +56,14 @@ namespace pye
             pyr::FrameBuffer m_idTarget{ pyr::Device::getWinWidth(),pyr::Device::getWinHeight(), pyr::FrameBuffer::COLOR_0};
             pyr::FrameBuffer m_OutlineTarget{ pyr::Device::getWinWidth(),pyr::Device::getWinHeight(), pyr::FrameBuffer::COLOR_0};
 
-            pyr::Effect* m_pickEffect_Meshes = nullptr;
-            pyr::Effect* m_pickEffect_Billboards = nullptr;
+            pyr::EffectPermutations m_pickEffects{ m_registry, L"editor/shaders/picker.fx", { "USE_MESH", "USE_BILLBOARDS" } };
+            static constexpr pyr::EffectPermutations::mask_t PICK_MESHES = 1 << 0;
+            static constexpr pyr::EffectPermutations::mask_t PICK_BILLBOARDS = 1 << 1;
             pyr::Effect* m_gridDepthEffect = nullptr;
             pyr::Effect* m_outlineEffect = nullptr;
             pyr::Effect* m_composeEffect = nullptr;
-            pyr::Effect* m_renderBillboardEffect = nullptr;
+            pyr::EffectPermutations m_billboardEffects{ m_registry, L"res/shaders/billboard.fx", { "USE_TEXTURE_AS_DEPTH" } };
+            static constexpr pyr::EffectPermutations::mask_t BILLBOARD_TEXTURE_AS_DEPTH = 1 << 0;
 
 
             std::vector<pye::EditorActor> m_editorActors;
@@ -67,10 +71,11 @@ namespace pye
 
             pyr::ScreenPoint m_requestedMousePosition;
 
-            bool bShouldPick = false;
+            pyr::ResourceHandle<pyr::Texture> m_depthInput;
+            pyr::ResourceHandle<pyr::FrameBuffer> m_selectionTarget;
+            pyr::ResourceHandle<pyr::FrameBuffer> m_selectionOutlineTarget;
 
-            pyr::FrameBuffer m_target{pyr::Device::getWinWidth(), pyr::Device::getWinHeight(), pyr::FrameBuffer::COLOR_0 | pyr::FrameBuffer::DEPTH_STENCIL };
-            pyr::FrameBuffer m_targetNoDepth{pyr::Device::getWinWidth(), pyr::Device::getWinHeight(), pyr::FrameBuffer::COLOR_0 };
+            bool bShouldPick = false;
 
             ID3D11Texture2D* StagingTexture;
 
@@ -78,6 +83,8 @@ namespace pye
 
         public:
 
+            static inline const pyr::TextureResourceID PickerIdBuffer{ "pickerIdBuffer" };
+
             EditorActor* Selected = nullptr;
             std::vector<EditorActor*> selectedActors;
 
@@ -85,17 +92,10 @@ namespace pye
             {
                 displayName = "Editor-PickerPass";
               
-                m_pickEffect_Meshes = m_registry.loadEffect(
-                    L"editor/shaders/picker.fx",
-                    pyr::InputLayout::MakeLayoutFromVertex<pyr::RawMeshData::mesh_vertex_t>(),
-                    { pyr::Effect::define_t{ .name = "USE_MESH", .value = "1" }}
-                );
-
-                m_pickEffect_Billboards = m_registry.loadEffect(
-                    L"editor/shaders/picker.fx",
-                    pyr::InputLayout::MakeLayoutFromVertex<pyr::EmptyVertex,pyr::Billboard::billboard_vertex_t>(),
-                    { pyr::Effect::define_t{ .name = "USE_BILLBOARDS", .value = "1" }}
-                );
+                // Every permutation is requested here so that they compile together, selected with their mask when drawing
+                m_pickEffects.add(PICK_MESHES, pyr::InputLayout::MakeLayoutFromVertex<pyr::RawMeshData::mesh_vertex_t>());
+                m_pickEffects.add(PICK_BILLBOARDS, pyr::InputLayout::MakeLayoutFromVertex<pyr::EmptyVertex, pyr::Billboard::billboard_vertex_t>());
+                m_billboardEffects.add(BILLBOARD_TEXTURE_AS_DEPTH, pyr::InputLayout::MakeLayoutFromVertex<pyr::EmptyVertex, pyr::Billboard::billboard_vertex_t>());
 
                 m_gridDepthEffect = m_registry.loadEffect(
                     L"editor/shaders/selectionDepthEffect.fx",
@@ -112,13 +112,12 @@ namespace pye
                     pyr::InputLayout::MakeLayoutFromVertex<pyr::EmptyVertex>()
                 );
 
-                m_renderBillboardEffect = m_registry.loadEffect(
-                    L"res/shaders/billboard.fx",
-                    pyr::InputLayout::MakeLayoutFromVertex<pyr::EmptyVertex, pyr::Billboard::billboard_vertex_t>(),
-                    { pyr::Effect::define_t{.name = "USE_TEXTURE_AS_DEPTH", .value = "1"}}
-                );
+                m_depthInput = declareInput(pyr::BuiltinResources::DepthBuffer);
+                producesResource(PickerIdBuffer, m_idTarget.getTargetAsTexture(pyr::FrameBuffer::COLOR_0));
 
-                producesResource("pickerIdBuffer", m_idTarget.getTargetAsTexture(pyr::FrameBuffer::COLOR_0));
+                // -- Selection outline targets only live during this pass, let the graph alias them
+                m_selectionTarget = declareTransient("selectionTarget", pyr::TransientTextureDesc::WindowSized(pyr::FrameBuffer::COLOR_0 | pyr::FrameBuffer::DEPTH_STENCIL));
+                m_selectionOutlineTarget = declareTransient("selectionOutline", pyr::TransientTextureDesc::WindowSized(pyr::FrameBuffer::COLOR_0));
 
                 // -- Create a staging texture with the format of the source texture
 
@@ -160,6 +159,7 @@ namespace pye
             {
                 if (!PYR_ENSURE(owner)) return;
                 if (!PYR_ENSURE(owner->GetContext().contextCamera)) return;
+                if (!PYR_ENSURE(getInput(m_depthInput), "The picker requires a linked depth buffer")) return;
 
                 boundCamera = owner->GetContext().contextCamera;
 
@@ -174,25 +174,25 @@ namespace pye
                     RenderSelectedActors();
 
                     // -- 4. Guizmos
-                    std::vector<Transform*> transformsToEdit;
+                    std::vector<pyr::Actor*> actorsToEdit;
                     for (EditorActor* actor : selectedActors)
                     {
                         pye::pf_StaticMesh* sm = dynamic_cast<pye::pf_StaticMesh*>(actor);
                         if (sm)
                         {
-                            transformsToEdit.push_back(&sm->sourceMesh->GetTransform());
+                            actorsToEdit.push_back(sm->sourceMesh);
                             continue;
                         }
                         pye::pf_BillboardHUD* bb = dynamic_cast<pye::pf_BillboardHUD*>(actor);
                         if (bb)
                         {
-                            transformsToEdit.push_back(&((pyr::PointLight*)bb->coreActor)->GetTransform());
+                            actorsToEdit.push_back(bb->coreActor);
                             continue;
                         }
 
                     }
                     
-                    EditTransforms(*owner->GetContext().contextCamera, transformsToEdit);
+                    EditTransforms(*owner->GetContext().contextCamera, actorsToEdit);
                 }
             }
 
@@ -210,7 +210,7 @@ namespace pye
 
                 m_requestedMousePosition = pyr::UserInputs::getMousePosition();
                 pyr::RenderProfiles::pushDepthProfile(pyr::DepthProfile::TESTONLY_DEPTH);
-                m_idTarget.setDepthOverride(m_inputs["depthBuffer"].res.toDepthStencilView());
+                m_idTarget.setDepthOverride(getInput(m_depthInput)->res.toDepthStencilView());
 
                 auto renderDoc = pyr::RenderDoc::Get();
 #if DEBUG_PICKER
@@ -238,14 +238,14 @@ namespace pye
 
 
                     smesh->bindModel();
-                    pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = smesh->GetTransform().getWorldMatrix() });
+                    pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = smesh->GetWorldMatrix() });
                     pIdBuffer->setData(ActorPickerIDBuffer::data_t{ .id = smesh->GetActorID() });
 
-                    m_pickEffect_Meshes->bindConstantBuffer("ActorPickerIDBuffer", pIdBuffer);
-                    m_pickEffect_Meshes->bindConstantBuffer("CameraBuffer", pcameraBuffer);
-                    m_pickEffect_Meshes->bindConstantBuffer("ActorBuffer", pActorBuffer);
+                    m_pickEffects.get(PICK_MESHES)->bindConstantBuffer("ActorPickerIDBuffer", pIdBuffer);
+                    m_pickEffects.get(PICK_MESHES)->bindConstantBuffer("CameraBuffer", pcameraBuffer);
+                    m_pickEffects.get(PICK_MESHES)->bindConstantBuffer("ActorBuffer", pActorBuffer);
 
-                    m_pickEffect_Meshes->bind();
+                    m_pickEffects.get(PICK_MESHES)->bind();
 
                     std::span<const pyr::SubMesh> submeshes = smesh->getModel()->getRawMeshData()->getSubmeshes();
                     for (auto& submesh : submeshes)
@@ -253,7 +253,7 @@ namespace pye
                         pyr::Engine::d3dcontext().DrawIndexed(static_cast<UINT>(submesh.getIndexCount()), submesh.startIndex, 0);
                     }
 
-                    m_pickEffect_Meshes->unbindResources();
+                    m_pickEffects.get(PICK_MESHES)->unbindResources();
                 }
 
                 // -- Billboards
@@ -275,8 +275,8 @@ namespace pye
 
                     pBillboardIDBuffer->setData(data);
 
-                	m_pickEffect_Billboards->bindConstantBuffer("CameraBuffer", pcameraBuffer);
-                    m_pickEffect_Billboards->bindConstantBuffer("BillboardPickerIDBuffer", pBillboardIDBuffer);
+                	m_pickEffects.get(PICK_BILLBOARDS)->bindConstantBuffer("CameraBuffer", pcameraBuffer);
+                    m_pickEffects.get(PICK_BILLBOARDS)->bindConstantBuffer("BillboardPickerIDBuffer", pBillboardIDBuffer);
 
                     std::vector<pyr::Texture> sortedTextures;
                     sortedTextures.resize(16);
@@ -284,12 +284,12 @@ namespace pye
                     {
                         sortedTextures[texId] = *texPtr;
                     }
-                    m_pickEffect_Billboards->bindTextures(sortedTextures, "textures");
+                    m_pickEffects.get(PICK_BILLBOARDS)->bindTextures(sortedTextures, "textures");
 
-                    m_pickEffect_Billboards->bind();
+                    m_pickEffects.get(PICK_BILLBOARDS)->bind();
                     renderData.instanceBuffer.bind(true);
                     pyr::Engine::d3dcontext().DrawInstanced(6, static_cast<UINT>(renderData.instanceBuffer.getVerticesCount()), 0, 0);
-                    m_pickEffect_Billboards->unbindResources();
+                    m_pickEffects.get(PICK_BILLBOARDS)->unbindResources();
                 }
 
                 m_idTarget.unbind();
@@ -381,17 +381,18 @@ namespace pye
             /// 
             /// This works fine for single manipulation, altough the guizmo transform is offset for submeshes.
             /// The scaling and rotation for multiple selection is broken. Albin will fix this ! :wink:
-            void EditTransforms(const pyr::Camera& camera, std::vector<Transform*> transforms)
+            // Transforms are only read until the guizmo is used, the mutable accessor would report the actors as moved every frame
+            void EditTransforms(const pyr::Camera& camera, const std::vector<pyr::Actor*>& actors)
             {
                 // Get center of mass ? 
-                if (transforms.empty()) return;
+                if (actors.empty()) return;
 
                 Transform center;
-                for (Transform* t : transforms)
+                for (const pyr::Actor* actor : actors)
                 {
-                    center.position += t->position;
+                    center.position += actor->GetTransform().position;
                 }
-                center.position /= static_cast<float>(transforms.size());
+                center.position /= static_cast<float>(actors.size());
                 center.scale = { 1,1,1 };
                 center.rotation = { 0,0,0 };
 
@@ -414,19 +415,21 @@ namespace pye
                     matrix.Decompose(dScale, dRot, dPos);
 
                     dPos -= originalPos;
-                    for (Transform* t : transforms)
+                    for (pyr::Actor* actor : actors)
                     {
-                        t->position += dPos;
-                        if (transforms.size() > 1)
+                        Transform t = std::as_const(*actor).GetTransform();
+                        t.position += dPos;
+                        if (actors.size() > 1)
                         {
                             vec3 rotationPoint = center.position;
-                            vec3 diff = t->position - rotationPoint;
+                            vec3 diff = t.position - rotationPoint;
                             vec3 out = (diff * dRot);
-                            t->position += out;
+                            t.position += out;
                         }
 
-                        if (mCurrentGizmoOperation == ImGuizmo::SCALE) t->scale = dScale; // temp
-                        t->rotation *= dRot;
+                        if (mCurrentGizmoOperation == ImGuizmo::SCALE) t.scale = dScale; // temp
+                        t.rotation *= dRot;
+                        actor->SetTransform(t);
                     }
                 }
             }
@@ -435,15 +438,19 @@ namespace pye
             /// Could use some improvements.
             void RenderSelectedActors()
             {
+                pyr::FrameBuffer& target = getTransient(m_selectionTarget);
+                pyr::FrameBuffer& targetNoDepth = getTransient(m_selectionOutlineTarget);
+                const pyr::Texture sceneDepth = getInput(m_depthInput)->res;
+
                 // -- 0 . Clear and update buffers
-                m_target.clearTargets();
-                m_target.bind();
+                target.clearTargets();
+                target.bind();
                 pcameraBuffer->setData(CameraBuffer::data_t{ .mvp = boundCamera->getViewProjectionMatrix(), .pos = boundCamera->getPosition() });
 
                 // -- 1 . Depth grid effect and selected meshes depth buffer. We store billboards separatly and don't render the grid (they are always on top for now)
                 pyr::RenderProfiles::pushBlendProfile(pyr::BlendProfile::BLEND);
 
-                m_gridDepthEffect->bindTexture(m_inputs["depthBuffer"].res, "depthBuffer");
+                m_gridDepthEffect->bindTexture(sceneDepth, "depthBuffer");
                 m_gridDepthEffect->bindConstantBuffer("CameraBuffer", pcameraBuffer);
 
                 std::vector<const pyr::Billboard*> selectedBillboards; // < dirty thing
@@ -462,7 +469,7 @@ namespace pye
                     }
 
                     sm->sourceMesh->bindModel();
-                    pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = sm->sourceMesh->GetTransform().getWorldMatrix() });
+                    pActorBuffer->setData(ActorBuffer::data_t{ .modelMatrix = sm->sourceMesh->GetWorldMatrix() });
                     m_gridDepthEffect->bindConstantBuffer("ActorBuffer", pActorBuffer);
                     m_gridDepthEffect->bind();
                     std::span<const pyr::SubMesh> submeshes = sm->sourceMesh->getModel()->getRawMeshData()->getSubmeshes();
@@ -479,35 +486,35 @@ namespace pye
                 if (!selectedBillboards.empty())
                 {
                     pyr::BillboardManager::BillboardsRenderData renderData = pyr::BillboardManager::makeContext(selectedBillboards);
-                    m_renderBillboardEffect->bindConstantBuffer("CameraBuffer", pcameraBuffer);
+                    m_billboardEffects.get(BILLBOARD_TEXTURE_AS_DEPTH)->bindConstantBuffer("CameraBuffer", pcameraBuffer);
                     auto result = renderData.textures
                         | std::views::keys
                         | std::views::transform([](auto texPtr) { return *texPtr; });
 
                     std::vector<pyr::Texture> textures(result.begin(), result.end());
-                    m_renderBillboardEffect->bindTextures(textures, "textures");
-                    m_renderBillboardEffect->bind();
+                    m_billboardEffects.get(BILLBOARD_TEXTURE_AS_DEPTH)->bindTextures(textures, "textures");
+                    m_billboardEffects.get(BILLBOARD_TEXTURE_AS_DEPTH)->bind();
                     renderData.instanceBuffer.bind(true);
                     pyr::Engine::d3dcontext().DrawInstanced(6, static_cast<UINT>(renderData.instanceBuffer.getVerticesCount()), 0, 0);
-                    m_renderBillboardEffect->unbindResources();
+                    m_billboardEffects.get(BILLBOARD_TEXTURE_AS_DEPTH)->unbindResources();
                 }
 
                 // -- 2 . Compute outline
-                m_target.unbind();
-                pyr::Texture selectedMeshesDepth = m_target.getTargetAsTexture(pyr::FrameBuffer::DEPTH_STENCIL);
-                m_targetNoDepth.clearTargets();
-                m_targetNoDepth.bind();
+                target.unbind();
+                pyr::Texture selectedMeshesDepth = target.getTargetAsTexture(pyr::FrameBuffer::DEPTH_STENCIL);
+                targetNoDepth.clearTargets();
+                targetNoDepth.bind();
                 m_outlineEffect->bindTexture(selectedMeshesDepth, "selectedMeshesDepth");
-                m_outlineEffect->bindTexture(m_inputs["depthBuffer"].res, "sceneDepth");
+                m_outlineEffect->bindTexture(sceneDepth, "sceneDepth");
                 m_outlineEffect->bind();
                 pyr::Engine::d3dcontext().Draw(3, 0);
                 m_outlineEffect->unbindResources();
-                m_targetNoDepth.unbind();
+                targetNoDepth.unbind();
 
                 // -- 3. Compose scene, outline and depthgrid
 
-                m_composeEffect->bindTexture(m_targetNoDepth.getTargetAsTexture(pyr::FrameBuffer::COLOR_0), "outlineTexture");
-                m_composeEffect->bindTexture(m_target.getTargetAsTexture(pyr::FrameBuffer::COLOR_0), "depthGridTexture");
+                m_composeEffect->bindTexture(targetNoDepth.getTargetAsTexture(pyr::FrameBuffer::COLOR_0), "outlineTexture");
+                m_composeEffect->bindTexture(target.getTargetAsTexture(pyr::FrameBuffer::COLOR_0), "depthGridTexture");
                 m_composeEffect->bind();
                 pyr::Engine::d3dcontext().Draw(3, 0);
                 m_composeEffect->unbindResources();
@@ -9,6 +9,7 @@
 #include "display/FrameBuffer.h"
 #include <unordered_set>
 #include <ranges>
+#include <utility>
 
 #include "display/RenderGraph/RenderPass.h"
 #include "display/GraphicalResource.h"
@@ -69,7 +70,7 @@ namespace pye
                 std::vector<const pyr::Billboard*> bbs;
                 for (auto* editorBB : Editor.WorldHUD)
                 {
-                    editorBB->editorBillboard->transform.position = editorBB->coreActor->GetTransform().position;
+                    editorBB->editorBillboard->transform.position = std::as_const(*editorBB->coreActor).GetTransform().position;
                     bbs.push_back(editorBB->editorBillboard);
                 }
                 pyr::BillboardManager::BillboardsRenderData renderData = pyr::BillboardManager::makeContext(bbs);